@@ -0,0 +1,290 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * helloBPWriteRead_nompi.cpp
+ *
+ * Writes a stepped 2D global array and a large 1D array with NaNs, with and
+ * without a bitmap index, then reads them back with Read, ScheduleRead +
+ * PerformReads and Query, with and without the index cache. Returns nonzero
+ * if any value read back is wrong.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ADIOS_CPP.h"
+
+namespace
+{
+
+const std::size_t Ny = 64;             // global rows
+const std::size_t Nx = 64;             // global columns
+const std::size_t blockRows = 16;      // rows written per block
+const std::size_t steps = 3;           // written and read
+const std::size_t Np = 2097152;        // pressure size, two threaded pieces
+const std::size_t nanIndex = Np / 2;   // first element of the second piece
+const std::size_t highIndex = 1500000; // only value above 1
+const std::size_t lowIndex = 1600000;  // only value below 0
+
+double Temperature(const std::size_t step, const std::size_t i,
+                   const std::size_t j)
+{
+    return static_cast<double>(step * 10000 + i * Nx + j);
+}
+
+void Write(const std::string fileName, const std::string bitmapBins)
+{
+    adios::ADIOS adios(adios::Verbose::WARN, true);
+
+    adios::Variable<double> &ioTemperature = adios.DefineVariable<double>(
+        "temperature", adios::Dims{blockRows, Nx}, adios::Dims{Ny, Nx},
+        adios::Dims{0, 0});
+    adios::Variable<float> &ioPressure = adios.DefineVariable<float>(
+        "pressure", adios::Dims{Np}, adios::Dims{Np}, adios::Dims{0});
+
+    adios::Method &bpWriterSettings = adios.DeclareMethod("Writer");
+    bpWriterSettings.AllowThreads(2); // min/max of pressure in two pieces
+    if (bitmapBins.empty() == false)
+    {
+        bpWriterSettings.SetParameters("bitmap_bins=" + bitmapBins);
+    }
+    bpWriterSettings.AddTransport("File");
+
+    auto bpWriter = adios.Open(fileName, "w", bpWriterSettings);
+    if (bpWriter == nullptr)
+    {
+        throw std::ios_base::failure(
+            "ERROR: couldn't create bpWriter at Open\n");
+    }
+
+    std::vector<float> pressure(Np, 1.f);
+    pressure[nanIndex] = std::numeric_limits<float>::quiet_NaN();
+    pressure[highIndex] = 100.f;
+    pressure[lowIndex] = -5.f;
+
+    std::vector<double> block(blockRows * Nx);
+    for (std::size_t step = 0; step < steps; ++step)
+    {
+        for (std::size_t row = 0; row < Ny; row += blockRows)
+        {
+            for (std::size_t i = 0; i < blockRows; ++i)
+            {
+                for (std::size_t j = 0; j < Nx; ++j)
+                {
+                    block[i * Nx + j] = Temperature(step, row + i, j);
+                }
+            }
+            ioTemperature.m_GlobalOffsets = {row, 0};
+            bpWriter->Write<double>(ioTemperature, block.data());
+        }
+        bpWriter->Write<float>(ioPressure, pressure.data());
+        bpWriter->Advance();
+    }
+    bpWriter->Close();
+}
+
+/** Counts values of temperature in the box that differ from Temperature */
+std::size_t CheckBox(const double *values, const std::size_t step,
+                     const std::size_t startY, const std::size_t startX,
+                     const std::size_t countY, const std::size_t countX)
+{
+    std::size_t errors = 0;
+    for (std::size_t i = 0; i < countY; ++i)
+    {
+        for (std::size_t j = 0; j < countX; ++j)
+        {
+            if (values[i * countX + j] !=
+                Temperature(step, startY + i, startX + j))
+            {
+                ++errors;
+            }
+        }
+    }
+    return errors;
+}
+
+std::size_t Read(const std::string fileName, const std::string indexCache,
+                 const bool hasBitmap)
+{
+    adios::ADIOS adios(adios::Verbose::WARN, true);
+
+    adios::Method &bpReaderSettings = adios.DeclareMethod("Reader");
+    bpReaderSettings.AllowThreads(2); // parallel block reads
+    bpReaderSettings.SetParameters("index_cache=" + indexCache,
+                                   "read_ahead_steps=1");
+    bpReaderSettings.AddTransport("File");
+
+    auto bpReader = adios.Open(fileName, "r", bpReaderSettings);
+    if (bpReader == nullptr)
+    {
+        throw std::ios_base::failure(
+            "ERROR: couldn't create bpReader at Open\n");
+    }
+
+    std::size_t errors = 0;
+    for (std::size_t step = 0; step < steps; ++step)
+    {
+        adios::Variable<double> *temperature =
+            bpReader->InquireVariableDouble("temperature", false);
+        adios::Variable<float> *pressure =
+            bpReader->InquireVariableFloat("pressure", false);
+        if (temperature == nullptr || pressure == nullptr)
+        {
+            throw std::invalid_argument("ERROR: variables not found in " +
+                                        fileName + "\n");
+        }
+
+        // Read into application memory, box across two blocks
+        std::vector<double> box(30 * 40);
+        temperature->SetSelection(
+            adios::SelectionBoundingBox({10, 5}, {30, 40}));
+        bpReader->Read<double>(*temperature, box.data());
+        errors += CheckBox(box.data(), step, 10, 5, 30, 40);
+
+        // Read into the engine buffer
+        temperature->SetSelection(
+            adios::SelectionBoundingBox({0, 0}, {Ny, Nx}));
+        bpReader->Read<double>(*temperature);
+        errors += CheckBox(temperature->m_AppValues, step, 0, 0, Ny, Nx);
+
+        // Two scheduled reads in one batch, application and engine memory
+        std::vector<double> rows(8 * Nx);
+        temperature->SetSelection(
+            adios::SelectionBoundingBox({20, 0}, {8, Nx}));
+        bpReader->ScheduleRead<double>(*temperature, rows.data());
+        temperature->SetSelection(
+            adios::SelectionBoundingBox({33, 1}, {20, Nx - 2}));
+        bpReader->ScheduleRead<double>(*temperature,
+                                       static_cast<const double *>(nullptr));
+        bpReader->PerformReads(adios::BLOCKINGREAD);
+        errors += CheckBox(rows.data(), step, 20, 0, 8, Nx);
+        errors += CheckBox(temperature->m_AppValues, step, 33, 1, 20, Nx - 2);
+
+        // Query points in range, partially covering blocks 0 and 1
+        const double lo = Temperature(step, 15, 0);
+        const double hi = Temperature(step, 16, Nx - 1);
+        temperature->SetSelection(
+            adios::SelectionBoundingBox({0, 0}, {Ny, Nx}));
+        adios::QueryResult points = bpReader->Query(*temperature, lo, hi);
+        std::vector<std::uint64_t> expected;
+        for (std::size_t i = 0; i < Ny; ++i)
+        {
+            for (std::size_t j = 0; j < Nx; ++j)
+            {
+                const double value = Temperature(step, i, j);
+                if (value >= lo && value <= hi)
+                {
+                    expected.push_back(i);
+                    expected.push_back(j);
+                }
+            }
+        }
+        if (points.Ndim != 2 || points.Points != expected ||
+            points.Count != expected.size() / 2 ||
+            points.Blocks != Ny / blockRows)
+        {
+            std::cout << "ERROR: temperature Query points, step " << step
+                      << "\n";
+            ++errors;
+        }
+        if ((hasBitmap == true && points.IndexedBlocks == 0) ||
+            (hasBitmap == false && points.IndexedBlocks != 0))
+        {
+            std::cout << "ERROR: temperature Query indexed "
+                      << points.IndexedBlocks << " blocks, step " << step
+                      << "\n";
+            ++errors;
+        }
+
+        adios::QueryResult boxes = bpReader->Query(
+            *temperature, lo, hi, adios::SelectionType::BoundingBox);
+        if (boxes.Count != points.Count || boxes.Boxes.size() != 2 ||
+            boxes.Boxes[0].m_Start != adios::Dims{15, 0} ||
+            boxes.Boxes[0].m_Count != adios::Dims{1, Nx} ||
+            boxes.Boxes[1].m_Start != adios::Dims{16, 0} ||
+            boxes.Boxes[1].m_Count != adios::Dims{1, Nx})
+        {
+            std::cout << "ERROR: temperature Query boxes, step " << step
+                      << "\n";
+            ++errors;
+        }
+
+        // pressure min/max must skip the NaN seeding the second piece
+        pressure->SetSelection(adios::SelectionBoundingBox({0}, {Np}));
+        adios::QueryResult high = bpReader->Query(*pressure, 50.f, 200.f);
+        adios::QueryResult low = bpReader->Query(*pressure, -10.f, -1.f);
+        if (high.Points != std::vector<std::uint64_t>{highIndex} ||
+            low.Points != std::vector<std::uint64_t>{lowIndex})
+        {
+            std::cout << "ERROR: pressure Query, step " << step << "\n";
+            ++errors;
+        }
+
+        bpReader->Advance();
+    }
+    bpReader->Close();
+    return errors;
+}
+
+} // end anonymous namespace
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+    std::size_t errors = 0;
+
+    try
+    {
+        Write("myTemperature_nompi.bp", "");
+        Write("myTemperatureBitmap_nompi.bp", "16");
+
+        for (const std::string fileName :
+             {"myTemperature_nompi.bp", "myTemperatureBitmap_nompi.bp"})
+        {
+            const bool hasBitmap = (fileName == "myTemperatureBitmap_nompi.bp");
+            std::remove((fileName + ".cache").c_str());
+
+            errors += Read(fileName, "no", hasBitmap);
+            errors += Read(fileName, "yes", hasBitmap); // builds the cache
+            if (std::ifstream(fileName + ".cache").good() == false)
+            {
+                std::cout << "ERROR: no index cache for " << fileName << "\n";
+                ++errors;
+            }
+            errors += Read(fileName, "yes", hasBitmap); // uses the cache
+        }
+    }
+    catch (std::invalid_argument &e)
+    {
+        std::cout << "Invalid argument exception, STOPPING PROGRAM\n";
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+    catch (std::ios_base::failure &e)
+    {
+        std::cout << "System exception, STOPPING PROGRAM\n";
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << "Exception, STOPPING PROGRAM\n";
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+
+    if (errors > 0)
+    {
+        std::cout << errors << " errors reading back written values\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -12,6 +12,9 @@
 #define STLVECTOR_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <memory>  //std::allocator
+#include <new>     //placement new
+#include <utility> //std::forward
 #include <vector>
 /// \endcond
 
@@ -22,6 +25,45 @@ namespace adios
 namespace capsule
 {
 
+/**
+ * Allocator that default-initializes elements instead of value-initializing
+ * them, resize leaves new chars unset so payloads are written only once
+ */
+template <class T>
+class DefaultInitAllocator : public std::allocator<T>
+{
+
+public:
+    template <class U>
+    struct rebind
+    {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    DefaultInitAllocator() = default;
+
+    template <class U>
+    DefaultInitAllocator(const DefaultInitAllocator<U> &other) noexcept
+    : std::allocator<T>(other)
+    {
+    }
+
+    template <class U>
+    void construct(U *pointer)
+    {
+        ::new (static_cast<void *>(pointer)) U;
+    }
+
+    template <class U, class... Args>
+    void construct(U *pointer, Args &&... args)
+    {
+        ::new (static_cast<void *>(pointer)) U(std::forward<Args>(args)...);
+    }
+};
+
+/** Data buffer type, bytes added by resize are not zeroed */
+using HeapBuffer = std::vector<char, DefaultInitAllocator<char>>;
+
 /**
  * Data and Metadata buffers are allocated in the Heap
  */
@@ -29,12 +71,23 @@ class STLVector : public Capsule
 {
 
 public:
-    std::vector<char> m_Data; ///< data buffer allocated using the STL in heap
-                              /// memory, default size = 16 Mb
+    HeapBuffer m_Data; ///< data buffer allocated using the STL in heap
+                       /// memory, default size = 16 Mb, resize does not zero
     std::vector<char>
         m_Metadata; ///< metadata buffer allocated using the STL in
                     /// heap memory, default size = 100 Kb
 
+    /** Payload left in application memory (deferred write), it follows the
+     * first Position bytes of m_Data in the output */
+    struct Extent
+    {
+        std::size_t Position; ///< position in m_Data at time of Write
+        const char *Data;     ///< application memory, not owned
+        std::size_t Size;     ///< bytes
+    };
+
+    std::vector<Extent> m_Extents; ///< deferred payloads, in output order
+
     /**
      * Unique constructor
      * @param accessMode read, write or append
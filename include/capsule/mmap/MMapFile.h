@@ -0,0 +1,80 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * MMapFile.h read only capsule, the data buffer is a file mapped in memory
+ *
+ *  Created on: May 1, 2017
+ *      Author: wfg
+ */
+
+#ifndef MMAPFILE_H_
+#define MMAPFILE_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <string>
+/// \endcond
+
+#include "core/Capsule.h"
+
+namespace adios
+{
+namespace capsule
+{
+
+/**
+ * Data buffer is a whole file mapped read only with mmap, pages are loaded on
+ * first access. Pointers into the data buffer are valid until destruction.
+ */
+class MMapFile : public Capsule
+{
+
+public:
+    /**
+     * Maps fileName, an empty file has no mapping (data is nullptr)
+     * @param accessMode only "r" or "read"
+     * @param rankMPI MPI rank
+     * @param fileName file to be mapped
+     * @param debugMode true: throws if the file can't be mapped, false: the
+     * capsule is left empty
+     */
+    MMapFile(std::string accessMode, int rankMPI, const std::string &fileName,
+             bool debugMode = false);
+
+    ~MMapFile();
+
+    MMapFile(const MMapFile &) = delete;
+    MMapFile &operator=(const MMapFile &) = delete;
+
+    char *GetData();     ///< start of the mapping, read only
+    char *GetMetadata(); ///< no separate metadata buffer, nullptr
+
+    std::size_t GetDataSize() const;     ///< file size at construction
+    std::size_t GetMetadataSize() const; ///< zero
+
+    /**
+     * Asks the kernel to start reading a range of the file as one request
+     * (madvise WILLNEED), does not wait for the pages
+     * @param offset range start in the file
+     * @param size range bytes, clipped to the file size
+     */
+    void Prefetch(const std::size_t offset, const std::size_t size) noexcept;
+
+    /**
+     * Prefetches a range and waits until it is resident, by reading a byte
+     * of each page
+     * @param offset range start in the file
+     * @param size range bytes, clipped to the file size
+     */
+    void Load(const std::size_t offset, const std::size_t size) noexcept;
+
+private:
+    const std::string m_FileName;
+    char *m_Data = nullptr; ///< mapping, nullptr if empty or failed
+    std::size_t m_DataSize = 0;
+};
+
+} // end namespace capsule
+} // end namespace adios
+
+#endif /* MMAPFILE_H_ */
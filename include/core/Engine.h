@@ -13,6 +13,7 @@
 
 /// \cond EXCLUDE_FROM_DOXYGEN
 #include <complex> //std::complex
+#include <functional> //std::function
 #include <map>
 #include <memory> //std::shared_ptr
 #include <string>
@@ -31,6 +32,7 @@
 #include "core/Transport.h"
 #include "core/Variable.h"
 #include "core/VariableCompound.h"
+#include "selection/QueryResult.h"
 
 namespace adios
 {
@@ -306,7 +308,32 @@ public:
         Read(variableName, nullptr);
     }
 
+    virtual void Read(Variable<char> &variable, const char *values);
+    virtual void Read(Variable<unsigned char> &variable,
+                      const unsigned char *values);
+    virtual void Read(Variable<short> &variable, const short *values);
+    virtual void Read(Variable<unsigned short> &variable,
+                      const unsigned short *values);
+    virtual void Read(Variable<int> &variable, const int *values);
+    virtual void Read(Variable<unsigned int> &variable,
+                      const unsigned int *values);
+    virtual void Read(Variable<long int> &variable, const long int *values);
+    virtual void Read(Variable<unsigned long int> &variable,
+                      const unsigned long int *values);
+    virtual void Read(Variable<long long int> &variable,
+                      const long long int *values);
+    virtual void Read(Variable<unsigned long long int> &variable,
+                      const unsigned long long int *values);
+    virtual void Read(Variable<float> &variable, const float *values);
     virtual void Read(Variable<double> &variable, const double *values);
+    virtual void Read(Variable<long double> &variable,
+                      const long double *values);
+    virtual void Read(Variable<std::complex<float>> &variable,
+                      const std::complex<float> *values);
+    virtual void Read(Variable<std::complex<double>> &variable,
+                      const std::complex<double> *values);
+    virtual void Read(Variable<std::complex<long double>> &variable,
+                      const std::complex<long double> *values);
 
     /**
      * Read function that adds static checking on the variable to be passed by
@@ -370,7 +397,34 @@ public:
      */
     void ScheduleRead() { ScheduleRead(nullptr, nullptr); }
 
-    virtual void ScheduleRead(Variable<double> &variable, const double *values);
+    virtual void ScheduleRead(Variable<char> &variable, const char *values);
+    virtual void ScheduleRead(Variable<unsigned char> &variable,
+                              const unsigned char *values);
+    virtual void ScheduleRead(Variable<short> &variable, const short *values);
+    virtual void ScheduleRead(Variable<unsigned short> &variable,
+                              const unsigned short *values);
+    virtual void ScheduleRead(Variable<int> &variable, const int *values);
+    virtual void ScheduleRead(Variable<unsigned int> &variable,
+                              const unsigned int *values);
+    virtual void ScheduleRead(Variable<long int> &variable,
+                              const long int *values);
+    virtual void ScheduleRead(Variable<unsigned long int> &variable,
+                              const unsigned long int *values);
+    virtual void ScheduleRead(Variable<long long int> &variable,
+                              const long long int *values);
+    virtual void ScheduleRead(Variable<unsigned long long int> &variable,
+                              const unsigned long long int *values);
+    virtual void ScheduleRead(Variable<float> &variable, const float *values);
+    virtual void ScheduleRead(Variable<double> &variable,
+                              const double *values);
+    virtual void ScheduleRead(Variable<long double> &variable,
+                              const long double *values);
+    virtual void ScheduleRead(Variable<std::complex<float>> &variable,
+                              const std::complex<float> *values);
+    virtual void ScheduleRead(Variable<std::complex<double>> &variable,
+                              const std::complex<double> *values);
+    virtual void ScheduleRead(Variable<std::complex<long double>> &variable,
+                              const std::complex<long double> *values);
 
     /**
      * Perform all scheduled reads, either blocking until all reads completed,
@@ -378,7 +432,67 @@ public:
      * return immediately.
      * @param mode Blocking or non-blocking modes
      */
-    void PerformReads(PerformReadMode mode);
+    virtual void PerformReads(PerformReadMode mode);
+
+    /**
+     * Query function that adds static checking on the range type, the
+     * result is a points selection
+     * @param variable from InquireVariable, selection from SetSelection
+     * @param lo lower bound of values
+     * @param hi upper bound of values
+     * @return elements with values in [lo, hi]
+     */
+    template <class T>
+    QueryResult Query(Variable<T> &variable, const T lo, const T hi)
+    {
+        return Query(variable, lo, hi, SelectionType::Points);
+    }
+
+    /**
+     * Finds the elements of the variable selection in the current step with
+     * values in the closed range [lo, hi]
+     * @param variable from InquireVariable, selection from SetSelection
+     * @param lo lower bound of values
+     * @param hi upper bound of values
+     * @param type SelectionType::Points for the coordinates of each element,
+     * SelectionType::BoundingBox for a box around the elements of each block
+     * @return elements with values in [lo, hi], empty if not supported
+     */
+    virtual QueryResult Query(Variable<char> &variable, const char lo,
+                              const char hi, const SelectionType type);
+    virtual QueryResult Query(Variable<unsigned char> &variable,
+                              const unsigned char lo, const unsigned char hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<short> &variable, const short lo,
+                              const short hi, const SelectionType type);
+    virtual QueryResult Query(Variable<unsigned short> &variable,
+                              const unsigned short lo, const unsigned short hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<int> &variable, const int lo,
+                              const int hi, const SelectionType type);
+    virtual QueryResult Query(Variable<unsigned int> &variable,
+                              const unsigned int lo, const unsigned int hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<long int> &variable, const long int lo,
+                              const long int hi, const SelectionType type);
+    virtual QueryResult Query(Variable<unsigned long int> &variable,
+                              const unsigned long int lo,
+                              const unsigned long int hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<long long int> &variable,
+                              const long long int lo, const long long int hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<unsigned long long int> &variable,
+                              const unsigned long long int lo,
+                              const unsigned long long int hi,
+                              const SelectionType type);
+    virtual QueryResult Query(Variable<float> &variable, const float lo,
+                              const float hi, const SelectionType type);
+    virtual QueryResult Query(Variable<double> &variable, const double lo,
+                              const double hi, const SelectionType type);
+    virtual QueryResult Query(Variable<long double> &variable,
+                              const long double lo, const long double hi,
+                              const SelectionType type);
 
     /**
      * Reader application indicates that no more data will be read from the
@@ -0,0 +1,81 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * IOThread.h background thread running I/O tasks in submission order, tasks
+ * are passed through a single-producer single-consumer lock-free ring
+ *
+ *  Created on: Apr 27, 2017
+ *      Author: wfg
+ */
+
+#ifndef IOTHREAD_H_
+#define IOTHREAD_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+/// \endcond
+
+namespace adios
+{
+
+class IOThread
+{
+
+public:
+    /**
+     * Starts the background thread
+     * @param capacity maximum number of queued tasks, Push blocks when full
+     */
+    IOThread(const std::size_t capacity = 16);
+
+    /** Runs all queued tasks and joins the background thread */
+    ~IOThread();
+
+    IOThread(const IOThread &) = delete;
+    IOThread &operator=(const IOThread &) = delete;
+
+    /**
+     * Queues a task and returns immediately, unless the ring is full. Must be
+     * called from a single (producer) thread.
+     * @param task runs in the background thread
+     */
+    void Push(std::function<void()> task);
+
+    /**
+     * Blocks until all queued tasks are completed. Rethrows the first
+     * exception thrown by a task since the last Wait.
+     */
+    void Wait();
+
+    /** @return true if no queued tasks are pending, does not block */
+    bool IsIdle() const noexcept;
+
+private:
+    std::vector<std::function<void()>> m_Tasks; ///< ring of tasks
+    std::atomic<std::size_t> m_Head; ///< next task to run, consumer owned
+    std::atomic<std::size_t> m_Tail; ///< next free slot, producer owned
+
+    /** only used to sleep when the ring is empty (consumer) or full and at
+     * Wait (producer), never while accessing the ring */
+    std::mutex m_Mutex;
+    std::condition_variable m_Work; ///< wakes up the consumer
+    std::condition_variable m_Done; ///< wakes up the producer
+    bool m_Stop = false;            ///< protected by m_Mutex
+    std::exception_ptr m_Exception; ///< protected by m_Mutex
+
+    std::thread m_Thread; ///< initialized last, uses all the above
+
+    /** Background thread loop */
+    void Run();
+};
+
+} // end namespace adios
+
+#endif /* IOTHREAD_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * ThreadPool.h fixed set of worker threads running independent tasks, the
+ * calling thread joins the workers while it waits
+ *
+ *  Created on: May 3, 2017
+ *      Author: wfg
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+/// \endcond
+
+namespace adios
+{
+
+class ThreadPool
+{
+
+public:
+    /**
+     * Starts threads - 1 workers
+     * @param threads maximum number of threads running tasks, including the
+     * thread calling Wait
+     */
+    ThreadPool(const unsigned int threads);
+
+    /** Discards queued tasks, waits for running tasks and joins workers */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Queues a task, tasks may run in any order and concurrently
+     * @param task runs in a worker or in the thread calling Wait
+     */
+    void Push(std::function<void()> task);
+
+    /**
+     * Runs queued tasks in the calling thread too, and blocks until all are
+     * completed. Rethrows the first exception thrown by a task since the last
+     * Wait.
+     */
+    void Wait();
+
+    /** @return number of threads running tasks, including the caller */
+    unsigned int GetThreads() const noexcept;
+
+private:
+    std::deque<std::function<void()>> m_Tasks; ///< queued, not started
+    std::size_t m_Running = 0;                 ///< started, not completed
+
+    std::mutex m_Mutex;             ///< protects all members above and below
+    std::condition_variable m_Work; ///< wakes up workers
+    std::condition_variable m_Done; ///< wakes up Wait
+    bool m_Stop = false;
+    std::exception_ptr m_Exception;
+
+    std::vector<std::thread> m_Workers; ///< initialized last
+
+    /** Worker loop */
+    void Run();
+
+    /**
+     * Runs the front task without holding the lock
+     * @param lock on m_Mutex, held on entry and exit
+     */
+    void RunTask(std::unique_lock<std::mutex> &lock);
+};
+
+} // end namespace adios
+
+#endif /* THREADPOOL_H_ */
@@ -14,6 +14,8 @@
 /// \cond EXCLUDE_FROM_DOXYGEN
 #include <string>
 #include <vector>
+
+#include <sys/uio.h> //iovec
 /// \endcond
 
 #include "ADIOS_MPI.h"
@@ -70,6 +72,14 @@ public:
      */
     virtual void Write(const char *buffer, std::size_t size) = 0;
 
+    /**
+     * Gather write of several buffers in order, as a single contiguous write.
+     * Default calls Write for each buffer.
+     * @param iov buffers to be written
+     * @param iovcnt number of buffers
+     */
+    virtual void WriteV(const iovec *iov, const int iovcnt);
+
     virtual void
     Flush(); ///< flushes current contents to physical medium without
              /// closing the transport
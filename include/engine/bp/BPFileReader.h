@@ -11,12 +11,28 @@
 #ifndef BPFILEREADER_H_
 #define BPFILEREADER_H_
 
-#include <iostream> //this must go away
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm>  //std::min, std::max
+#include <cstdint>    //std::uintptr_t
+#include <cstring>    //std::memcpy
+#include <functional> //std::function
+#include <map>
+#include <memory>      //std::unique_ptr
+#include <stdexcept>   //std::invalid_argument
+#include <type_traits> //std::is_integral
+/// \endcond
 
 #include "core/Engine.h"
+#include "core/IOThread.h"
+#include "core/ThreadPool.h"
+#include "format/BP1Reader.h"
+#include "functions/adiosFunctions.h" //IsContiguousInBlock, CopyIntersection
+#include "functions/adiosSIMD.h"      //GetInRange
+#include "functions/adiosTemplates.h" //GetBin
 
 // supported capsules
 #include "capsule/heap/STLVector.h"
+#include "capsule/mmap/MMapFile.h"
 
 namespace adios
 {
@@ -87,20 +103,374 @@ public:
     VariableCompound *InquireVariableCompound(const std::string name,
                                               const bool readIn = true);
 
+    /**
+     * Reads the variable selection in the current step. If values is nullptr
+     * and the selection is a contiguous range of a single untransformed
+     * block, variable.m_AppValues points into the mapped file (no copy),
+     * valid until Close. Otherwise values are copied to values, or to an
+     * engine buffer pointed by variable.m_AppValues if values is nullptr.
+     * @param variable from InquireVariable, selection from SetSelection
+     * @param values user memory for the selection, or nullptr
+     */
+    void Read(Variable<char> &variable, const char *values);
+    void Read(Variable<unsigned char> &variable, const unsigned char *values);
+    void Read(Variable<short> &variable, const short *values);
+    void Read(Variable<unsigned short> &variable,
+              const unsigned short *values);
+    void Read(Variable<int> &variable, const int *values);
+    void Read(Variable<unsigned int> &variable, const unsigned int *values);
+    void Read(Variable<long int> &variable, const long int *values);
+    void Read(Variable<unsigned long int> &variable,
+              const unsigned long int *values);
+    void Read(Variable<long long int> &variable, const long long int *values);
+    void Read(Variable<unsigned long long int> &variable,
+              const unsigned long long int *values);
+    void Read(Variable<float> &variable, const float *values);
+    void Read(Variable<double> &variable, const double *values);
+    void Read(Variable<long double> &variable, const long double *values);
+    void Read(Variable<std::complex<float>> &variable,
+              const std::complex<float> *values);
+    void Read(Variable<std::complex<double>> &variable,
+              const std::complex<double> *values);
+    void Read(Variable<std::complex<long double>> &variable,
+              const std::complex<long double> *values);
+
+    /**
+     * Queues a read of the variable selection in the current step, values
+     * are available after PerformReads. Unlike Read, values read without user
+     * memory are always copied to an engine buffer.
+     * @param variable from InquireVariable, selection from SetSelection
+     * @param values user memory for the selection, or nullptr
+     */
+    void ScheduleRead(Variable<char> &variable, const char *values);
+    void ScheduleRead(Variable<unsigned char> &variable,
+                      const unsigned char *values);
+    void ScheduleRead(Variable<short> &variable, const short *values);
+    void ScheduleRead(Variable<unsigned short> &variable,
+                      const unsigned short *values);
+    void ScheduleRead(Variable<int> &variable, const int *values);
+    void ScheduleRead(Variable<unsigned int> &variable,
+                      const unsigned int *values);
+    void ScheduleRead(Variable<long int> &variable, const long int *values);
+    void ScheduleRead(Variable<unsigned long int> &variable,
+                      const unsigned long int *values);
+    void ScheduleRead(Variable<long long int> &variable,
+                      const long long int *values);
+    void ScheduleRead(Variable<unsigned long long int> &variable,
+                      const unsigned long long int *values);
+    void ScheduleRead(Variable<float> &variable, const float *values);
+    void ScheduleRead(Variable<double> &variable, const double *values);
+    void ScheduleRead(Variable<long double> &variable,
+                      const long double *values);
+    void ScheduleRead(Variable<std::complex<float>> &variable,
+                      const std::complex<float> *values);
+    void ScheduleRead(Variable<std::complex<double>> &variable,
+                      const std::complex<double> *values);
+    void ScheduleRead(Variable<std::complex<long double>> &variable,
+                      const std::complex<long double> *values);
+
+    /**
+     * Performs all scheduled reads: block payloads are sorted by file and
+     * offset, ranges closer than Method parameter read_gap_KB are requested
+     * from the file as one extent, then blocks are scattered to the
+     * selections. Reads are complete on return in both modes.
+     * @param mode
+     */
+    void PerformReads(PerformReadMode mode);
+
+    /**
+     * Finds the elements of the variable selection in the current step with
+     * values in [lo, hi]. Blocks whose metadata min and max can't be in the
+     * range are skipped without reading them, the others are scanned with
+     * GetInRange, concurrently if Method AllowThreads is more than 1.
+     * @param variable from InquireVariable, selection from SetSelection
+     * @param lo lower bound of values
+     * @param hi upper bound of values
+     * @param type SelectionType::Points or SelectionType::BoundingBox
+     * @return elements with values in [lo, hi]
+     */
+    QueryResult Query(Variable<char> &variable, const char lo, const char hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<unsigned char> &variable,
+                      const unsigned char lo, const unsigned char hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<short> &variable, const short lo,
+                      const short hi, const SelectionType type);
+    QueryResult Query(Variable<unsigned short> &variable,
+                      const unsigned short lo, const unsigned short hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<int> &variable, const int lo, const int hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<unsigned int> &variable, const unsigned int lo,
+                      const unsigned int hi, const SelectionType type);
+    QueryResult Query(Variable<long int> &variable, const long int lo,
+                      const long int hi, const SelectionType type);
+    QueryResult Query(Variable<unsigned long int> &variable,
+                      const unsigned long int lo, const unsigned long int hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<long long int> &variable,
+                      const long long int lo, const long long int hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<unsigned long long int> &variable,
+                      const unsigned long long int lo,
+                      const unsigned long long int hi,
+                      const SelectionType type);
+    QueryResult Query(Variable<float> &variable, const float lo,
+                      const float hi, const SelectionType type);
+    QueryResult Query(Variable<double> &variable, const double lo,
+                      const double hi, const SelectionType type);
+    QueryResult Query(Variable<long double> &variable, const long double lo,
+                      const long double hi, const SelectionType type);
+
+    /**
+     * Moves to the next time step in the file. With Method parameter
+     * read_ahead_steps, selections read in the previous step are fetched in
+     * the background for the next steps.
+     */
+    void Advance(float timeout_sec = 0.0);
+
+    /** Unmaps all files, values read without user memory become invalid */
     void Close(const int transportIndex = -1);
 
 private:
     capsule::STLVector
         m_Buffer; ///< heap capsule, contains data and metadata buffers
-    // format::BP1Writer m_BP1Writer; ///< format object will provide the
-    // required
-    // BP functionality to be applied on m_Buffer and m_Transports
+
+    format::BP1Reader m_BP1Reader; ///< parses metadata
+    format::BP1ReadMetadataSet m_MetadataSet; ///< indices of m_MetadataFile
+
+    /** global metadata file name.bp/name.bp.idx or, if missing, the first
+     * rank file footer */
+    std::unique_ptr<capsule::MMapFile> m_MetadataFile;
+
+    /** data (sub)files mapped on first read, key: file index */
+    std::map<std::uint32_t, std::unique_ptr<capsule::MMapFile>> m_DataFiles;
+
+    std::size_t m_CurrentStep = 0; ///< index in m_MetadataSet.TimeSteps
+
+    /** variables defined in ADIOS by InquireVariable, key: name */
+    std::map<std::string, VariableBase *> m_Variables;
+
+    /** values of reads without user memory that can't be mapped views,
+     * key: variable name */
+    std::map<std::string, std::vector<char>> m_ReadBuffers;
+
+    /** read queued by ScheduleRead */
+    struct ScheduledRead
+    {
+        std::string Name;            ///< variable name, key in m_ReadBuffers
+        char *Values;                ///< user memory, nullptr: engine buffer
+        bool IsEngineBuffer = false; ///< true: values are copied to Buffer
+        std::vector<char> Buffer;    ///< engine buffer of this read only
+        Dims Start;                  ///< selection global offsets
+        Dims Count;                  ///< selection dimensions
+        std::size_t Size;            ///< selection bytes
+        std::size_t ElementSize;
+        std::function<void(const char *)> SetAppValues; ///< variable values
+    };
+
+    /** block intersecting a scheduled read selection */
+    struct ScheduledBlock
+    {
+        const format::BP1Block *Block;
+        std::size_t PayloadSize; ///< whole block payload bytes
+        std::uint64_t Begin;     ///< first selected byte in the file
+        std::uint64_t End;       ///< past the last selected byte in the file
+        std::size_t Read;        ///< index in m_ScheduledReads
+    };
+
+    /** block payload to be copied into a selection */
+    struct BlockCopy
+    {
+        const char *Payload;            ///< mapped block payload
+        const format::BP1Block *Block;
+        char *Destination;              ///< first selection element
+        const Dims *Start;              ///< selection global offsets
+        const Dims *Count;              ///< selection dimensions
+        std::size_t ElementSize;
+    };
+
+    /** block intersecting a query selection and its elements in range */
+    struct QueryBlock
+    {
+        const format::BP1Block *Block;
+        const char *Payload; ///< mapped block payload, nullptr: all in range
+        bool UseBitmap;      ///< true: resolved with the block bitmap index
+        Dims Start;          ///< intersection global offsets
+        Dims Count;          ///< intersection dimensions
+        std::size_t Hits;    ///< elements in range
+        std::vector<std::uint64_t> Points; ///< coordinates of elements
+        Dims BoxFirst; ///< box around elements, first global coordinates
+        Dims BoxLast;  ///< box around elements, last global coordinates
+    };
+
+    /** copies blocks concurrently if Method AllowThreads is more than 1 */
+    std::unique_ptr<ThreadPool> m_ThreadPool;
+
+    std::vector<ScheduledRead> m_ScheduledReads;
+    std::vector<ScheduledBlock> m_ScheduledBlocks;
+
+    /** scheduled payloads closer than this are requested as one extent,
+     * from Method parameter read_gap_KB */
+    std::size_t m_ReadGap = 1048576;
+
+    /** true: use or build the index cache name.bp.cache, from Method
+     * parameter index_cache */
+    bool m_IndexCache = false;
+
+    /** contiguous range of a data file */
+    struct Extent
+    {
+        std::uint32_t FileIndex;
+        std::uint64_t Begin;
+        std::uint64_t End; ///< past the last byte
+    };
+
+    /** selection of a variable read in the current step, repeated in the
+     * next steps by read-ahead */
+    struct ReadPattern
+    {
+        bool IsLocal; ///< local variables read their first block
+        Dims Start;
+        Dims Count;
+        std::size_t ElementSize;
+    };
+
+    /** background fetch of the next steps, Method parameter
+     * read_ahead_steps, nullptr if off */
+    std::unique_ptr<IOThread> m_ReadAhead;
+    std::size_t m_ReadAheadSteps = 0;
+    /** bytes of steps ahead of the current step queued for read-ahead, from
+     * Method parameter read_ahead_MB */
+    std::size_t m_ReadAheadMaxSize = 134217728;
+    std::map<std::string, ReadPattern> m_ReadPattern; ///< key: variable name
+    /** bytes queued for each step index ahead of m_CurrentStep */
+    std::map<std::size_t, std::size_t> m_ReadAheadSizes;
 
     void Init(); ///< calls InitCapsules and InitTransports based on Method,
                  /// called from constructor
-    void InitCapsules();
+    void InitParameters(); ///< from Method parameters
+    void InitCapsules(); ///< maps the metadata file and parses its indices
     void InitTransports(); ///< from Transports
 
+    /**
+     * Maps the index cache and sets m_MetadataSet from it if its sources are
+     * unchanged
+     * @param cacheName index cache file
+     * @param metadataFileName metadata file the cache was built from
+     * @return false: no valid cache, nothing is changed
+     */
+    bool OpenIndexCache(const std::string &cacheName,
+                        const std::string &metadataFileName);
+
+    /**
+     * Decodes all variable indices and saves them as the index cache, the
+     * cache is written to a temporary file and renamed. Failures only mean
+     * there is no cache for the next open.
+     * @param cacheName index cache file
+     * @param metadataFileName metadata file in m_MetadataSet
+     */
+    void SaveIndexCache(const std::string &cacheName,
+                        const std::string &metadataFileName);
+
+    /**
+     * Current size and modification time of a file
+     * @param fileName
+     * @param source output, only Size and Modified* are set
+     * @return false: file can't be stat'ed
+     */
+    bool GetCacheSource(const std::string &fileName,
+                        format::BP1CacheSource &source) const;
+
+    /** @return name.bp/name.bp.fileIndex */
+    std::string GetDataFileName(const std::uint32_t fileIndex) const;
+
+    /**
+     * Returns a mapped data (sub)file, maps it on first call
+     * @param fileIndex from block metadata
+     * @return mapped file
+     */
+    capsule::MMapFile &GetDataFile(const std::uint32_t fileIndex);
+
+    /**
+     * Returns the payload of a block in its mapped data file, maps the file
+     * on first call
+     * @param block from metadata
+     * @param payloadSize block payload bytes
+     * @return start of the block payload, nullptr if outside its file
+     */
+    const char *GetPayload(const format::BP1Block &block,
+                           const std::size_t payloadSize);
+
+    /**
+     * Payload bytes of a block holding its intersection with a selection,
+     * from the first to the last selected element
+     * @param block
+     * @param start selection global offsets
+     * @param count selection dimensions
+     * @param elementSize
+     * @param begin output, file offset of the first selected element
+     * @param end output, file offset past the last selected element
+     * @return false: block and selection don't intersect
+     */
+    bool GetSelectedBytes(const format::BP1Block &block, const Dims &start,
+                          const Dims &count, const std::size_t elementSize,
+                          std::uint64_t &begin, std::uint64_t &end) const;
+
+    /**
+     * Sorts extents by file and offset, and merges extents of the same file
+     * closer than m_ReadGap
+     * @param extents input, merged on output
+     */
+    void CoalesceExtents(std::vector<Extent> &extents) const;
+
+    /**
+     * Queues the read pattern extents of the steps after the current step,
+     * up to m_ReadAheadSteps steps and m_ReadAheadMaxSize bytes, to the
+     * read-ahead thread. Returns without waiting.
+     */
+    void ReadAhead();
+
+    /**
+     * Copies the intersection of each block with its selection. With a
+     * thread pool, blocks are split in slabs along their first dimension
+     * and copied (and faulted in from their files) concurrently.
+     * @param copies payloads already mapped with GetPayload
+     */
+    void CopyBlocks(const std::vector<BlockCopy> &copies);
+
+    /**
+     * Intersection of a block with a selection
+     * @param block
+     * @param start selection global offsets
+     * @param count selection dimensions
+     * @param intersectionStart output, global offsets
+     * @param intersectionCount output, dimensions
+     * @return false: block and selection don't intersect
+     */
+    bool GetIntersection(const format::BP1Block &block, const Dims &start,
+                         const Dims &count, Dims &intersectionStart,
+                         Dims &intersectionCount) const;
+
+    /**
+     * Moves the elements in range of each block to a query result
+     * @param queries scanned blocks, in block order
+     * @param result output, Count, Points and Boxes are appended
+     */
+    void GetQueryResult(std::vector<QueryBlock> &queries,
+                        QueryResult &result) const;
+
+    /**
+     * Block global offsets, zeros for local variable blocks
+     * @param block
+     * @param dimensions of the selection
+     */
+    Dims GetBlockStart(const format::BP1Block &block,
+                       const std::size_t dimensions) const;
+
+    /** @return current time step in metadata, 0 if past the last step */
+    std::uint32_t GetCurrentTimeStep() const noexcept;
+
     std::string
     GetMdtmParameter(const std::string parameter,
                      const std::map<std::string, std::string> &mdtmParameters);
@@ -109,14 +479,601 @@ private:
     Variable<T> *InquireVariableCommon(const std::string name,
                                        const bool readIn)
     {
-        std::cout << "Hello BPReaderCommon\n";
-
-        // here read variable metadata (dimensions, type, etc.)...then create a
-        // Variable like below:
-        // Variable<T>& variable = m_ADIOS.DefineVariable<T>( m_Name + "/" +
-        // name, )
-        // return &variable; //return address if success
-        return nullptr; // on failure
+        const format::BP1VarIndex *varIndex =
+            m_BP1Reader.GetVarIndex(name, m_MetadataSet);
+        if (varIndex == nullptr || varIndex->Blocks.empty())
+        {
+            return nullptr;
+        }
+
+        if (m_BP1Reader.IsDataType<T>(varIndex->DataType) == false)
+        {
+            if (m_DebugMode == true)
+            {
+                throw std::invalid_argument(
+                    "ERROR: variable " + name + " is not of type " +
+                    GetType<T>() + ", in call to InquireVariable in " +
+                    m_Name + m_EndMessage);
+            }
+            return nullptr;
+        }
+
+        Variable<T> *variable = nullptr;
+        auto itVariable = m_Variables.find(name);
+        if (itVariable != m_Variables.end())
+        {
+            variable = static_cast<Variable<T> *>(itVariable->second);
+        }
+        else
+        {
+            // dimensions from the first block in the current step, or in the
+            // file if the variable is not in the current step
+            const auto &blocks = varIndex->Blocks;
+            std::vector<const format::BP1Block *> stepBlocks =
+                m_BP1Reader.GetStepBlocks(*varIndex, GetCurrentTimeStep());
+            const format::BP1Block *block =
+                stepBlocks.empty() ? &blocks.front() : stepBlocks.front();
+
+            if (block->Shape.empty()) // local variable
+            {
+                variable = &m_ADIOS.DefineVariable<T>(name, block->Count);
+            }
+            else // the whole global array is selected
+            {
+                variable = &m_ADIOS.DefineVariable<T>(
+                    name, block->Shape, block->Shape,
+                    Dims(block->Shape.size(), 0));
+            }
+            m_Variables.emplace(name, variable);
+        }
+
+        if (readIn == true)
+        {
+            ReadCommon<T>(*variable, nullptr);
+        }
+        return variable;
+    }
+
+    /**
+     * Blocks and global selection of a variable read in the current step
+     * @param variable selection from SetSelection
+     * @param blocks output, blocks in the current step
+     * @param start output, selection global offsets
+     * @param count output, selection dimensions
+     * @param hint function name for exceptions
+     * @return false: variable is not found or not in the current step
+     */
+    template <class T>
+    bool GetReadBlocks(Variable<T> &variable,
+                       std::vector<const format::BP1Block *> &blocks,
+                       Dims &start, Dims &count, const std::string hint)
+    {
+        const format::BP1VarIndex *varIndex =
+            m_BP1Reader.GetVarIndex(variable.m_Name, m_MetadataSet);
+        if (varIndex == nullptr)
+        {
+            if (m_DebugMode == true)
+            {
+                throw std::invalid_argument(
+                    "ERROR: variable " + variable.m_Name + " not found in " +
+                    m_Name + ", in call to " + hint + "\n");
+            }
+            return false;
+        }
+
+        blocks = m_BP1Reader.GetStepBlocks(*varIndex, GetCurrentTimeStep());
+        if (blocks.empty())
+        {
+            if (m_DebugMode == true)
+            {
+                throw std::invalid_argument(
+                    "ERROR: variable " + variable.m_Name +
+                    " has no blocks in the current step of " + m_Name +
+                    ", in call to " + hint + "\n");
+            }
+            return false;
+        }
+
+        // selection in global space, local variables read their first block
+        const bool isLocal = blocks.front()->Shape.empty();
+        if (m_ReadAhead != nullptr)
+        {
+            m_ReadPattern[variable.m_Name] = {
+                isLocal, variable.m_GlobalOffsets, variable.m_Dimensions,
+                sizeof(T)};
+        }
+
+        if (isLocal == true)
+        {
+            blocks.resize(1);
+            start.assign(blocks.front()->Count.size(), 0);
+            count = blocks.front()->Count;
+            return true;
+        }
+
+        start = variable.m_GlobalOffsets;
+        count = variable.m_Dimensions;
+        if (m_DebugMode == true)
+        {
+            const Dims &shape = blocks.front()->Shape;
+            bool isInside =
+                start.size() == shape.size() && count.size() == shape.size();
+            for (std::size_t d = 0; isInside && d < shape.size(); ++d)
+            {
+                isInside = start[d] + count[d] <= shape[d];
+            }
+            if (isInside == false)
+            {
+                throw std::invalid_argument(
+                    "ERROR: selection of variable " + variable.m_Name +
+                    " is outside its global dimensions, in call to " + hint +
+                    "\n");
+            }
+        }
+        return true;
+    }
+
+    template <class T>
+    void ReadCommon(Variable<T> &variable, const T *values)
+    {
+        std::vector<const format::BP1Block *> blocks;
+        Dims start, count;
+        if (GetReadBlocks(variable, blocks, start, count, "Read") == false)
+        {
+            return;
+        }
+
+        // zero-copy view into the mapped file
+        if (values == nullptr)
+        {
+            for (const auto block : blocks)
+            {
+                std::size_t offset = 0;
+                if (block->IsTransformed == true ||
+                    IsContiguousInBlock(GetBlockStart(*block, start.size()),
+                                        block->Count, start, count,
+                                        offset) == false)
+                {
+                    continue;
+                }
+
+                const char *payload = GetPayload(
+                    *block, GetTotalSize(block->Count) * sizeof(T));
+                if (payload == nullptr)
+                {
+                    break;
+                }
+                const char *view = payload + offset * sizeof(T);
+                // payloads are not padded, misaligned views are copied
+                if (reinterpret_cast<std::uintptr_t>(view) % alignof(T) == 0)
+                {
+                    variable.m_AppValues = reinterpret_cast<const T *>(view);
+                    return;
+                }
+                break;
+            }
+        }
+
+        T *destination = const_cast<T *>(values);
+        if (destination == nullptr)
+        {
+            std::vector<char> &buffer = m_ReadBuffers[variable.m_Name];
+            buffer.resize(GetTotalSize(count) * sizeof(T));
+            destination = reinterpret_cast<T *>(buffer.data());
+        }
+
+        std::vector<BlockCopy> copies;
+        copies.reserve(blocks.size());
+        for (const auto block : blocks)
+        {
+            if (m_DebugMode == true)
+            {
+                if (block->IsTransformed == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: variable " + variable.m_Name +
+                        " has transformed blocks, not supported in call to "
+                        "Read\n");
+                }
+            }
+
+            const char *payload =
+                GetPayload(*block, GetTotalSize(block->Count) * sizeof(T));
+            if (payload != nullptr)
+            {
+                copies.push_back({payload, block,
+                                  reinterpret_cast<char *>(destination),
+                                  &start, &count, sizeof(T)});
+            }
+        }
+        CopyBlocks(copies);
+        variable.m_AppValues = destination;
+    }
+
+    template <class T>
+    void ScheduleReadCommon(Variable<T> &variable, const T *values)
+    {
+        ScheduledRead read;
+        std::vector<const format::BP1Block *> blocks;
+        if (GetReadBlocks(variable, blocks, read.Start, read.Count,
+                          "ScheduleRead") == false)
+        {
+            return;
+        }
+
+        read.Name = variable.m_Name;
+        read.Values = reinterpret_cast<char *>(const_cast<T *>(values));
+        read.Size = GetTotalSize(read.Count) * sizeof(T);
+        read.ElementSize = sizeof(T);
+        read.SetAppValues = [&variable](const char *appValues) {
+            variable.m_AppValues = reinterpret_cast<const T *>(appValues);
+        };
+
+        for (const auto block : blocks)
+        {
+            if (m_DebugMode == true)
+            {
+                if (block->IsTransformed == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: variable " + variable.m_Name +
+                        " has transformed blocks, not supported in call to "
+                        "ScheduleRead\n");
+                }
+            }
+
+            std::uint64_t begin, end;
+            if (GetSelectedBytes(*block, read.Start, read.Count, sizeof(T),
+                                 begin, end) == false)
+            {
+                continue;
+            }
+
+            m_ScheduledBlocks.push_back(
+                {block, GetTotalSize(block->Count) * sizeof(T), begin, end,
+                 m_ScheduledReads.size()});
+        }
+        m_ScheduledReads.push_back(std::move(read));
+    }
+
+    template <class T>
+    QueryResult QueryCommon(Variable<T> &variable, const T lo, const T hi,
+                            const SelectionType type)
+    {
+        QueryResult result;
+        result.Type = type;
+        if (m_DebugMode == true)
+        {
+            if (type != SelectionType::Points &&
+                type != SelectionType::BoundingBox)
+            {
+                throw std::invalid_argument(
+                    "ERROR: query of variable " + variable.m_Name +
+                    " must return Points or BoundingBox, in call to Query\n");
+            }
+        }
+
+        std::vector<const format::BP1Block *> blocks;
+        Dims start, count;
+        if (GetReadBlocks(variable, blocks, start, count, "Query") == false)
+        {
+            return result;
+        }
+        result.Ndim = start.size();
+
+        const bool isEmptyRange = !(lo <= hi); // also NaN bounds
+        std::vector<QueryBlock> queries;
+        for (const auto block : blocks)
+        {
+            QueryBlock query{block, nullptr, false, Dims(), Dims(), 0,
+                             std::vector<std::uint64_t>(), Dims(), Dims()};
+            if (GetIntersection(*block, start, count, query.Start,
+                                query.Count) == false)
+            {
+                continue;
+            }
+            ++result.Blocks;
+
+            if (isEmptyRange == true)
+            {
+                continue;
+            }
+
+            if (block->HasMinMax == true)
+            {
+                T min, max;
+                std::memcpy(&min, block->Min, sizeof(T));
+                std::memcpy(&max, block->Max, sizeof(T));
+                if (max < lo || hi < min)
+                {
+                    continue;
+                }
+                // min and max of floating point blocks skip NaN values, only
+                // integer blocks are known to be all in range
+                if (std::is_integral<T>::value == true && lo <= min &&
+                    max <= hi)
+                {
+                    queries.push_back(std::move(query));
+                    continue;
+                }
+            }
+
+            if (block->IsTransformed == true)
+            {
+                if (m_DebugMode == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: variable " + variable.m_Name +
+                        " has transformed blocks, not supported in call to "
+                        "Query\n");
+                }
+                continue;
+            }
+
+            query.Payload =
+                GetPayload(*block, GetTotalSize(block->Count) * sizeof(T));
+            if (query.Payload == nullptr)
+            {
+                continue;
+            }
+            // only elements of partially selected bins are read
+            query.UseBitmap =
+                (block->Bitmap != nullptr && block->HasMinMax == true);
+            ++(query.UseBitmap ? result.IndexedBlocks : result.ScannedBlocks);
+            queries.push_back(std::move(query));
+        }
+
+        const bool points = (type == SelectionType::Points);
+        if (m_ThreadPool != nullptr && queries.size() > 1)
+        {
+            for (auto &query : queries)
+            {
+                QueryBlock *queryPtr = &query;
+                m_ThreadPool->Push([this, queryPtr, lo, hi, points]() {
+                    QueryBlockValues(*queryPtr, lo, hi, points);
+                });
+            }
+            m_ThreadPool->Wait();
+        }
+        else
+        {
+            for (auto &query : queries)
+            {
+                QueryBlockValues(query, lo, hi, points);
+            }
+        }
+
+        GetQueryResult(queries, result);
+        return result;
+    }
+
+    /**
+     * Finds the elements in range of a block intersection with the block
+     * bitmap index. Elements of bins inside [lo, hi] are hits without reading
+     * them, only elements of the first and last bins of the range are read
+     * from the payload. Bins are the writer GetBitmapIndex bins.
+     * @param query block, Payload is mapped
+     * @param lo lower bound of values
+     * @param hi upper bound of values
+     * @param points true: coordinates of each element, false: box only
+     * @return false: malformed index, query is unchanged
+     */
+    template <class T>
+    bool QueryBlockBitmap(QueryBlock &query, const T lo, const T hi,
+                          const bool points) const
+    {
+        const format::BP1Block &block = *query.Block;
+        const char *bitmap = block.Bitmap;
+        const char *bitmapEnd = bitmap + block.BitmapSize;
+        if (block.BitmapSize < 2)
+        {
+            return false;
+        }
+        std::uint16_t bins;
+        std::memcpy(&bins, bitmap, 2);
+        if (bins == 0 || block.BitmapSize < 2 + 4 * std::size_t(bins))
+        {
+            return false;
+        }
+
+        T min, max;
+        std::memcpy(&min, block.Min, sizeof(T));
+        std::memcpy(&max, block.Max, sizeof(T));
+        const double lower = static_cast<double>(min);
+        const double width = (static_cast<double>(max) - lower) / bins;
+        const std::size_t first =
+            GetBin(static_cast<double>(lo), lower, width, bins);
+        const std::size_t last =
+            GetBin(static_cast<double>(hi), lower, width, bins);
+
+        // bins between first and last only hold values in (lo, hi)
+        const std::size_t blockSize = GetTotalSize(block.Count);
+        std::vector<std::size_t> positions;  // block elements in range
+        std::vector<std::size_t> candidates; // block elements to be read
+        const char *words = bitmap + 2 + 4 * std::size_t(bins);
+        for (std::size_t b = 0; b < bins; ++b)
+        {
+            std::uint32_t binWords;
+            std::memcpy(&binWords, bitmap + 2 + 4 * b, 4);
+            if (std::size_t(bitmapEnd - words) < 4 * std::size_t(binWords))
+            {
+                return false;
+            }
+
+            if (b >= first && b <= last)
+            {
+                const bool isExact = (b > first || lo <= min) &&
+                                     (b < last || max <= hi);
+                if (GetWAHPositions(words, binWords, blockSize,
+                                    isExact ? positions : candidates) == false)
+                {
+                    return false;
+                }
+            }
+            words += 4 * std::size_t(binWords);
+        }
+
+        for (const auto position : candidates)
+        {
+            T value;
+            std::memcpy(&value, query.Payload + position * sizeof(T),
+                        sizeof(T));
+            if (value >= lo && value <= hi)
+            {
+                positions.push_back(position);
+            }
+        }
+        std::sort(positions.begin(), positions.end());
+
+        // block elements to global coordinates inside the intersection
+        const std::size_t dimensions = query.Count.size();
+        const Dims blockStart = GetBlockStart(block, dimensions);
+        query.BoxFirst.assign(dimensions, SIZE_MAX);
+        query.BoxLast.assign(dimensions, 0);
+        Dims coordinates(dimensions);
+        for (auto position : positions)
+        {
+            bool isInside = true;
+            for (std::size_t d = dimensions; d-- > 0;)
+            {
+                coordinates[d] = blockStart[d] + position % block.Count[d];
+                position /= block.Count[d];
+                isInside = isInside && coordinates[d] >= query.Start[d] &&
+                           coordinates[d] < query.Start[d] + query.Count[d];
+            }
+            if (isInside == false)
+            {
+                continue;
+            }
+
+            ++query.Hits;
+            for (std::size_t d = 0; d < dimensions; ++d)
+            {
+                query.BoxFirst[d] = std::min(query.BoxFirst[d], coordinates[d]);
+                query.BoxLast[d] = std::max(query.BoxLast[d], coordinates[d]);
+            }
+            if (points == true)
+            {
+                query.Points.insert(query.Points.end(), coordinates.begin(),
+                                    coordinates.end());
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Finds the elements in range of a block intersection row by row, rows
+     * are scanned in pieces of at most 64K elements
+     * @param query block, Payload nullptr: all elements are in range
+     * @param lo lower bound of values
+     * @param hi upper bound of values
+     * @param points true: coordinates of each element, false: box only
+     */
+    template <class T>
+    void QueryBlockValues(QueryBlock &query, const T lo, const T hi,
+                          const bool points) const
+    {
+        if (query.UseBitmap == true &&
+            QueryBlockBitmap(query, lo, hi, points) == true)
+        {
+            return;
+        }
+
+        const format::BP1Block &block = *query.Block;
+        const std::size_t dimensions = query.Count.size();
+        const Dims blockStart = GetBlockStart(block, dimensions);
+        const std::size_t rowSize =
+            (dimensions == 0) ? 1 : query.Count.back();
+        const std::size_t rows = GetTotalSize(query.Count) / rowSize;
+
+        const std::size_t pieceSize = std::min(rowSize, std::size_t(65536));
+        std::vector<std::size_t> positions(pieceSize);
+        std::vector<T> aligned; // copy of misaligned payload pieces
+        if (query.Payload == nullptr)
+        {
+            for (std::size_t i = 0; i < pieceSize; ++i)
+            {
+                positions[i] = i;
+            }
+        }
+
+        query.BoxFirst.assign(dimensions, SIZE_MAX);
+        query.BoxLast.assign(dimensions, 0);
+        Dims position(query.Start); // global coordinates of the row start
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            std::size_t offset = 0; // row start in block
+            for (std::size_t d = 0; d < dimensions; ++d)
+            {
+                offset = offset * block.Count[d] + position[d] - blockStart[d];
+            }
+
+            for (std::size_t begin = 0; begin < rowSize; begin += pieceSize)
+            {
+                const std::size_t size = std::min(pieceSize, rowSize - begin);
+                std::size_t hits = size;
+                if (query.Payload != nullptr)
+                {
+                    const char *bytes =
+                        query.Payload + (offset + begin) * sizeof(T);
+                    const T *values = reinterpret_cast<const T *>(bytes);
+                    // payloads are not padded
+                    if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(T) !=
+                        0)
+                    {
+                        aligned.resize(size);
+                        std::memcpy(aligned.data(), bytes, size * sizeof(T));
+                        values = aligned.data();
+                    }
+                    hits = GetInRange(values, size, lo, hi, positions.data());
+                }
+
+                if (hits == 0)
+                {
+                    continue;
+                }
+
+                query.Hits += hits;
+                if (dimensions == 0)
+                {
+                    continue;
+                }
+
+                for (std::size_t d = 0; d < dimensions - 1; ++d)
+                {
+                    query.BoxFirst[d] =
+                        std::min(query.BoxFirst[d], position[d]);
+                    query.BoxLast[d] = std::max(query.BoxLast[d], position[d]);
+                }
+                const std::size_t first = position.back() + begin;
+                query.BoxFirst.back() =
+                    std::min(query.BoxFirst.back(), first + positions[0]);
+                query.BoxLast.back() =
+                    std::max(query.BoxLast.back(), first + positions[hits - 1]);
+
+                if (points == true)
+                {
+                    for (std::size_t h = 0; h < hits; ++h)
+                    {
+                        query.Points.insert(query.Points.end(),
+                                            position.begin(),
+                                            position.end() - 1);
+                        query.Points.push_back(first + positions[h]);
+                    }
+                }
+            }
+
+            // next row, last dimension changes fastest
+            for (std::size_t d = (dimensions > 0) ? dimensions - 1 : 0;
+                 d-- > 0;)
+            {
+                if (++position[d] < query.Start[d] + query.Count[d])
+                {
+                    break;
+                }
+                position[d] = query.Start[d];
+            }
+        }
     }
 };
 
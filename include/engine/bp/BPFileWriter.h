@@ -11,7 +11,13 @@
 #ifndef BPFILEWRITER_H_
 #define BPFILEWRITER_H_
 
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <map>
+#include <memory> //std::unique_ptr, std::shared_ptr
+/// \endcond
+
 #include "core/Engine.h"
+#include "core/IOThread.h"
 #include "format/BP1Aggregator.h"
 #include "format/BP1Writer.h"
 
@@ -88,8 +94,29 @@ public:
                const std::complex<long double> *values);
     void Write(const std::string variableName, const void *values);
 
+    /**
+     * Closes the current step. With Method parameter flush_steps=yes the step
+     * is written to the transports and only its metadata is kept until Close.
+     * deferred_writes=yes implies flush_steps=yes, application arrays passed
+     * to Write must not change until Advance.
+     * With async_io=yes the step buffer is written by a background thread
+     * while the next step is buffered, waits only for the previous step to be
+     * written.
+     * @param timeout_sec not used
+     */
     void Advance(float timeout_sec = 0.0);
 
+    /**
+     * Same as Advance
+     * @param mode not used
+     * @param callback called once the step is written to all transports,
+     * from the I/O thread if async_io=yes, otherwise immediately as the step
+     * remains in the buffer
+     */
+    void
+    AdvanceAsync(AdvanceMode mode,
+                 std::function<void(std::shared_ptr<adios::Engine>)> callback);
+
     /**
      * Closes a single transport or all transports
      * @param transportIndex, if -1 (default) closes all transports, otherwise
@@ -102,6 +129,7 @@ public:
 
 private:
     capsule::STLVector m_Buffer; ///< heap capsule using STL std::vector<char>
+    capsule::STLVector m_BackBuffer; ///< previous step written by m_IOThread
     format::BP1Writer
         m_BP1Writer; ///< format object will provide the required BP
                      /// functionality to be applied on m_Buffer and
@@ -116,7 +144,8 @@ private:
         true; ///< set to false after first Close is reached so
               /// metadata doesn't have to be accommodated for a
     /// subsequent Close
-    std::size_t m_MaxBufferSize; ///< maximum allowed memory to be allocated
+    std::size_t m_MaxBufferSize; ///< maximum allowed memory to be allocated,
+                                 /// data is flushed to transports in batches
     float m_GrowthFactor = 1.5;  ///< capsule memory growth factor, new_memory =
                                  /// m_GrowthFactor * current_memory
 
@@ -127,13 +156,50 @@ private:
     /// prevents flattening the data and metadata
     /// in Close
 
+    bool m_FlushSteps = false; ///< true: Advance writes each step to
+                               /// transports, buffer memory stays constant
+    bool m_DeferredWrites = false; ///< true: payloads are not copied, written
+                                   /// from application memory at Advance
+    std::size_t m_DeferredMinSize = 65536; ///< smaller payloads are copied
+
+    /** background writer, only with Method parameter async_io=yes, declared
+     * last so it is joined before the buffers are released */
+    std::unique_ptr<IOThread> m_IOThread;
+
     void Init();
     void InitParameters();
     void InitTransports();
+
+    /**
+     * Creates the file transport selected by the library parameter
+     * @param parameters of a File transport from Method AddTransport
+     * @param mpiComm communicator of the transport
+     * @return transport, nullptr if the library is not supported and debug
+     * mode is off
+     */
+    std::shared_ptr<Transport>
+    MakeFileTransport(const std::map<std::string, std::string> &parameters,
+                      MPI_Comm mpiComm) const;
     void InitProcessGroup();
 
     void WriteProcessGroupIndex();
 
+    /** Blocks until the I/O thread (if any) has written all steps */
+    void WaitForIOThread();
+
+    /**
+     * Swaps the closed step into m_BackBuffer and queues its write
+     * @param callback optional, called by the I/O thread after the write
+     */
+    void WriteStepAsync(
+        std::function<void(std::shared_ptr<adios::Engine>)> callback);
+
+    /**
+     * Collective, gathers the rank metadata in rank 0, which writes the merged
+     * global metadata file name.bp/name.bp.idx
+     */
+    void WriteGlobalMetadata();
+
     /**
      * Common function for primitive (including std::complex) writes
      * @param group
@@ -150,32 +216,57 @@ private:
         variable.m_AppValues = values;
         m_WrittenVariables.insert(variable.m_Name);
 
-        // if first timestep Write
-        if (m_MetadataSet.DataPGIsOpen == false) // create a new pg index
-            WriteProcessGroupIndex();
-
-        // pre-calculate new metadata and payload sizes
-        //        m_TransportFlush = CheckBufferAllocation(
-        //        m_BP1Writer.GetVariableIndexSize( variable ) +
-        //        variable.PayLoadSize(),
-        //                                                  m_GrowthFactor,
-        //                                                  m_MaxBufferSize,
-        //                                                  m_Buffer.m_Data );
-
-        // WRITE INDEX to data buffer and metadata structure (in memory)//
-        m_BP1Writer.WriteVariableMetadata(variable, m_Buffer, m_MetadataSet);
+        // pre-calculate new metadata and payload sizes, deferred payloads
+        // stay in application memory
+        const bool isDeferred = m_DeferredWrites == true &&
+                                variable.PayLoadSize() >= m_DeferredMinSize;
+        const std::size_t variableSize =
+            m_BP1Writer.GetVariableIndexSize(variable) +
+            (isDeferred ? 0 : variable.PayLoadSize());
+        m_TransportFlush = CheckBufferAllocation(
+            variableSize, m_GrowthFactor, m_MaxBufferSize, m_Buffer.m_Data);
 
         if (m_TransportFlush == true) // in batches
         {
-            // write pg index
+            WaitForIOThread(); // transports are not shared with the thread
+            // write pg to transports, reset relative positions to zero,
+            // absolute position is kept for offsets. An empty first pg is kept
+            // in the buffer
+            if (m_MetadataSet.DataPGIsOpen == false ||
+                m_MetadataSet.DataPGVarsCount > 0)
+            {
+                m_BP1Writer.Flush(m_MetadataSet, m_Buffer, m_Transports);
+            }
 
-            // flush to transports
+            // still true: payload doesn't fit in an empty buffer
+            m_TransportFlush = CheckBufferAllocation(
+                variableSize, m_GrowthFactor, m_MaxBufferSize, m_Buffer.m_Data);
+        }
+
+        // if first timestep Write or pg was flushed
+        if (m_MetadataSet.DataPGIsOpen == false) // create a new pg index
+            WriteProcessGroupIndex();
 
-            // reset relative positions to zero, update absolute position
+        if (m_TransportFlush == true) // payload bypasses the buffer
+        {
+            // WRITE INDEX to data buffer and metadata structure (in memory)//
+            m_BP1Writer.WriteVariableMetadata(variable, m_Buffer,
+                                              m_MetadataSet);
+            m_BP1Writer.Flush(
+                m_MetadataSet, m_Buffer, m_Transports,
+                reinterpret_cast<const char *>(variable.m_AppValues),
+                variable.PayLoadSize());
+        }
+        else if (isDeferred == true) // index to buffer, payload extent
+        {
+            m_BP1Writer.WriteVariableMetadata(variable, m_Buffer,
+                                              m_MetadataSet);
+            m_BP1Writer.WriteVariableDeferred(variable, m_Buffer);
         }
-        else // Write data to buffer
+        else // index and data to buffer, stats computed while copying
         {
-            m_BP1Writer.WriteVariablePayload(variable, m_Buffer, m_nThreads);
+            m_BP1Writer.WriteVariable(variable, m_Buffer, m_MetadataSet,
+                                      m_nThreads);
         }
 
         variable.m_AppValues =
@@ -12,6 +12,7 @@
 #define BP1_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <complex> //std::complex
 #include <cstdint> //std::uintX_t
 #include <memory>  //std::shared_ptr
 #include <unordered_map>
@@ -39,6 +40,8 @@ struct BP1Index
     std::uint64_t Count = 0;  ///< number of characteristics sets (time and
                               /// spatial aggregation)
     const std::uint32_t MemberID;
+    std::vector<std::size_t> OffsetPositions; ///< positions in Buffer of
+                                              /// absolute file offsets
 
     BP1Index(const std::uint32_t memberID) : MemberID{memberID}
     {
@@ -83,6 +86,9 @@ struct BP1MetadataSet
            /// updated in every advance step or init
     bool DataPGIsOpen = false;
 
+    std::size_t MetadataPosition = 0; ///< flattened metadata (footer)
+                                      /// relative position in data buffer
+
     Profiler Log; ///< object that takes buffering profiling info
 };
 
@@ -107,9 +113,17 @@ public:
      * @param name might contain .bp or not, if not .bp will be added
      * @param accessMode "write" "w", "r" "read",  "append" "a"
      * @param transport file I/O transport
+     * @param fileIndex -1: rank, otherwise subfile index for aggregation
      */
     void OpenRankFiles(const std::string name, const std::string accessMode,
-                       Transport &transport) const;
+                       Transport &transport, const int fileIndex = -1) const;
+
+    /**
+     * Global metadata file name, aggregated from all rank files at Close
+     * @param name might contain .bp or not, if not .bp will be added
+     * @return name.bp/name.bp.idx
+     */
+    std::string GetMetadataFileName(const std::string name) const noexcept;
 
 protected:
     /**
@@ -199,10 +213,11 @@ protected:
         type_double = 6,      //!< type_double
         type_long_double = 7, //!< type_long_double
 
-        type_string = 9,          //!< type_string
-        type_complex = 10,        //!< type_complex
-        type_double_complex = 11, //!< type_double_complex
-        type_string_array = 12    //!< type_string_array
+        type_string = 9,               //!< type_string
+        type_complex = 10,             //!< type_complex
+        type_double_complex = 11,      //!< type_double_complex
+        type_string_array = 12,        //!< type_string_array
+        type_long_double_complex = 13  //!< type_long_double_complex
     };
 
     /**
@@ -246,11 +261,17 @@ protected:
         std::uint32_t TimeIndex;
         std::uint32_t MemberID;
 
-        //		unsigned long int count;
-        //		long double sum;
-        //		long double sumSquare;
-        // unsigned long int histogram
-        // bool finite??
+        // extended statistics, only if verbosity > 0
+        std::uint64_t Count; ///< number of finite values
+        double Sum;          ///< sum of finite values
+        double SumSquare;    ///< sum of squares of finite values
+        std::uint8_t Finite; ///< 1: all values are finite, 0: otherwise
+        std::vector<std::uint64_t> Histogram; ///< frequencies in equal width
+                                              /// bins between Min and Max
+
+        // bitmap index, only if bitmap bins > 0
+        std::vector<std::uint32_t> Bitmap;         ///< WAH words of all bins
+        std::vector<std::uint32_t> BitmapBinWords; ///< words of each bin
     };
 
     /**
@@ -289,6 +310,14 @@ inline std::int8_t BP1::GetDataType<int>() const noexcept
 template <>
 inline std::int8_t BP1::GetDataType<long int>() const noexcept
 {
+    // BP1 types have fixed sizes, long is 4 bytes on LLP64 and ILP32
+    return (sizeof(long int) == 8) ? type_long : type_integer;
+}
+
+template <>
+inline std::int8_t BP1::GetDataType<long long int>() const noexcept
+{
+    static_assert(sizeof(long long int) == 8, "BP1 type_long is 8 bytes");
     return type_long;
 }
 
@@ -310,6 +339,15 @@ inline std::int8_t BP1::GetDataType<unsigned int>() const noexcept
 template <>
 inline std::int8_t BP1::GetDataType<unsigned long int>() const noexcept
 {
+    return (sizeof(unsigned long int) == 8) ? type_unsigned_long
+                                            : type_unsigned_integer;
+}
+
+template <>
+inline std::int8_t BP1::GetDataType<unsigned long long int>() const noexcept
+{
+    static_assert(sizeof(unsigned long long int) == 8,
+                  "BP1 type_unsigned_long is 8 bytes");
     return type_unsigned_long;
 }
 
@@ -329,6 +367,22 @@ inline std::int8_t BP1::GetDataType<long double>() const noexcept
     return type_long_double;
 }
 
+template <>
+inline std::int8_t BP1::GetDataType<std::complex<float>>() const noexcept
+{
+    return type_complex;
+}
+template <>
+inline std::int8_t BP1::GetDataType<std::complex<double>>() const noexcept
+{
+    return type_double_complex;
+}
+template <>
+inline std::int8_t BP1::GetDataType<std::complex<long double>>() const noexcept
+{
+    return type_long_double_complex;
+}
+
 } // end namespace format
 } // end namespace adios
 
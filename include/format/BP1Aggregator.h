@@ -11,6 +11,13 @@
 #ifndef BP1AGGREGATOR_H_
 #define BP1AGGREGATOR_H_
 
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+/// \endcond
+
 #include "ADIOS_MPI.h"
 
 namespace adios
@@ -29,6 +36,18 @@ public:
     int m_RankMPI = 0;                  ///< current MPI rank process
     int m_SizeMPI = 1;                  ///< current MPI processes size
 
+    /** N-to-M aggregation, ranks are split in contiguous groups or in
+     * shared memory nodes, the first rank in each group (aggregator) writes
+     * the group subfile */
+    unsigned int m_SubFiles = 0;     ///< M, 0: N-to-N no aggregation
+    unsigned int m_SubFileIndex = 0; ///< current rank subfile (group) index
+    bool m_IsAggregator = true;      ///< true: current rank writes a (sub)file
+    bool m_IsNodeAggregation = false; ///< true: groups are nodes, data is
+                                      /// deposited in a shared memory segment
+    bool m_IsSharedFile = false; ///< true: single subfile written by all
+                                 /// ranks collectively (MPI_File transport)
+    MPI_Comm m_SubFileComm = MPI_COMM_NULL; ///< current rank group
+
     /**
      * Unique constructor
      * @param mpiComm coming from engine
@@ -46,8 +65,93 @@ public:
     void WriteProfilingLog(const std::string fileName,
                            const std::string &rankLog);
 
+    /**
+     * Collective, gathers a buffer from every rank in rank 0 with
+     * MPI_Gather (64-bit sizes) and MPI_Gatherv (buffers), or point-to-point
+     * pieces if the total exceeds the int range of MPI_Gatherv
+     * @param buffer from current rank
+     * @param size of buffer
+     * @param sizes output in rank 0: buffer size from each rank
+     * @param subFile true: gather in aggregator from its group only
+     * @return rank 0: buffers from all ranks in rank order, other ranks: empty
+     */
+    std::vector<char> GatherBuffers(const char *buffer, const std::size_t size,
+                                    std::vector<std::size_t> &sizes,
+                                    const bool subFile = false) const;
+
+    /**
+     * Collective in group, members send buffer to their aggregator, which
+     * passes its own buffer and then the members buffers in rank order to
+     * write, one piece at a time. With node aggregation all buffers are
+     * deposited in a node shared memory segment passed to write at once.
+     * With a shared file every rank passes its own buffer to a collective
+     * write.
+     * @param buffer from current rank
+     * @param size of buffer
+     * @param write called in aggregator only, or in all ranks if shared file
+     * @return aggregator: subfile size written, members: 0
+     */
+    std::uint64_t WriteSubFile(
+        const char *buffer, const std::size_t size,
+        const std::function<void(const char *, const std::size_t)> &write)
+        const;
+
+    /**
+     * Collective, splits ranks in subFiles contiguous groups for N-to-M
+     * aggregation. subFiles >= number of ranks keeps N-to-N.
+     * @param subFiles M number of subfiles
+     */
+    void InitSubFiles(const unsigned int subFiles);
+
+    /**
+     * Collective, one group per shared memory node
+     * (MPI_Comm_split_type with MPI_COMM_TYPE_SHARED), subfiles are indexed
+     * in order of their aggregator rank
+     */
+    void InitNodeSubFiles();
+
+    /**
+     * Collective, N-to-1 without data movement, a single subfile is written
+     * by all ranks through a collective transport, rank 0 writes its metadata
+     */
+    void InitSharedFile();
+
+    /** Releases the subfile communicator, after the last aggregation */
+    void FreeSubFileComm();
+
+    /**
+     * @param rank in m_MPIComm
+     * @return subfile index of rank, its own rank if N-to-N
+     */
+    unsigned int GetSubFileIndex(const int rank) const noexcept;
+
+    /**
+     * Collective in group, offset of the current rank data in its subfile
+     * (MPI_Exscan)
+     * @param size bytes of data from current rank
+     * @return sum of sizes from previous ranks in group
+     */
+    std::uint64_t GetSubFileOffset(const std::uint64_t size) const;
+
 private:
     const bool m_DebugMode = false;
+    std::vector<unsigned int> m_SubFileIndices; ///< rank 0, node aggregation:
+                                                /// subfile index of each rank
+
+    /**
+     * Node aggregation version of WriteSubFile, members copy their buffers
+     * to a System V shared memory segment created by the aggregator
+     * @param buffer from current rank
+     * @param size of buffer
+     * @param write called in aggregator only
+     * @param subFileSize aggregator: subfile size written, members: 0
+     * @return false: segment couldn't be created or attached in some rank,
+     * nothing was written
+     */
+    bool WriteNodeSubFile(
+        const char *buffer, const std::size_t size,
+        const std::function<void(const char *, const std::size_t)> &write,
+        std::uint64_t &subFileSize) const;
 };
 
 } // end namespace format
@@ -0,0 +1,274 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * BP1Reader.h
+ *
+ *  Created on: May 1, 2017
+ *      Author: wfg
+ */
+
+#ifndef BP1READER_H_
+#define BP1READER_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+/// \endcond
+
+#include "BP1.h"
+#include "core/VariableBase.h" //Dims
+
+namespace adios
+{
+namespace format
+{
+
+/**
+ * Characteristics set of a single variable block, decoded from its variable
+ * index entry
+ */
+struct BP1Block
+{
+    Dims Count; ///< local dimensions
+    Dims Shape; ///< global dimensions, empty for local variables
+    Dims Start; ///< global offsets, empty for local variables
+
+    std::uint64_t Offset = 0;        ///< variable record in its file
+    std::uint64_t PayloadOffset = 0; ///< payload in its file
+    std::uint32_t TimeIndex = 0;     ///< writer time step
+    std::uint32_t FileIndex = 0;     ///< subfile, 0 if not in metadata
+    bool IsValue = false;       ///< single value, Min and Max are the value
+    bool IsTransformed = false; ///< payload is not the raw values
+    bool HasMinMax = false;     ///< Min and Max are in the metadata
+
+    char Min[16]; ///< min (or value) bytes in the variable type
+    char Max[16]; ///< max (or value) bytes in the variable type
+
+    /** characteristic_bitmap after its length, [bins 2][bins x words
+     * 4][words x 4], in the metadata buffer, nullptr if not indexed */
+    const char *Bitmap = nullptr;
+    std::uint32_t BitmapSize = 0; ///< Bitmap bytes
+};
+
+/**
+ * Decoded variable index entry
+ */
+struct BP1VarIndex
+{
+    std::uint32_t MemberID = 0;
+    std::uint8_t DataType = 0;    ///< from enum DataTypes
+    std::vector<BP1Block> Blocks; ///< in metadata order
+};
+
+/**
+ * Indices parsed from a flattened metadata buffer: a rank file footer or the
+ * global metadata file. Absolute offsets in the metadata are positions in
+ * Buffer, which must contain the whole file. Index entries are located when
+ * the metadata is parsed, their characteristics sets are decoded on first
+ * lookup.
+ */
+struct BP1ReadMetadataSet
+{
+    const char *Buffer = nullptr; ///< not owned, e.g. a mapped file
+    std::size_t Size = 0;         ///< Buffer size
+    bool IsIndexCache = false;    ///< Buffer is an index cache, not metadata
+
+    std::uint64_t OffsetPGIndex = 0;
+    std::uint64_t OffsetVarsIndex = 0;
+    std::uint64_t OffsetAttributeIndex = 0;
+    std::uint8_t Version = 0; ///< BP format version in minifooter
+
+    std::uint64_t PGCount = 0;            ///< process groups in PG index
+    std::vector<std::uint32_t> TimeSteps; ///< sorted, from the PG index
+
+    /** var index entries positions in Buffer, sorted by variable name */
+    std::vector<std::uint64_t> VarsOffsets;
+    /** attribute index entries positions in Buffer, key: attribute name */
+    std::unordered_map<std::string, std::uint64_t> AttributesOffsets;
+
+    std::unordered_map<std::string, BP1VarIndex> VarsIndices; ///< decoded
+                                                              /// entries
+    std::unordered_map<std::string, BP1VarIndex>
+        AttributesIndices; ///< decoded entries
+
+    const unsigned int MiniFooterSize = 28;
+};
+
+/**
+ * File an index cache was built from, the cache is valid while the file size
+ * and modification time are unchanged
+ */
+struct BP1CacheSource
+{
+    bool IsMetadata = false;     ///< true: metadata file, false: data file
+    std::uint32_t FileIndex = 0; ///< data file index
+    std::uint64_t Size = 0;
+    std::int64_t ModifiedSeconds = 0;
+    std::int64_t ModifiedNanoseconds = 0;
+};
+
+/**
+ * Parses BP1 metadata written by BP1Writer
+ */
+class BP1Reader : public BP1
+{
+
+public:
+    bool m_DebugMode = false; ///< true: metadata bounds and version checks
+
+    /**
+     * Parses the minifooter and the PG index, and locates the variable and
+     * attribute index entries without decoding their characteristics
+     * @param buffer whole file containing the metadata at its end
+     * @param size of buffer
+     * @param metadataSet output
+     */
+    void ParseMetadata(const char *buffer, const std::size_t size,
+                       BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Decodes all variable index entries, e.g. before GetIndexCache
+     * @param metadataSet from ParseMetadata
+     */
+    void ParseAllVarsIndices(BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Serializes decoded metadata into an index cache: magic, version,
+     * sources, PG count, time steps, then name sorted variable records
+     * [length 4][name 2+n][member ID 4][type 1][blocks count 8] with block
+     * records that are read without parsing characteristics, bitmap indices
+     * are copied as in metadata
+     * @param metadataSet with all variable entries decoded
+     * @param sources files the metadata describes
+     * @return index cache contents
+     */
+    std::vector<char>
+    GetIndexCache(const BP1ReadMetadataSet &metadataSet,
+                  const std::vector<BP1CacheSource> &sources) const;
+
+    /**
+     * Sets a metadata set from an index cache, variable records are decoded
+     * on first lookup as with ParseMetadata
+     * @param buffer whole index cache, e.g. mapped
+     * @param size of buffer
+     * @param metadataSet output
+     * @param sources output, to be checked by the caller
+     * @return false: not an index cache, a different cache version or a
+     * truncated or malformed record
+     */
+    bool ParseIndexCache(const char *buffer, const std::size_t size,
+                         BP1ReadMetadataSet &metadataSet,
+                         std::vector<BP1CacheSource> &sources) const;
+
+    /**
+     * Finds a variable index entry, decoding it on first lookup
+     * @param name variable name
+     * @param metadataSet from ParseMetadata, caches the decoded entry
+     * @return decoded entry in metadataSet, nullptr if not found
+     */
+    const BP1VarIndex *GetVarIndex(const std::string &name,
+                                   BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Finds an attribute index entry, decoding it on first lookup
+     * @param name attribute name
+     * @param metadataSet from ParseMetadata, caches the decoded entry
+     * @return decoded entry in metadataSet, nullptr if not found
+     */
+    const BP1VarIndex *GetAttributeIndex(const std::string &name,
+                                         BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Checks a variable index data type against a C++ type
+     * @param dataType from BP1VarIndex
+     * @return true: values can be read as T
+     */
+    template <class T>
+    bool IsDataType(const std::uint8_t dataType) const noexcept
+    {
+        return static_cast<std::uint8_t>(GetDataType<T>()) == dataType &&
+               GetDataType<T>() != type_unknown;
+    }
+
+    /**
+     * Blocks of a variable in a time step
+     * @param varIndex
+     * @param timeStep
+     * @return pointers to blocks in varIndex, in metadata order
+     */
+    std::vector<const BP1Block *>
+    GetStepBlocks(const BP1VarIndex &varIndex,
+                  const std::uint32_t timeStep) const noexcept;
+
+private:
+    void ParsePGIndex(BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Sets VarsOffsets from the variable name table after the attribute
+     * index, or by scanning the entry names if the table is not valid
+     */
+    void ParseVarsIndex(BP1ReadMetadataSet &metadataSet) const;
+
+    void ParseAttributesIndex(BP1ReadMetadataSet &metadataSet) const;
+
+    /**
+     * Reads the name of an index entry in place
+     * @param metadataSet
+     * @param position of the entry length
+     * @param length output name length
+     * @return first name character in metadataSet.Buffer
+     */
+    const char *GetEntryName(const BP1ReadMetadataSet &metadataSet,
+                             const std::size_t position,
+                             std::uint16_t &length) const;
+
+    /**
+     * Decodes an index cache variable record validated by ParseIndexCache
+     * @param metadataSet
+     * @param position of the record length
+     * @param index output
+     */
+    void ParseCacheEntry(const BP1ReadMetadataSet &metadataSet,
+                         std::size_t position, BP1VarIndex &index) const;
+
+    /**
+     * Decodes a variable or attribute index entry
+     * @param metadataSet
+     * @param position of the entry length
+     * @param index output
+     */
+    void ParseIndexEntry(const BP1ReadMetadataSet &metadataSet,
+                         std::size_t position, BP1VarIndex &index) const;
+
+    /**
+     * Decodes a characteristics set in metadata (no characteristic lengths)
+     * @param buffer metadata
+     * @param position at the characteristics count, updated past the set
+     * @param dataType variable data type, sets the value records size
+     * @param block output
+     */
+    void ParseCharacteristics(const char *buffer, std::size_t &position,
+                              const std::uint8_t dataType,
+                              BP1Block &block) const;
+
+    /**
+     * Size of value, min and max records for a data type, complex types
+     * use their real type
+     * @param dataType
+     * @return bytes, 0 if unknown
+     */
+    std::size_t GetValueSize(const std::uint8_t dataType) const noexcept;
+
+    /** Throws std::invalid_argument if position + size is beyond size */
+    void CheckBounds(const BP1ReadMetadataSet &metadataSet,
+                     const std::size_t position, const std::size_t size,
+                     const std::string hint) const;
+};
+
+} // end namespace format
+} // end namespace adios
+
+#endif /* BP1READER_H_ */
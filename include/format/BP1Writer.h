@@ -12,17 +12,21 @@
 #define BP1WRITER_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
-#include <algorithm> //std::count, std::copy, std::for_each
-#include <cmath>     //std::ceil
-#include <cstring>   //std::memcpy
+#include <algorithm>   //std::count, std::copy, std::for_each
+#include <cmath>       //std::ceil
+#include <cstring>     //std::memcpy
+#include <type_traits> //std::is_same
 /// \endcond
 
 #include "BP1.h"
+#include "BP1Aggregator.h"
+#include "Serializer.h"
 #include "capsule/heap/STLVector.h"
 #include "core/Capsule.h"
 #include "core/Profiler.h"
 #include "core/Variable.h"
 #include "functions/adiosFunctions.h"
+#include "functions/adiosSIMD.h"
 #include "functions/adiosTemplates.h"
 
 namespace adios
@@ -37,7 +41,11 @@ public:
     unsigned int m_Threads = 1; ///< number of threads for thread operations in
                                 /// large array (min,max)
     unsigned int m_Verbosity = 0;     ///< statistics verbosity, can change if
-                                      /// redefined in Engine method.
+                                      /// redefined in Engine method. 0: min
+                                      /// and max, 1-5 add characteristic_stat
+    unsigned int m_HistogramBins = 16; ///< statistic_hist bins at verbosity 5
+    unsigned int m_BitmapBins = 0; ///< characteristic_bitmap bins, 0: off
+    bool m_DebugMode = false; ///< true: serializer bounds checks, slower
     float m_GrowthFactor = 1.5;       ///< memory growth factor, can change if
                                       /// redefined in Engine method.
     const std::uint8_t m_Version = 3; ///< BP format version
@@ -70,51 +78,19 @@ public:
         const bool isFortran, const std::string name,
         const std::uint32_t processID,
         const std::vector<std::shared_ptr<Transport>> &transports,
-        capsule::STLVector &heap, BP1MetadataSet &metadataSet) const noexcept;
+        capsule::STLVector &heap, BP1MetadataSet &metadataSet) const;
 
     /**
-     * Returns the estimated variable index size
-     * @param group
-     * @param variableName
+     * Returns an upper bound of the variable metadata size in data, used to
+     * reserve buffer space
      * @param variable
-     * @param verbosity
      * @return variable index size
      */
     template <class T>
     size_t GetVariableIndexSize(const Variable<T> &variable) const noexcept
     {
-        // size_t indexSize = varEntryLength + memberID + lengthGroupName +
-        // groupName + lengthVariableName + lengthOfPath + path + datatype
-        size_t indexSize = 23; // without characteristics
-        indexSize += variable.m_Name.size();
-
-        // characteristics 3 and 4, check variable number of dimensions
-        const std::size_t dimensions =
-            variable.DimensionsSize(); // number of commas in CSV + 1
-        indexSize += 28 * dimensions;  // 28 bytes per dimension
-        indexSize += 1;                // id
-
-        // characteristics, offset + payload offset in data
-        indexSize += 2 * (1 + 8);
-        // characteristic 0, if scalar add value, for now only allowing string
-        if (dimensions == 1)
-        {
-            indexSize += sizeof(T);
-            indexSize += 1; // id
-            // must have an if here
-            indexSize += 2 + variable.m_Name.size();
-            indexSize += 1; // id
-        }
-
-        // characteristic statistics
-        if (m_Verbosity == 0) // default, only min and max
-        {
-            indexSize += 2 * (sizeof(T) + 1);
-            indexSize += 1 + 1; // id
-        }
-
-        return indexSize + 12; /// extra 12 bytes in case of attributes
-                               // need to add transform characteristics
+        return GetVariableMetadataInDataSize(variable) +
+               12; /// extra 12 bytes in case of attributes
     }
 
     /**
@@ -127,7 +103,6 @@ public:
     inline void WriteVariableMetadata(const Variable<T> &variable,
                                       capsule::STLVector &heap,
                                       BP1MetadataSet &metadataSet) const
-        noexcept
     {
         Stats<T> stats = GetStats(variable);
         WriteVariableMetadataCommon(variable, stats, heap, metadataSet);
@@ -142,42 +117,109 @@ public:
     template <class T>
     void WriteVariableMetadata(const Variable<std::complex<T>> &variable,
                                capsule::STLVector &heap,
-                               BP1MetadataSet &metadataSet) const noexcept
+                               BP1MetadataSet &metadataSet) const
     {
         Stats<T> stats = GetStats(variable);
         WriteVariableMetadataCommon(variable, stats, heap, metadataSet);
     }
 
     /**
-     * Expensive part this is only for heap buffers need to adapt to vector of
-     * capsules
+     * Records the payload as an extent of application memory instead of
+     * copying it, metadata must be written first with WriteVariableMetadata.
+     * Application memory must not change until the heap is written.
      * @param variable
-     * @param buffer
+     * @param heap
      */
     template <class T>
-    void WriteVariablePayload(const Variable<T> &variable,
-                              capsule::STLVector &heap,
-                              const unsigned int nthreads = 1) const noexcept
+    void WriteVariableDeferred(const Variable<T> &variable,
+                               capsule::STLVector &heap) const
     {
-        // EXPENSIVE part, might want to use threads if large, serial for now
-        CopyToBuffer(heap.m_Data, variable.m_AppValues, variable.TotalSize());
-        heap.m_DataAbsolutePosition += variable.PayLoadSize();
+        const std::size_t payloadSize = variable.PayLoadSize();
+        heap.m_Extents.push_back(
+            {heap.m_Data.size(),
+             reinterpret_cast<const char *>(variable.m_AppValues),
+             payloadSize});
+        heap.m_DataAbsolutePosition += payloadSize;
+    }
+
+    /**
+     * Writes variable metadata and payload to the heap buffer in a single pass
+     * over the application values, min and max are computed while copying
+     * and backfilled in the metadata characteristics in data.
+     * Version for primitive types (except std::complex<T>)
+     * @param variable
+     * @param heap
+     * @param metadataSet
+     * @param nthreads large payloads are processed with up to nthreads threads
+     */
+    template <class T>
+    void WriteVariable(const Variable<T> &variable, capsule::STLVector &heap,
+                       BP1MetadataSet &metadataSet,
+                       const unsigned int nthreads = 1) const
+    {
+        Stats<T> stats = Stats<T>();
+        WriteVariableFused(variable, stats, heap, metadataSet, nthreads);
+    }
+
+    /**
+     * Overloaded version for std::complex<T> variables
+     * @param variable
+     * @param heap
+     * @param metadataSet
+     * @param nthreads large payloads are processed with up to nthreads threads
+     */
+    template <class T>
+    void WriteVariable(const Variable<std::complex<T>> &variable,
+                       capsule::STLVector &heap, BP1MetadataSet &metadataSet,
+                       const unsigned int nthreads = 1) const
+    {
+        Stats<T> stats = Stats<T>();
+        WriteVariableFused(variable, stats, heap, metadataSet, nthreads);
     }
 
     void Advance(BP1MetadataSet &metadataSet, capsule::STLVector &buffer);
 
     /**
-     * Function that sets metadata (if first close) and writes to a single
+     * Closes the current process group (if open) without advancing the time
+     * step, writes the heap data buffer to all transports and resets the heap
+     * relative positions. The absolute position is kept, so offsets in
+     * metadata remain valid for the next process group in the same step.
+     * @param metadataSet current rank metadata set
+     * @param heap contains data buffer, empty after the call
+     * @param transports all heap data is written to each transport
+     * @param payload optional, payload of the last variable in the current
+     * process group written directly from application memory (not buffered)
+     * @param payloadSize payload size in bytes, 0 if payload is nullptr
+     */
+    void Flush(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
+               const std::vector<std::shared_ptr<Transport>> &transports,
+               const char *payload = nullptr,
+               const std::size_t payloadSize = 0) const;
+
+    /**
+     * N-to-N version, sets metadata (if first close) and writes to a single
      * transport
      * @param metadataSet current rank metadata set
      * @param heap contains data buffer
      * @param transport does a write after data and metadata is setup
      * @param isFirstClose true: metadata has been set and aggregated
-     * @param doAggregation true: for N-to-M, false: for N-to-N
      */
     void Close(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
-               Transport &transport, bool &isFirstClose,
-               const bool doAggregation) const noexcept;
+               Transport &transport, bool &isFirstClose) const;
+
+    /**
+     * N-to-M version, collective. Offsets are shifted to the rank position in
+     * its subfile, the aggregator writes its group data and the merged group
+     * metadata to transports and closes them. At return heap contains the
+     * subfile metadata in aggregators and nothing in other ranks.
+     * @param metadataSet current rank metadata set
+     * @param heap contains data buffer
+     * @param transports opened in aggregators only
+     * @param aggregator with initialized subfiles
+     */
+    void Close(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
+               const std::vector<std::shared_ptr<Transport>> &transports,
+               BP1Aggregator &aggregator) const;
 
     /**
      * Writes the ADIOS log information (buffering, open, write and close) for a
@@ -193,13 +235,98 @@ public:
         const std::vector<std::shared_ptr<Transport>> &transports) const
         noexcept;
 
+    /**
+     * Merges the flattened metadata (footers) of all ranks into a single
+     * global metadata buffer with the same layout as a rank footer. PG,
+     * variable and attribute indices from all ranks are merged by name, each
+     * characteristics set gets a characteristic_file_index with its rank file
+     * @param rankMetadata footers in rank order, from
+     * BP1Aggregator::GatherBuffers, empty footers are skipped
+     * @param rankSizes size of each rank footer
+     * @param fileIndices file of each rank footer, empty: no file index is
+     * added
+     * @param heap output, metadata is flattened at the end of heap.m_Data
+     * from heap.m_DataAbsolutePosition
+     */
+    void AggregateMetadata(const std::vector<char> &rankMetadata,
+                           const std::vector<std::size_t> &rankSizes,
+                           const std::vector<std::uint32_t> &fileIndices,
+                           capsule::STLVector &heap) const;
+
 private:
+    /**
+     * Writes heap data with its deferred extents in place, a single gather
+     * write if there are extents
+     * @param heap
+     * @param transport
+     */
+    void WriteHeap(const capsule::STLVector &heap, Transport &transport) const;
+
+    /**
+     * Upper bound of a characteristics set size, in data or in metadata
+     * @param variable
+     * @return bytes
+     */
+    template <class T>
+    std::size_t GetCharacteristicsSize(const Variable<T> &variable) const
+        noexcept
+    {
+        const std::size_t dimensions = variable.m_Dimensions.size();
+        std::size_t size = 1 + 4;             // count and length
+        size += 1 + 2 + 1 + 2 + 27 * dimensions; // dimensions
+        size += 2 * (1 + 2 + sizeof(T));        // value, or min and max
+        if (m_Verbosity > 0)
+        {
+            size += 1 + 2 + 1;                     // id, length, count
+            size += 3 * (1 + 8) + (1 + 1);         // cnt, sum, sum_square, finite
+            size += 1 + 2 + 8 * m_HistogramBins;   // hist
+        }
+        size += 1 + 2 + 4;   // time index
+        size += 2 * (1 + 8); // offset and payload offset in metadata
+        return size;
+    }
+
+    /**
+     * Upper bound of the variable metadata size in data, without payload
+     * @param variable
+     * @return bytes
+     */
+    template <class T>
+    std::size_t GetVariableMetadataInDataSize(const Variable<T> &variable) const
+        noexcept
+    {
+        // var length + memberID + name + path + type + isDimension
+        std::size_t size = 8 + 4 + 2 + variable.m_Name.size() + 2 + 1 + 1;
+        size += 1 + 2 + 27 * variable.m_Dimensions.size(); // dimensions
+        return size + GetCharacteristicsSize(variable);
+    }
+
+    /**
+     * Upper bound of the variable metadata size in its index
+     * @param variable
+     * @param isNew true: includes the variable header
+     * @return bytes
+     */
+    template <class T>
+    std::size_t GetVariableMetadataInIndexSize(const Variable<T> &variable,
+                                               const bool isNew) const noexcept
+    {
+        std::size_t size = GetCharacteristicsSize(variable);
+        if (isNew == true)
+        {
+            // length + memberID + group + name + path + type + sets count
+            size += 4 + 4 + 2 + 2 + variable.m_Name.size() + 2 + 1 + 8;
+        }
+        return size;
+    }
+
     template <class T, class U>
     void WriteVariableMetadataCommon(const Variable<T> &variable,
                                      Stats<U> &stats, capsule::STLVector &heap,
-                                     BP1MetadataSet &metadataSet) const noexcept
+                                     BP1MetadataSet &metadataSet) const
     {
         stats.TimeIndex = metadataSet.TimeStep;
+        ComputeBitmap(variable, stats);
 
         // Get new Index or point to existing index
         bool isNew = true; // flag to check if variable is new
@@ -209,7 +336,14 @@ private:
 
         // write metadata header in data and extract offsets
         stats.Offset = heap.m_DataAbsolutePosition;
-        WriteVariableMetadataInData(variable, stats, heap);
+        {
+            Serializer serializer(heap.m_Data,
+                                  GetVariableMetadataInDataSize(variable),
+                                  m_DebugMode);
+            const std::size_t start = serializer.Position();
+            WriteVariableMetadataInData(variable, stats, serializer);
+            heap.m_DataAbsolutePosition += serializer.Position() - start;
+        }
         stats.PayloadOffset = heap.m_DataAbsolutePosition;
 
         // write to metadata  index
@@ -219,103 +353,167 @@ private:
     }
 
     template <class T, class U>
-    void WriteVariableMetadataInData(const Variable<T> &variable,
-                                     const Stats<U> &stats,
-                                     capsule::STLVector &heap) const noexcept
+    void WriteVariableFused(const Variable<T> &variable, Stats<U> &stats,
+                            capsule::STLVector &heap,
+                            BP1MetadataSet &metadataSet,
+                            const unsigned int nthreads) const
     {
-        auto &buffer = heap.m_Data;
+        stats.TimeIndex = metadataSet.TimeStep;
+
+        bool isNew = true;
+        BP1Index &varIndex =
+            GetBP1Index(variable.m_Name, metadataSet.VarsIndices, isNew);
+        stats.MemberID = varIndex.MemberID;
+
+        // metadata in data with placeholder bounds, same size as final ones
+        if (m_Verbosity >= 5 && variable.m_IsScalar == false)
+            stats.Histogram.resize(m_HistogramBins);
+
+        // metadata and payload in a single reservation
+        const std::size_t payloadSize = variable.PayLoadSize();
+        Serializer serializer(heap.m_Data,
+                              GetVariableMetadataInDataSize(variable) +
+                                  payloadSize,
+                              m_DebugMode);
+        const std::size_t start = serializer.Position();
+
+        stats.Offset = heap.m_DataAbsolutePosition;
+        const std::size_t boundsPosition =
+            WriteVariableMetadataInData(variable, stats, serializer);
+        stats.PayloadOffset =
+            heap.m_DataAbsolutePosition + serializer.Position() - start;
 
+        // single pass over values: payload copy and stats
+        ComputeStats(variable, stats, serializer.Reserve(payloadSize),
+                     nthreads);
+        ComputeBitmap(variable, stats);
+        heap.m_DataAbsolutePosition += serializer.Position() - start;
+
+        BackfillBoundsRecord(variable, stats, boundsPosition, serializer);
+
+        // metadata index is written with final stats
+        WriteVariableMetadataInIndex(variable, stats, isNew, varIndex);
+
+        ++metadataSet.DataPGVarsCount;
+    }
+
+    /**
+     * Writes the metadata header in data, variable length includes the
+     * payload
+     * @param variable
+     * @param stats
+     * @param serializer reserved with GetVariableMetadataInDataSize
+     * @return position in heap data of the bounds characteristics
+     */
+    template <class T, class U>
+    std::size_t WriteVariableMetadataInData(const Variable<T> &variable,
+                                            const Stats<U> &stats,
+                                            Serializer &serializer) const
+    {
         const std::size_t varLengthPosition =
-            buffer.size(); // capture initial position for variable length
-        buffer.insert(buffer.end(), 8, 0);              // skip var length (8)
-        CopyToBuffer(buffer, &stats.MemberID);          // memberID
-        WriteNameRecord(variable.m_Name, buffer);       // variable name
-        buffer.insert(buffer.end(), 2, 0);              // skip path
+            serializer.Position(); // capture initial position for variable
+                                   // length
+        serializer.Skip(8);                             // skip var length (8)
+        serializer.Write(&stats.MemberID);              // memberID
+        WriteNameRecord(variable.m_Name, serializer);   // variable name
+        serializer.Skip(2);                             // skip path
         const std::uint8_t dataType = GetDataType<T>(); // dataType
-        CopyToBuffer(buffer, &dataType);
+        serializer.Write(&dataType);
         constexpr char no = 'n'; // isDimension
-        CopyToBuffer(buffer, &no);
+        serializer.Write(&no);
 
         // write variable dimensions
         const std::uint8_t dimensions = variable.m_Dimensions.size();
-        CopyToBuffer(buffer, &dimensions); // count
+        serializer.Write(&dimensions); // count
         std::uint16_t dimensionsLength =
             27 *
             dimensions; // 27 is from 9 bytes for each: var y/n + local, var
                         // y/n + global dimension, var y/n + global offset,
                         // changed for characteristic
-        CopyToBuffer(buffer, &dimensionsLength); // length
-        WriteDimensionsRecord(buffer, variable.m_Dimensions,
+        serializer.Write(&dimensionsLength); // length
+        WriteDimensionsRecord(serializer, variable.m_Dimensions,
                               variable.m_GlobalDimensions,
                               variable.m_GlobalOffsets, 18, true);
 
         // CHARACTERISTICS
-        WriteVariableCharacteristics(variable, stats, buffer, true);
+        const std::size_t boundsPosition =
+            WriteVariableCharacteristics(variable, stats, serializer, true);
 
         // Back to varLength including payload size
-        const std::uint64_t varLength = buffer.size() - varLengthPosition +
+        const std::uint64_t varLength = serializer.Position() -
+                                        varLengthPosition +
                                         variable.PayLoadSize() -
                                         8; // remove its own size
-        CopyToBuffer(buffer, varLengthPosition, &varLength); // length
-
-        heap.m_DataAbsolutePosition +=
-            buffer.size() - varLengthPosition; // update absolute position to be
-                                               // used as payload position
+        serializer.WriteAt(varLengthPosition, &varLength); // length
+        return boundsPosition;
     }
 
     template <class T, class U>
     void WriteVariableMetadataInIndex(const Variable<T> &variable,
                                       const Stats<U> &stats, const bool isNew,
-                                      BP1Index &index) const noexcept
+                                      BP1Index &index) const
     {
-        auto &buffer = index.Buffer;
+        Serializer serializer(index.Buffer,
+                              GetVariableMetadataInIndexSize(variable, isNew) +
+                                  GetBitmapRecordSize(stats),
+                              m_DebugMode);
 
         if (isNew == true) // write variable header (might be shared with
                            // attributes index)
         {
-            buffer.insert(buffer.end(), 4, 0); // skip var length (4)
-            CopyToBuffer(buffer, &stats.MemberID);
-            buffer.insert(buffer.end(), 2, 0); // skip group name
-            WriteNameRecord(variable.m_Name, buffer);
-            buffer.insert(buffer.end(), 2, 0); // skip path
+            serializer.Skip(4); // skip var length (4)
+            serializer.Write(&stats.MemberID);
+            serializer.Skip(2); // skip group name
+            WriteNameRecord(variable.m_Name, serializer);
+            serializer.Skip(2); // skip path
 
             const std::uint8_t dataType = GetDataType<T>();
-            CopyToBuffer(buffer, &dataType);
+            serializer.Write(&dataType);
 
             // Characteristics Sets Count in Metadata
             index.Count = 1;
-            CopyToBuffer(buffer, &index.Count);
+            serializer.Write(&index.Count);
         }
         else // update characteristics sets count
         {
             const std::size_t characteristicsSetsCountPosition =
                 15 + variable.m_Name.size();
             ++index.Count;
-            CopyToBuffer(buffer, characteristicsSetsCountPosition,
-                         &index.Count); // test
+            serializer.WriteAt(characteristicsSetsCountPosition,
+                               &index.Count); // test
         }
 
-        WriteVariableCharacteristics(variable, stats, buffer);
+        WriteVariableCharacteristics(variable, stats, serializer);
+
+        // offset and payload offset records close the characteristics set
+        const std::size_t end = serializer.Position();
+        index.OffsetPositions.push_back(end - 8 - 1 - 8);
+        index.OffsetPositions.push_back(end - 8);
     }
 
+    /**
+     * Writes the characteristics set of a variable block
+     * @param variable
+     * @param stats
+     * @param serializer
+     * @param addLength true for data, false for metadata
+     * @return position in buffer of the bounds (value or min, max) records
+     */
     template <class T, class U>
-    void WriteVariableCharacteristics(const Variable<T> &variable,
-                                      const Stats<U> &stats,
-                                      std::vector<char> &buffer,
-                                      const bool addLength = false) const
-        noexcept
+    std::size_t WriteVariableCharacteristics(const Variable<T> &variable,
+                                             const Stats<U> &stats,
+                                             Serializer &serializer,
+                                             const bool addLength = false) const
     {
         const std::size_t characteristicsCountPosition =
-            buffer.size(); // very important to track as writer is going
-                           // back to
-                           // this position
-        buffer.insert(buffer.end(), 5,
-                      0); // skip characteristics count(1) + length (4)
+            serializer.Position(); // very important to track as writer is
+                                   // going back to this position
+        serializer.Skip(5); // skip characteristics count(1) + length (4)
         std::uint8_t characteristicsCounter = 0;
 
         // DIMENSIONS
         std::uint8_t characteristicID = characteristic_dimensions;
-        CopyToBuffer(buffer, &characteristicID);
+        serializer.Write(&characteristicID);
         const std::uint8_t dimensions = variable.m_Dimensions.size();
 
         if (addLength == true)
@@ -323,62 +521,64 @@ private:
             const std::int16_t lengthOfDimensionsCharacteristic =
                 24 * dimensions +
                 3; // 24 = 3 local, global, global offset x 8 bytes/each
-            CopyToBuffer(buffer, &lengthOfDimensionsCharacteristic);
+            serializer.Write(&lengthOfDimensionsCharacteristic);
         }
 
-        CopyToBuffer(buffer, &dimensions); // count
+        serializer.Write(&dimensions); // count
         const std::uint16_t dimensionsLength = 24 * dimensions;
-        CopyToBuffer(buffer, &dimensionsLength); // length
-        WriteDimensionsRecord(buffer, variable.m_Dimensions,
+        serializer.Write(&dimensionsLength); // length
+        WriteDimensionsRecord(serializer, variable.m_Dimensions,
                               variable.m_GlobalDimensions,
                               variable.m_GlobalOffsets, 16, addLength);
         ++characteristicsCounter;
 
         // VALUE for SCALAR or STAT min, max for ARRAY
-        WriteBoundsRecord(variable.m_IsScalar, stats, buffer,
+        const std::size_t boundsPosition = serializer.Position();
+        WriteBoundsRecord(variable.m_IsScalar, stats, serializer,
                           characteristicsCounter, addLength);
         // TIME INDEX
         WriteCharacteristicRecord(characteristic_time_index, stats.TimeIndex,
-                                  buffer, characteristicsCounter, addLength);
+                                  serializer, characteristicsCounter,
+                                  addLength);
 
         if (addLength == false) // only in metadata offset and payload offset
         {
+            WriteBitmapRecord(stats, serializer, characteristicsCounter);
             WriteCharacteristicRecord(characteristic_offset, stats.Offset,
-                                      buffer, characteristicsCounter);
+                                      serializer, characteristicsCounter);
             WriteCharacteristicRecord(characteristic_payload_offset,
-                                      stats.PayloadOffset, buffer,
+                                      stats.PayloadOffset, serializer,
                                       characteristicsCounter);
         }
         // END OF CHARACTERISTICS
 
         // Back to characteristics count and length
-        CopyToBuffer(buffer, characteristicsCountPosition,
-                     &characteristicsCounter); // count (1)
+        serializer.WriteAt(characteristicsCountPosition,
+                           &characteristicsCounter); // count (1)
         const std::uint32_t characteristicsLength =
-            buffer.size() - characteristicsCountPosition - 4 -
+            serializer.Position() - characteristicsCountPosition - 4 -
             1; // remove its own length (4 bytes) + characteristic counter (
                // 1 byte
                // )
-        CopyToBuffer(buffer, characteristicsCountPosition + 1,
-                     &characteristicsLength); // length
+        serializer.WriteAt(characteristicsCountPosition + 1,
+                           &characteristicsLength); // length
+        return boundsPosition;
     }
 
     /**
-     * Writes from &buffer[position]:  [2
+     * Writes at the serializer cursor:  [2
      * bytes:string.length()][string.length():
      * string.c_str()]
      * @param name
-     * @param buffer
-     * @param position
+     * @param serializer
      */
-    void WriteNameRecord(const std::string name,
-                         std::vector<char> &buffer) const noexcept;
+    void WriteNameRecord(const std::string &name,
+                         Serializer &serializer) const;
 
     /**
      * Write a dimension record for a global variable used by
      * WriteVariableCommon
-     * @param buffer
-     * @param position
+     * @param serializer
      * @param localDimensions
      * @param globalDimensions
      * @param globalOffsets
@@ -386,12 +586,12 @@ private:
      * data
      * characteristic
      */
-    void WriteDimensionsRecord(std::vector<char> &buffer,
+    void WriteDimensionsRecord(Serializer &serializer,
                                const std::vector<std::size_t> &localDimensions,
                                const std::vector<std::size_t> &globalDimensions,
                                const std::vector<std::size_t> &globalOffsets,
                                const unsigned int skip,
-                               const bool addType = false) const noexcept;
+                               const bool addType = false) const;
 
     /**
      * GetStats for primitive types except std::complex<T> types
@@ -401,22 +601,8 @@ private:
     template <class T>
     Stats<T> GetStats(const Variable<T> &variable) const noexcept
     {
-        Stats<T> stats;
-        const std::size_t valuesSize = variable.TotalSize();
-
-        if (m_Verbosity == 0)
-        {
-            if (valuesSize >=
-                10000000) // ten million? this needs actual results
-                          // //here we can make decisions for threads
-                          // based on valuesSize
-                GetMinMax(variable.m_AppValues, valuesSize, stats.Min,
-                          stats.Max,
-                          m_Threads); // here we can add cores from constructor
-            else
-                GetMinMax(variable.m_AppValues, valuesSize, stats.Min,
-                          stats.Max);
-        }
+        Stats<T> stats = Stats<T>();
+        ComputeStats(variable, stats, nullptr, m_Threads);
         return stats;
     }
 
@@ -428,73 +614,256 @@ private:
     template <class T>
     Stats<T> GetStats(const Variable<std::complex<T>> &variable) const noexcept
     {
-        Stats<T> stats;
+        Stats<T> stats = Stats<T>();
+        ComputeStats(variable, stats, nullptr, m_Threads);
+        return stats;
+    }
+
+    /**
+     * Computes min, max and the extended statistics enabled by m_Verbosity in
+     * a single pass over the variable values
+     * @param variable
+     * @param stats
+     * @param destination if not nullptr values are copied to it in the same
+     * pass
+     * @param nthreads kernel uses up to nthreads only for large arrays
+     */
+    template <class T, class U>
+    void ComputeStats(const Variable<T> &variable, Stats<U> &stats,
+                      char *destination, const unsigned int nthreads) const
+        noexcept
+    {
         const std::size_t valuesSize = variable.TotalSize();
+        Moments moments;
+        Moments *momentsPtr =
+            (m_Verbosity > 0 && variable.m_IsScalar == false) ? &moments
+                                                               : nullptr;
 
-        if (m_Verbosity == 0)
+        if (destination == nullptr)
         {
-            if (valuesSize >=
-                10000000) // ten million? this needs actual results
-                          // //here we can make decisions for threads
-                          // based on valuesSize
-                GetMinMax(variable.m_AppValues, valuesSize, stats.Min,
-                          stats.Max,
-                          m_Threads); // here we can add cores from constructor
-            else
-                GetMinMax(variable.m_AppValues, valuesSize, stats.Min,
-                          stats.Max);
+            GetMinMax(variable.m_AppValues, valuesSize, stats.Min, stats.Max,
+                      nthreads, momentsPtr);
         }
-        return stats;
+        else
+        {
+            MemcpyMinMax(destination, variable.m_AppValues, valuesSize,
+                         stats.Min, stats.Max, nthreads, momentsPtr);
+        }
+
+        if (momentsPtr == nullptr)
+            return;
+
+        stats.Count = moments.Count;
+        stats.Sum = moments.Sum;
+        stats.SumSquare = moments.SumSquare;
+        stats.Finite = (moments.Finite == true) ? 1 : 0;
+
+        if (m_Verbosity >= 5) // needs min and max, second pass
+        {
+            stats.Histogram.resize(m_HistogramBins);
+            GetHistogram(variable.m_AppValues, valuesSize, stats.Min,
+                         stats.Max, stats.Histogram);
+        }
+    }
+
+    /**
+     * Builds the bitmap index of an array block if m_BitmapBins > 0, a
+     * second pass over values that needs min and max. Complex values have no
+     * order and no index.
+     * @param variable
+     * @param stats min and max input, Bitmap and BitmapBinWords output
+     */
+    template <class T, class U>
+    void ComputeBitmap(const Variable<T> &variable, Stats<U> &stats) const
+    {
+        if (m_BitmapBins == 0 || variable.m_IsScalar == true ||
+            std::is_same<T, U>::value == false)
+            return;
+
+        GetBitmapIndex(variable.m_AppValues, variable.TotalSize(), stats.Min,
+                       stats.Max, m_BitmapBins, stats.Bitmap,
+                       stats.BitmapBinWords);
+    }
+
+    /**
+     * Size of the characteristic_bitmap record written by WriteBitmapRecord
+     * @param stats
+     * @return bytes, 0 if there is no bitmap index
+     */
+    template <class T>
+    std::size_t GetBitmapRecordSize(const Stats<T> &stats) const noexcept
+    {
+        if (stats.BitmapBinWords.empty() == true)
+            return 0;
+        return 1 + 4 + 2 + 4 * stats.BitmapBinWords.size() +
+               4 * stats.Bitmap.size();
+    }
+
+    /**
+     * Writes characteristic_bitmap, only in metadata and before the offset
+     * records: [id 1][length 4][bins 2][bins x words 4][words x 4], words of
+     * each bin are a WAH compressed bitmap of the block elements in the bin.
+     * Bins have equal width between min and max, see GetBin.
+     * @param stats
+     * @param serializer
+     * @param characteristicsCounter to be updated by 1 if written
+     */
+    template <class T>
+    void WriteBitmapRecord(const Stats<T> &stats, Serializer &serializer,
+                           std::uint8_t &characteristicsCounter) const
+    {
+        if (stats.BitmapBinWords.empty() == true)
+            return;
+
+        const std::uint8_t id = characteristic_bitmap;
+        serializer.Write(&id);
+        const std::uint32_t length =
+            static_cast<std::uint32_t>(GetBitmapRecordSize(stats) - 1 - 4);
+        serializer.Write(&length);
+        const std::uint16_t bins = stats.BitmapBinWords.size();
+        serializer.Write(&bins);
+        serializer.Write(stats.BitmapBinWords.data(), bins);
+        serializer.Write(stats.Bitmap.data(), stats.Bitmap.size());
+        ++characteristicsCounter;
     }
 
     template <class T>
     void WriteBoundsRecord(const bool isScalar, const Stats<T> &stats,
-                           std::vector<char> &buffer,
+                           Serializer &serializer,
                            std::uint8_t &characteristicsCounter,
-                           const bool addLength) const noexcept
+                           const bool addLength) const
     {
         if (isScalar == true)
         {
-            WriteCharacteristicRecord(
-                characteristic_value, stats.Min, buffer, characteristicsCounter,
-                addLength); // stats.min = stats.max = value
+            WriteCharacteristicRecord(characteristic_value, stats.Min,
+                                      serializer, characteristicsCounter,
+                                      addLength); // stats.min = stats.max =
+                                                  // value
             return;
         }
 
-        if (m_Verbosity == 0) // default verbose
+        WriteCharacteristicRecord(characteristic_min, stats.Min, serializer,
+                                  characteristicsCounter, addLength);
+        WriteCharacteristicRecord(characteristic_max, stats.Max, serializer,
+                                  characteristicsCounter, addLength);
+
+        if (m_Verbosity > 0)
+        {
+            WriteStatRecord(stats, serializer, characteristicsCounter,
+                            addLength);
+        }
+    }
+
+    /**
+     * Writes characteristic_stat with the statistics enabled by m_Verbosity:
+     * [count 1] and for each statistic [VariableStatistics id 1][value]
+     * 1: cnt (uint64), 2: + sum (double), 3: + sum_square (double),
+     * 4: + finite (uint8), 5: + hist ([bins 2][bins x uint64 frequencies])
+     * @param stats
+     * @param serializer
+     * @param characteristicsCounter to be updated by 1
+     * @param addLength true for data, false for metadata
+     */
+    template <class T>
+    void WriteStatRecord(const Stats<T> &stats, Serializer &serializer,
+                         std::uint8_t &characteristicsCounter,
+                         const bool addLength) const
+    {
+        const std::uint8_t id = characteristic_stat;
+        serializer.Write(&id);
+
+        const std::size_t lengthPosition = serializer.Position();
+        if (addLength == true)
+        {
+            serializer.Skip(2); // skip length (2)
+        }
+
+        const std::uint8_t statsCount =
+            (m_Verbosity < 5) ? m_Verbosity : 5; // one statistic per level
+        serializer.Write(&statsCount);
+
+        WriteStatistic(statistic_cnt, stats.Count, serializer);
+        if (m_Verbosity >= 2)
+            WriteStatistic(statistic_sum, stats.Sum, serializer);
+        if (m_Verbosity >= 3)
+            WriteStatistic(statistic_sum_square, stats.SumSquare, serializer);
+        if (m_Verbosity >= 4)
+            WriteStatistic(statistic_finite, stats.Finite, serializer);
+        if (m_Verbosity >= 5)
+        {
+            const std::uint8_t statisticID = statistic_hist;
+            serializer.Write(&statisticID);
+            const std::uint16_t bins = stats.Histogram.size();
+            serializer.Write(&bins);
+            serializer.Write(stats.Histogram.data(), bins);
+        }
+
+        if (addLength == true)
+        {
+            const std::uint16_t length =
+                serializer.Position() - lengthPosition - 2;
+            serializer.WriteAt(lengthPosition, &length);
+        }
+        ++characteristicsCounter;
+    }
+
+    template <class T>
+    void WriteStatistic(const std::uint8_t statisticID, const T &value,
+                        Serializer &serializer) const
+    {
+        serializer.Write(&statisticID);
+        serializer.Write(&value);
+    }
+
+    /**
+     * Overwrites the placeholder records written by WriteBoundsRecord with
+     * addLength = true, records have the same size for any stats values
+     * @param variable
+     * @param stats final values
+     * @param position of the first bounds record
+     * @param serializer
+     */
+    template <class T, class U>
+    void BackfillBoundsRecord(const Variable<T> &variable,
+                              const Stats<U> &stats, const std::size_t position,
+                              Serializer &serializer) const
+    {
+        std::vector<char> records;
         {
-            WriteCharacteristicRecord(characteristic_min, stats.Min, buffer,
-                                      characteristicsCounter, addLength);
-            WriteCharacteristicRecord(characteristic_max, stats.Max, buffer,
-                                      characteristicsCounter, addLength);
+            Serializer recordsSerializer(records,
+                                         GetCharacteristicsSize(variable),
+                                         m_DebugMode);
+            std::uint8_t characteristicsCounter = 0; // already counted
+            WriteBoundsRecord(variable.m_IsScalar, stats, recordsSerializer,
+                              characteristicsCounter, true);
         }
+        serializer.WriteAt(position, records.data(), records.size());
     }
 
     /**
      * Write a characteristic value record to buffer
      * @param id
      * @param value
-     * @param buffers
-     * @param positions
+     * @param serializer
      * @param characvteristicsCounter to be updated by 1
      * @param addLength true for data, false for metadata
      */
     template <class T>
     void WriteCharacteristicRecord(const std::uint8_t characteristicID,
-                                   const T &value, std::vector<char> &buffer,
+                                   const T &value, Serializer &serializer,
                                    std::uint8_t &characteristicsCounter,
-                                   const bool addLength = false) const noexcept
+                                   const bool addLength = false) const
     {
         const std::uint8_t id = characteristicID;
-        CopyToBuffer(buffer, &id);
+        serializer.Write(&id);
 
         if (addLength == true)
         {
             const std::uint16_t lengthOfCharacteristic = sizeof(T); // id
-            CopyToBuffer(buffer, &lengthOfCharacteristic);
+            serializer.Write(&lengthOfCharacteristic);
         }
 
-        CopyToBuffer(buffer, &value);
+        serializer.Write(&value);
         ++characteristicsCounter;
     }
 
@@ -512,6 +881,26 @@ private:
                           std::unordered_map<std::string, BP1Index> &indices,
                           bool &isNew) const noexcept;
 
+    /**
+     * Fills the current pg length, vars count and vars length, without
+     * attributes, and closes the process group
+     * @param metadataSet
+     * @param heap
+     * @param payloadSize bytes written after the buffer and before attributes
+     */
+    void CloseProcessGroup(BP1MetadataSet &metadataSet,
+                           capsule::STLVector &heap,
+                           const std::size_t payloadSize = 0) const;
+
+    /**
+     * Adds shift to all absolute offsets in metadata indices, at
+     * BP1Index::OffsetPositions
+     * @param metadataSet
+     * @param shift
+     */
+    void ShiftOffsets(BP1MetadataSet &metadataSet,
+                      const std::uint64_t shift) const;
+
     /**
      * Flattens the data and fills the pg length, vars count, vars length and
      * attributes
@@ -519,17 +908,20 @@ private:
      * @param buffer
      */
     void FlattenData(BP1MetadataSet &metadataSet,
-                     capsule::STLVector &buffer) const noexcept;
+                     capsule::STLVector &buffer) const;
 
     /**
-     * Flattens the metadata indices into a single metadata buffer in capsule
+     * Flattens the metadata indices into a single metadata buffer in capsule.
+     * Variable and attribute indices are written sorted by name, followed by
+     * the variable name table: [count 4][length 8][count x offset 8], absolute
+     * offsets of the sorted variable index entries
      * @param metadataSet
      * @param buffer
      */
     void FlattenMetadata(BP1MetadataSet &metadataSet,
-                         capsule::STLVector &buffer) const
-        noexcept; ///< sets the metadata buffer in capsule with indices and
-                  /// minifooter
+                         capsule::STLVector &buffer)
+        const; ///< sets the metadata buffer in capsule with indices and
+               /// minifooter
 };
 
 } // end namespace format
@@ -0,0 +1,151 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * Serializer.h writes records through a raw cursor into space reserved at the
+ * end of a std::vector<char> buffer, bounds are checked only in debug mode.
+ * Buffers with capsule::DefaultInitAllocator reserve without zero filling.
+ *
+ *  Created on: Apr 24, 2017
+ *      Author: wfg
+ */
+
+#ifndef SERIALIZER_H_
+#define SERIALIZER_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstring> //std::memcpy
+#include <string>
+#include <vector>
+/// \endcond
+
+namespace adios
+{
+namespace format
+{
+
+class Serializer
+{
+
+public:
+    /**
+     * Reserves space at the end of buffer in a single resize, reserved bytes
+     * are zero only for the default std::allocator. The buffer must not be
+     * modified by other means while the Serializer is alive.
+     * @param buffer destination, std::vector<char> or capsule::HeapBuffer
+     * @param reserveSize upper bound of bytes to be written
+     * @param debugMode true: bounds checks on every write
+     */
+    template <class Buffer>
+    Serializer(Buffer &buffer, const std::size_t reserveSize,
+               const bool debugMode = false)
+    : m_Buffer(&buffer), m_Resize(&ResizeBuffer<Buffer>),
+      m_DebugMode(debugMode)
+    {
+        const std::size_t position = buffer.size();
+        buffer.resize(position + reserveSize);
+        m_Data = buffer.data();
+        m_Cursor = m_Data + position;
+        m_End = m_Cursor + reserveSize;
+    }
+
+    /** Releases reserved bytes that were not written */
+    ~Serializer();
+
+    Serializer(const Serializer &) = delete;
+    Serializer &operator=(const Serializer &) = delete;
+
+    /**
+     * Writes at the cursor and advances it
+     * @param source
+     * @param elements number of T elements
+     */
+    template <class T>
+    void Write(const T *source, const std::size_t elements = 1)
+    {
+        const std::size_t bytes = elements * sizeof(T);
+        if (m_DebugMode == true)
+        {
+            CheckBounds(m_Cursor, bytes, m_End, "Write");
+        }
+        std::memcpy(m_Cursor, source, bytes);
+        m_Cursor += bytes;
+    }
+
+    /**
+     * Overwrites already written bytes, used to fill lengths and counts
+     * @param position absolute position in buffer
+     * @param source
+     * @param elements number of T elements
+     */
+    template <class T>
+    void WriteAt(const std::size_t position, const T *source,
+                 const std::size_t elements = 1)
+    {
+        const std::size_t bytes = elements * sizeof(T);
+        if (m_DebugMode == true)
+        {
+            CheckBounds(m_Data + position, bytes, m_Cursor, "WriteAt");
+        }
+        std::memcpy(m_Data + position, source, bytes);
+    }
+
+    /**
+     * Advances the cursor leaving zero bytes
+     * @param bytes
+     */
+    void Skip(const std::size_t bytes)
+    {
+        if (m_DebugMode == true)
+        {
+            CheckBounds(m_Cursor, bytes, m_End, "Skip");
+        }
+        std::memset(m_Cursor, 0, bytes);
+        m_Cursor += bytes;
+    }
+
+    /**
+     * Advances the cursor, caller fills the returned bytes (e.g. payloads)
+     * @param bytes
+     * @return pointer to the first byte
+     */
+    char *Reserve(const std::size_t bytes)
+    {
+        if (m_DebugMode == true)
+        {
+            CheckBounds(m_Cursor, bytes, m_End, "Reserve");
+        }
+        char *reserved = m_Cursor;
+        m_Cursor += bytes;
+        return reserved;
+    }
+
+    /** @return absolute cursor position in buffer */
+    std::size_t Position() const noexcept { return m_Cursor - m_Data; }
+
+private:
+    void *m_Buffer = nullptr; ///< destination buffer, type erased
+    void (*m_Resize)(void *, const std::size_t) = nullptr; ///< its resize
+    char *m_Data = nullptr;   ///< buffer.data() after reserving
+    char *m_Cursor = nullptr; ///< next byte to be written
+    char *m_End = nullptr;    ///< end of reserved space
+    const bool m_DebugMode = false;
+
+    /**
+     * Throws std::out_of_range if [destination, destination + bytes) is
+     * outside [m_Data, end)
+     */
+    void CheckBounds(const char *destination, const std::size_t bytes,
+                     const char *end, const std::string hint) const;
+
+    template <class Buffer>
+    static void ResizeBuffer(void *buffer, const std::size_t size)
+    {
+        static_cast<Buffer *>(buffer)->resize(size);
+    }
+};
+
+} // end namespace format
+} // end namespace adios
+
+#endif /* SERIALIZER_H_ */
@@ -12,6 +12,7 @@
 #define ADIOSFUNCTIONS_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstdint>
 #include <cstring> //std::size_t
 #include <map>
 #include <memory> //std::shared_ptr
@@ -21,6 +22,7 @@
 
 #include "ADIOS_MPI.h"
 
+#include "capsule/heap/STLVector.h"
 #include "core/Transform.h"
 
 namespace adios
@@ -123,6 +125,70 @@ void GetPairsFromTag(
  */
 std::size_t GetTotalSize(const std::vector<size_t> &dimensions);
 
+/**
+ * Checks if a box is inside a row-major block and is a single contiguous range
+ * of the block memory
+ * @param blockStart block global offsets
+ * @param blockCount block local dimensions
+ * @param start box global offsets
+ * @param count box dimensions
+ * @param offset output, elements from the block first element to the box
+ * first element
+ * @return true: box is inside block and contiguous, false: otherwise
+ */
+bool IsContiguousInBlock(const std::vector<std::size_t> &blockStart,
+                         const std::vector<std::size_t> &blockCount,
+                         const std::vector<std::size_t> &start,
+                         const std::vector<std::size_t> &count,
+                         std::size_t &offset) noexcept;
+
+/**
+ * Copies the intersection of two row-major boxes in the same global space,
+ * runs that are contiguous in both boxes are copied with a single memcpy
+ * @param source first element of the source box
+ * @param sourceStart source box global offsets
+ * @param sourceCount source box dimensions
+ * @param destination first element of the destination box
+ * @param destinationStart destination box global offsets
+ * @param destinationCount destination box dimensions
+ * @param elementSize bytes per element
+ * @return false: boxes don't intersect and nothing is copied
+ */
+bool CopyIntersection(const char *source,
+                      const std::vector<std::size_t> &sourceStart,
+                      const std::vector<std::size_t> &sourceCount,
+                      char *destination,
+                      const std::vector<std::size_t> &destinationStart,
+                      const std::vector<std::size_t> &destinationCount,
+                      const std::size_t elementSize) noexcept;
+
+/**
+ * Appends a group of 31 bits to a WAH (word-aligned hybrid) compressed bitmap.
+ * Literal words hold a group in bits 0-30, bit 31 is 0. Fill words have bit
+ * 31 set, bit 30 is the fill bit and bits 0-29 the number of groups.
+ * @param words compressed bitmap, updated
+ * @param nextGroup groups in words, skipped groups are appended as a 0 fill
+ * @param group index of the appended group, >= nextGroup
+ * @param literal bits of the group, bit b is element 31 * group + b
+ */
+void AppendWAHGroup(std::vector<std::uint32_t> &words, std::uint64_t &nextGroup,
+                    const std::uint64_t group,
+                    const std::uint32_t literal) noexcept;
+
+/**
+ * Decodes a WAH compressed bitmap built with AppendWAHGroup
+ * @param words compressed bitmap bytes, no alignment required
+ * @param wordsCount number of 32-bit words
+ * @param size number of bits in the bitmap, decoding stops at the first
+ * word past it
+ * @param positions output, positions of set bits are appended in increasing
+ * order
+ * @return false if the words describe bits at or past size
+ */
+bool GetWAHPositions(const char *words, const std::size_t wordsCount,
+                     const std::size_t size,
+                     std::vector<std::size_t> &positions);
+
 /**
  * Might need to add exceptions for debug mode
  * Creates a chain of directories using POSIX systems calls (stat, mkdir),
@@ -202,19 +268,21 @@ void ConvertUint64VectorToSizetVector(const std::vector<std::uint64_t> &in,
  */
 bool CheckBufferAllocation(const std::size_t newSize, const float growthFactor,
                            const std::size_t maxBufferSize,
-                           std::vector<char> &buffer);
+                           capsule::HeapBuffer &buffer);
 
 /**
  * Grows a buffer by a factor of  n . growthFactor . currentCapacity to
  * accommodate for incomingDataSize
  * @param incomingDataSize size of new data required to be stored in buffer
  * @param growthFactor buffer grows in multiples of the growth buffer
+ * @param maxBufferSize capacity is capped to this value unless
+ * incomingDataSize requires more
  * @param buffer to be resized
  * @return -1: failed to allocate (bad_alloc), 0: didn't have to allocate
  * (enough space), 1: successful allocation
  */
 int GrowBuffer(const std::size_t incomingDataSize, const float growthFactor,
-               std::vector<char> &buffer);
+               const std::size_t maxBufferSize, capsule::HeapBuffer &buffer);
 
 /**
  * Check if system is little endian
@@ -222,6 +290,25 @@ int GrowBuffer(const std::size_t incomingDataSize, const float growthFactor,
  */
 bool IsLittleEndian() noexcept;
 
+/**
+ * Position of the lowest set bit, compiler builtin where available
+ * @param bits must not be 0
+ * @return number of trailing zero bits
+ */
+inline unsigned int CountTrailingZeros(const std::uint64_t bits) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(bits));
+#else
+    unsigned int count = 0;
+    while (((bits >> count) & 1) == 0)
+    {
+        ++count;
+    }
+    return count;
+#endif
+}
+
 } // end namespace
 
 #endif /* ADIOSFUNCTIONS_H_ */
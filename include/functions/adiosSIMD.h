@@ -0,0 +1,253 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * adiosSIMD.h vectorized kernels over large arrays of primitives, the best
+ * instruction set (SSE2, AVX2, AVX-512) is selected at runtime, the
+ * ADIOS_SIMD environment variable (sse2, avx2) selects a lower one
+ *
+ *  Created on: Apr 18, 2017
+ *      Author: wfg
+ */
+
+#ifndef ADIOSSIMD_H_
+#define ADIOSSIMD_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <complex>
+#include <cstddef> //std::size_t
+#include <cstdint>
+/// \endcond
+
+namespace adios
+{
+
+/** Moments of an array accumulated with its min and max */
+struct Moments
+{
+    std::uint64_t Count = 0; ///< number of finite values
+    double Sum = 0.;         ///< sum of finite values
+    double SumSquare = 0.;   ///< sum of squares of finite values
+    bool Finite = true;      ///< true: all values are finite
+};
+
+/**
+ * Get the minimum and maximum values in one vectorized pass, NaNs are
+ * skipped, min and max are NaN only if all values are NaN
+ * @param values array of primitives
+ * @param size of the values array
+ * @param min from values
+ * @param max from values
+ * @param nthreads values are split in nthreads contiguous pieces
+ * @param moments if not nullptr, moments are accumulated in the same pass
+ */
+void GetMinMax(const char *values, const std::size_t size, char &min, char &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const unsigned char *values, const std::size_t size,
+               unsigned char &min, unsigned char &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const short *values, const std::size_t size, short &min,
+               short &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const unsigned short *values, const std::size_t size,
+               unsigned short &min, unsigned short &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const int *values, const std::size_t size, int &min, int &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const unsigned int *values, const std::size_t size,
+               unsigned int &min, unsigned int &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const long int *values, const std::size_t size, long int &min,
+               long int &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const unsigned long int *values, const std::size_t size,
+               unsigned long int &min, unsigned long int &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const long long int *values, const std::size_t size,
+               long long int &min, long long int &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const unsigned long long int *values, const std::size_t size,
+               unsigned long long int &min, unsigned long long int &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const float *values, const std::size_t size, float &min,
+               float &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const double *values, const std::size_t size, double &min,
+               double &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const long double *values, const std::size_t size,
+               long double &min, long double &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+
+/**
+ * Overloaded version for complex types, gets the "doughnut" range between min
+ * and max modulus
+ * @param values array of complex numbers
+ * @param size of the values array
+ * @param min modulus from values
+ * @param max modulus from values
+ * @param nthreads values are split in nthreads contiguous pieces
+ * @param moments if not nullptr, moments of the modulus are accumulated in the
+ * same pass
+ */
+void GetMinMax(const std::complex<float> *values, const std::size_t size,
+               float &min, float &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const std::complex<double> *values, const std::size_t size,
+               double &min, double &max, const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+void GetMinMax(const std::complex<long double> *values, const std::size_t size,
+               long double &min, long double &max,
+               const unsigned int nthreads = 1,
+               Moments *moments = nullptr) noexcept;
+
+/**
+ * Copies values to destination and gets their minimum and maximum in the same
+ * pass, avoids reading values twice from memory
+ * @param destination bytes, no alignment required, size * sizeof(T) must be
+ * available
+ * @param values array of primitives
+ * @param size of the values array
+ * @param min from values
+ * @param max from values
+ * @param nthreads values are split in nthreads contiguous pieces
+ * @param moments if not nullptr, moments are accumulated in the same pass
+ */
+void MemcpyMinMax(char *destination, const char *values, const std::size_t size,
+                  char &min, char &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const unsigned char *values,
+                  const std::size_t size, unsigned char &min,
+                  unsigned char &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const short *values,
+                  const std::size_t size, short &min, short &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const unsigned short *values,
+                  const std::size_t size, unsigned short &min,
+                  unsigned short &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const int *values, const std::size_t size,
+                  int &min, int &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const unsigned int *values,
+                  const std::size_t size, unsigned int &min, unsigned int &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const long int *values,
+                  const std::size_t size, long int &min, long int &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const unsigned long int *values,
+                  const std::size_t size, unsigned long int &min,
+                  unsigned long int &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const long long int *values,
+                  const std::size_t size, long long int &min,
+                  long long int &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const unsigned long long int *values,
+                  const std::size_t size, unsigned long long int &min,
+                  unsigned long long int &max, const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const float *values,
+                  const std::size_t size, float &min, float &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const double *values,
+                  const std::size_t size, double &min, double &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const long double *values,
+                  const std::size_t size, long double &min, long double &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+
+/**
+ * Overloaded version for complex types, min and max are the modulus range
+ * @param destination bytes, no alignment required
+ * @param values array of complex numbers
+ * @param size of the values array
+ * @param min modulus from values
+ * @param max modulus from values
+ * @param nthreads values are split in nthreads contiguous pieces
+ * @param moments if not nullptr, moments of the modulus are accumulated in the
+ * same pass
+ */
+void MemcpyMinMax(char *destination, const std::complex<float> *values,
+                  const std::size_t size, float &min, float &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const std::complex<double> *values,
+                  const std::size_t size, double &min, double &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+void MemcpyMinMax(char *destination, const std::complex<long double> *values,
+                  const std::size_t size, long double &min, long double &max,
+                  const unsigned int nthreads = 1,
+                  Moments *moments = nullptr) noexcept;
+
+/**
+ * Finds the values in the closed range [lo, hi] in one vectorized pass, NaN
+ * values are never in range
+ * @param values array of primitives
+ * @param size of the values array
+ * @param lo lower bound
+ * @param hi upper bound
+ * @param positions output, indices of the values in range in increasing
+ * order, size elements must be available
+ * @return number of values in range
+ */
+std::size_t GetInRange(const char *values, const std::size_t size,
+                       const char lo, const char hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const unsigned char *values, const std::size_t size,
+                       const unsigned char lo, const unsigned char hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const short *values, const std::size_t size,
+                       const short lo, const short hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const unsigned short *values, const std::size_t size,
+                       const unsigned short lo, const unsigned short hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const int *values, const std::size_t size, const int lo,
+                       const int hi, std::size_t *positions) noexcept;
+std::size_t GetInRange(const unsigned int *values, const std::size_t size,
+                       const unsigned int lo, const unsigned int hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const long int *values, const std::size_t size,
+                       const long int lo, const long int hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const unsigned long int *values, const std::size_t size,
+                       const unsigned long int lo, const unsigned long int hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const long long int *values, const std::size_t size,
+                       const long long int lo, const long long int hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const unsigned long long int *values,
+                       const std::size_t size, const unsigned long long int lo,
+                       const unsigned long long int hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const float *values, const std::size_t size,
+                       const float lo, const float hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const double *values, const std::size_t size,
+                       const double lo, const double hi,
+                       std::size_t *positions) noexcept;
+std::size_t GetInRange(const long double *values, const std::size_t size,
+                       const long double lo, const long double hi,
+                       std::size_t *positions) noexcept;
+
+} // end namespace adios
+
+#endif /* ADIOSSIMD_H_ */
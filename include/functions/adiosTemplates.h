@@ -12,15 +12,18 @@
 #define ADIOSTEMPLATES_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
-#include <cmath> //std::sqrt
+#include <algorithm> //std::min, std::max
+#include <cmath>     //std::sqrt
 #include <complex>
+#include <cstdint>
 #include <cstring> //std::memcpy
 #include <iostream>
 #include <set>
-#include <thread>
 #include <vector>
 /// \endcond
 
+#include "functions/adiosFunctions.h" //AppendWAHGroup
+
 namespace adios
 {
 /**
@@ -142,117 +145,133 @@ bool IsTypeAlias(
     return isAlias;
 }
 
-/**
- * Get the minimum and maximum values in one loop
- * @param values array of primitives
- * @param size of the values array
- * @param min from values
- * @param max from values
- * @param nthreads threaded version not yet implemented
- */
+/** value used for binning, modulus for complex types */
 template <class T>
-inline void GetMinMax(const T *values, const std::size_t size, T &min, T &max,
-                      const unsigned int nthreads = 1) noexcept
+inline double BinValue(const T value) noexcept
 {
-    min = values[0];
-    max = min;
+    return static_cast<double>(value);
+}
 
-    for (std::size_t i = 1; i < size; ++i)
-    {
-        if (values[i] < min)
-        {
-            min = values[i];
-            continue;
-        }
+template <class T>
+inline double BinValue(const std::complex<T> value) noexcept
+{
+    return static_cast<double>(std::abs(value));
+}
 
-        if (values[i] > max)
-            max = values[i];
+/**
+ * Equal width bin of a value, monotonic in value: values below the first bin
+ * are in the first bin, values above the last bin in the last bin
+ * @param value from BinValue, not NaN
+ * @param lower lower bound of the first bin
+ * @param width of each bin
+ * @param bins number of bins
+ * @return bin in [0, bins - 1]
+ */
+inline std::size_t GetBin(const double value, const double lower,
+                          const double width, const std::size_t bins) noexcept
+{
+    if (!(width > 0.) || !(value > lower))
+    {
+        return 0;
     }
+    const double bin = (value - lower) / width;
+    return (bin < static_cast<double>(bins - 1)) ? static_cast<std::size_t>(bin)
+                                                 : bins - 1;
 }
 
 /**
- * Overloaded version for complex types, gets the "doughnut" range between min
- * and max modulus
- * @param values array of complex numbers
+ * Counts finite values in equal width bins between min and max, max falls in
+ * the last bin. Complex values are binned by modulus.
+ * @param values array of primitives
  * @param size of the values array
- * @param min modulus from values
- * @param max modulus from values
- * @param nthreads
+ * @param min lower bound of the first bin
+ * @param max upper bound of the last bin
+ * @param frequencies input: size is the number of bins, output: counts
  */
-template <class T>
-inline void GetMinMax(const std::complex<T> *values, const std::size_t size,
-                      T &min, T &max, const unsigned int nthreads = 1) noexcept
+template <class T, class U>
+void GetHistogram(const T *values, const std::size_t size, const U min,
+                  const U max, std::vector<std::uint64_t> &frequencies) noexcept
 {
+    std::fill(frequencies.begin(), frequencies.end(), 0);
+    const std::size_t bins = frequencies.size();
+    if (bins == 0)
+        return;
 
-    min = std::norm(values[0]);
-    max = min;
+    const double lower = static_cast<double>(min);
+    const double width = (static_cast<double>(max) - lower) / bins;
 
-    for (std::size_t i = 1; i < size; ++i)
+    for (std::size_t i = 0; i < size; ++i)
     {
-        T norm = std::norm(values[i]);
-
-        if (norm < min)
-        {
-            min = norm;
+        const double value = BinValue(values[i]);
+        if (value - value != 0.) // skip inf and NaN
             continue;
-        }
 
-        if (norm > max)
-        {
-            max = norm;
-        }
+        ++frequencies[GetBin(value, lower, width, bins)];
     }
-
-    min = std::sqrt(min);
-    max = std::sqrt(max);
 }
 
 /**
- * threaded version of std::memcpy
- * @param dest
- * @param source
- * @param count total number of bytes (as in memcpy)
- * @param nthreads
+ * Builds a binned bitmap index: for each equal width bin between min and max
+ * (bins as in GetHistogram) a WAH compressed bitmap of the positions of the
+ * values in the bin. NaN values are in no bin.
+ * @param values array of primitives
+ * @param size of the values array
+ * @param min lower bound of the first bin
+ * @param max upper bound of the last bin
+ * @param bins number of bins
+ * @param words output, compressed bitmaps of all bins one after another
+ * @param binWords output, words of each bin, empty if min or max is not
+ * finite and no index is built
  */
 template <class T, class U>
-void MemcpyThreads(T *destination, const U *source, std::size_t count,
-                   const unsigned int nthreads = 1)
+void GetBitmapIndex(const T *values, const std::size_t size, const U min,
+                    const U max, const std::size_t bins,
+                    std::vector<std::uint32_t> &words,
+                    std::vector<std::uint32_t> &binWords)
 {
-    // do not decompose tasks to less than 4MB pieces
-    const std::size_t minBlockSize = 4194304;
-    const std::size_t maxNThreads =
-        std::max((std::size_t)nthreads, count / minBlockSize);
+    words.clear();
+    binWords.clear();
+    const double lower = static_cast<double>(min);
+    const double width = (static_cast<double>(max) - lower) / bins;
+    if (bins == 0 || lower - lower != 0. || width - width != 0.)
+        return;
+
+    std::vector<std::vector<std::uint32_t>> bitmaps(bins);
+    std::vector<std::uint64_t> nextGroups(bins, 0);
+    std::vector<std::uint32_t> literals(bins, 0);
+    std::vector<std::size_t> touched; // bins with bits in the current group
+    touched.reserve(31);
 
-    if (maxNThreads == 1)
+    for (std::size_t begin = 0; begin < size; begin += 31)
     {
-        std::memcpy(destination, source, count);
-        return;
-    }
+        const std::size_t end = std::min(begin + 31, size);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const double value = BinValue(values[i]);
+            if (value != value) // NaN
+                continue;
 
-    const std::size_t stride = count / maxNThreads;
-    const std::size_t remainder = count % maxNThreads;
-    const std::size_t last = stride + remainder;
+            const std::size_t bin = GetBin(value, lower, width, bins);
+            if (literals[bin] == 0)
+                touched.push_back(bin);
+            literals[bin] |= std::uint32_t(1) << (i - begin);
+        }
 
-    std::vector<std::thread> memcpyThreads;
-    memcpyThreads.reserve(maxNThreads);
+        for (const auto bin : touched)
+        {
+            AppendWAHGroup(bitmaps[bin], nextGroups[bin], begin / 31,
+                           literals[bin]);
+            literals[bin] = 0;
+        }
+        touched.clear();
+    }
 
-    for (unsigned int t = 0; t < maxNThreads; ++t)
+    binWords.reserve(bins);
+    for (const auto &bitmap : bitmaps)
     {
-        const size_t initialDestination = stride * t / sizeof(T);
-        const size_t initialSource = stride * t / sizeof(U);
-
-        if (t == maxNThreads - 1)
-            memcpyThreads.push_back(
-                std::thread(std::memcpy, &destination[initialDestination],
-                            &source[initialSource], last));
-        else
-            memcpyThreads.push_back(
-                std::thread(std::memcpy, &destination[initialDestination],
-                            &source[initialSource], stride));
+        binWords.push_back(static_cast<std::uint32_t>(bitmap.size()));
+        words.insert(words.end(), bitmap.begin(), bitmap.end());
     }
-    // Now join the threads (is this really needed?)
-    for (auto &thread : memcpyThreads)
-        thread.join();
 }
 
 template <class T>
@@ -305,6 +324,21 @@ void CopyFromBuffer(T *destination, std::size_t elements,
     position += elements * sizeof(T);
 }
 
+/**
+ * Overloaded version for raw (e.g. memory mapped) buffers
+ * @param destination
+ * @param elements
+ * @param raw
+ * @param position updated past the copied elements
+ */
+template <class T>
+void CopyFromBuffer(T *destination, std::size_t elements, const char *raw,
+                    std::size_t &position) noexcept
+{
+    std::memcpy(destination, raw + position, sizeof(T) * elements);
+    position += elements * sizeof(T);
+}
+
 template <class T>
 void PrintValues(const std::string name, const char *buffer,
                  const std::size_t position, const std::size_t elements)
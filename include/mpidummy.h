@@ -30,6 +30,7 @@ typedef int MPI_Info;
 typedef int MPI_Datatype; /* Store the byte size of a type in such vars */
 typedef uint64_t MPI_Offset;
 typedef int MPI_Fint;
+typedef int MPI_Op;
 
 #define MPI_SUCCESS 0
 #define MPI_ERR_BUFFER 1 /* Invalid buffer pointer */
@@ -39,6 +40,8 @@ typedef int MPI_Fint;
 #define MPI_ERR_COMM 5   /* Invalid communicator */
 #define MPI_MAX_ERROR_STRING 512
 #define MPI_MODE_RDONLY O_RDONLY
+#define MPI_MODE_WRONLY O_WRONLY
+#define MPI_MODE_CREATE O_CREAT
 #define MPI_SEEK_SET SEEK_SET
 #define MPI_SEEK_CUR SEEK_CUR
 #define MPI_SEEK_END SEEK_END
@@ -52,11 +55,15 @@ typedef int MPI_Fint;
 #define MPI_INT 1
 #define MPI_CHAR 2
 #define MPI_DOUBLE 3
+#define MPI_UNSIGNED_LONG_LONG 4
+
+#define MPI_COMM_TYPE_SHARED 0
 
 #define MPI_ANY_SOURCE 0
 #define MPI_ANY_TAG 0
 
 #define MPI_SUM 0
+#define MPI_MAX 1
 
 #define MPI_MAX_PROCESSOR_NAME 32
 int MPI_Init(int *argc, char ***argv);
@@ -79,6 +86,8 @@ int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
 int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
                 void *recvbuf, const int *recvcounts, const int *displs,
                 MPI_Datatype recvtype, int root, MPI_Comm comm);
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
 int MPI_Allgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
                   void *recvbuf, int recvcount, MPI_Datatype recvtype,
                   MPI_Comm comm);
@@ -105,13 +114,26 @@ int MPI_File_open(MPI_Comm comm, const char *filename, int amode, MPI_Info info,
                   MPI_File *fh);
 int MPI_File_close(MPI_File *fh);
 int MPI_File_get_size(MPI_File fh, MPI_Offset *size);
+int MPI_File_set_size(MPI_File fh, MPI_Offset size);
 int MPI_File_read(MPI_File fh, void *buf, int count, MPI_Datatype datatype,
                   MPI_Status *status);
 int MPI_File_seek(MPI_File fh, MPI_Offset offset, int whence);
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void *buf,
+                          int count, MPI_Datatype datatype,
+                          MPI_Status *status);
+int MPI_File_sync(MPI_File fh);
+
+int MPI_Info_create(MPI_Info *info);
+int MPI_Info_set(MPI_Info info, const char *key, const char *value);
+int MPI_Info_free(MPI_Info *info);
 
 int MPI_Get_count(const MPI_Status *status, MPI_Datatype datatype, int *count);
 int MPI_Error_string(int errorcode, char *string, int *resultlen);
 int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *comm_out);
+int MPI_Comm_split_type(MPI_Comm comm, int split_type, int key, MPI_Info info,
+                        MPI_Comm *newcomm);
+int MPI_Exscan(const void *sendbuf, void *recvbuf, int count,
+               MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
 
 int MPI_Get_processor_name(char *name, int *resultlen);
 
@@ -0,0 +1,46 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ */
+
+#ifndef __ADIOS_QUERY_RESULT_H__
+#define __ADIOS_QUERY_RESULT_H__
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstdint>
+#include <vector>
+/// \endcond
+
+#include "selection/Selection.h"
+#include "selection/SelectionBoundingBox.h"
+
+namespace adios
+{
+
+/** Selection of the elements of a variable with values in a range, from
+ *  Engine::Query. Points can be passed to SelectionPoints as
+ *  SelectionPoints(Ndim, Points.size() / Ndim, Points).
+ */
+struct QueryResult
+{
+    /** SelectionType::Points or SelectionType::BoundingBox */
+    SelectionType Type = SelectionType::Points;
+
+    std::size_t Ndim = 0;  ///< dimensions of Points and Boxes
+    std::size_t Count = 0; ///< elements with values in range
+
+    /** Points: global coordinates of elements in range compacted for all
+     * dimensions [i1,j1,k1,i2,j2,k2,...], in block and row-major order */
+    std::vector<std::uint64_t> Points;
+
+    /** BoundingBox: box around the elements in range of each block */
+    std::vector<SelectionBoundingBox> Boxes;
+
+    std::size_t Blocks = 0;        ///< blocks intersecting the selection
+    std::size_t ScannedBlocks = 0; ///< blocks whose values were all read
+    std::size_t IndexedBlocks = 0; ///< blocks resolved with a bitmap index
+};
+
+} // namespace adios
+
+#endif /*__ADIOS_QUERY_RESULT_H__*/
@@ -11,6 +11,10 @@
 #ifndef FILEDESCRIPTOR_H_
 #define FILEDESCRIPTOR_H_
 
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <memory> //std::unique_ptr
+/// \endcond
+
 #include "core/Transport.h"
 
 namespace adios
@@ -25,7 +29,17 @@ class FileDescriptor : public Transport
 {
 
 public:
-    FileDescriptor(MPI_Comm mpiComm, const bool debugMode);
+    /**
+     * @param mpiComm
+     * @param debugMode
+     * @param directIO true: files opened for writing bypass the page cache
+     * with O_DIRECT, falls back to buffered I/O if the file system rejects it
+     * @param blockSize bytes per POSIX write call, 0: default 1GB, Linux
+     * writes at most 2GB - 4KB per call
+     */
+    FileDescriptor(MPI_Comm mpiComm, const bool debugMode,
+                   const bool directIO = false,
+                   const std::size_t blockSize = 0);
 
     ~FileDescriptor();
 
@@ -33,10 +47,41 @@ public:
 
     void Write(const char *buffer, std::size_t size);
 
+    /** Uses POSIX writev, in batches of up to IOV_MAX buffers */
+    void WriteV(const iovec *iov, const int iovcnt);
+
     void Close();
 
+    /** @return true if the file is currently written with O_DIRECT */
+    bool IsDirectIO() const noexcept;
+
 private:
     int m_FileDescriptor = -1; ///< file descriptor returned by POSIX open
+
+    std::size_t m_BlockSize; ///< bytes per write call
+
+    bool m_DirectIO = false; ///< requested, false after a fallback
+    bool m_IsDirect = false; ///< file currently open with O_DIRECT
+
+    /** page-aligned staging buffer for O_DIRECT, only full aligned blocks are
+     * written, the tail is padded at Close and the file truncated */
+    std::unique_ptr<char, void (*)(void *)> m_AlignedBuffer;
+    std::size_t m_Alignment = 4096;            ///< page size
+    std::size_t m_AlignedBufferSize = 4194304; ///< 4MB, multiple of alignment
+    std::size_t m_AlignedPosition = 0;         ///< staged bytes
+    std::size_t m_FileSize = 0; ///< bytes written by the application
+
+    /**
+     * Writes all bytes in blocks of m_BlockSize, retries interrupted and
+     * short writes, each block is profiled. Aligned when m_IsDirect is true,
+     * turns off O_DIRECT if the file system rejects an aligned write.
+     * @param buffer
+     * @param size
+     */
+    void WriteAll(const char *buffer, std::size_t size);
+
+    /** Writes the padded staged tail and truncates to m_FileSize */
+    void FlushAligned();
 };
 
 } // end namespace transport
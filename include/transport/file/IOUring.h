@@ -0,0 +1,138 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * IOUring.h file transport using Linux io_uring through its system calls,
+ * writes are split in fixed size blocks kept in flight up to a queue depth
+ *
+ *  Created on: Apr 28, 2017
+ *      Author: wfg
+ */
+
+#ifndef IOURING_H_
+#define IOURING_H_
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <cstdint>
+#include <memory> //std::unique_ptr
+#include <vector>
+/// \endcond
+
+#include "core/Transport.h"
+
+namespace adios
+{
+namespace transport
+{
+
+/**
+ * Write only file transport. Write copies the application buffer into
+ * registered blocks and returns once the last block is submitted, blocks
+ * complete asynchronously. Flush and Close wait for all blocks. Falls back to
+ * blocking pwrite if the kernel doesn't provide io_uring.
+ */
+class IOUring : public Transport
+{
+
+public:
+    /**
+     * @param mpiComm
+     * @param debugMode
+     * @param queueDepth maximum number of blocks in flight
+     * @param blockSize bytes per submission
+     */
+    IOUring(MPI_Comm mpiComm, const bool debugMode,
+            const unsigned int queueDepth = 16,
+            const std::size_t blockSize = 1048576);
+
+    ~IOUring();
+
+    void Open(const std::string name, const std::string accessMode);
+
+    void Write(const char *buffer, std::size_t size);
+
+    void Flush();
+
+    void Close();
+
+    /** @return true if writes go through io_uring, false if pwrite is used */
+    bool IsRing() const noexcept;
+
+private:
+    /** Registered block, one submission in flight at most */
+    struct Block
+    {
+        char *Data = nullptr;     ///< inside m_Blocks, registered buffer
+        std::size_t Size = 0;     ///< bytes to write
+        std::size_t Written = 0;  ///< completed bytes, short writes resubmit
+        std::uint64_t Offset = 0; ///< file offset of Data
+    };
+
+    int m_FileDescriptor = -1;  ///< file descriptor returned by POSIX open
+    std::uint64_t m_Offset = 0; ///< file offset of the next block
+
+    const unsigned int m_QueueDepth; ///< maximum blocks in flight
+    const std::size_t m_BlockSize;   ///< bytes per block
+    std::unique_ptr<char, void (*)(void *)> m_Blocks; ///< all blocks memory
+    std::vector<Block> m_Block;                       ///< m_QueueDepth blocks
+    std::vector<unsigned int> m_FreeBlocks; ///< indices in m_Block
+    unsigned int m_ToSubmit = 0;            ///< queued, not yet entered
+
+    int m_Ring = -1;             ///< io_uring_setup file descriptor
+    bool m_FixedBuffers = false; ///< blocks registered with the ring
+
+    // ring mappings, see io_uring_setup(2)
+    void *m_SQRing = nullptr;
+    std::size_t m_SQRingSize = 0;
+    void *m_CQRing = nullptr;
+    std::size_t m_CQRingSize = 0;
+    void *m_SQEs = nullptr;
+    std::size_t m_SQEsSize = 0;
+
+    unsigned int *m_SQTail = nullptr;
+    unsigned int *m_SQMask = nullptr;
+    unsigned int *m_SQArray = nullptr;
+    unsigned int *m_CQHead = nullptr;
+    unsigned int *m_CQTail = nullptr;
+    unsigned int *m_CQMask = nullptr;
+    void *m_CQEs = nullptr;
+
+    /** Creates the ring and registers the blocks, leaves m_Ring = -1 on
+     * failure */
+    void InitRing();
+
+    void FreeRing() noexcept;
+
+    /**
+     * Asks the ring with IORING_REGISTER_PROBE
+     * @param op IORING_OP_* opcode
+     * @return true if the kernel supports op, false also if it can't probe
+     */
+    bool IsOpSupported(const unsigned int op) const;
+
+    /** Queues the (remaining) write of a block, entered at next Enter */
+    void Submit(const unsigned int index);
+
+    /**
+     * Enters queued submissions and optionally waits for completions
+     * @param minComplete completions to wait for
+     */
+    void Enter(const unsigned int minComplete);
+
+    /** Processes available completions, freeing or resubmitting blocks */
+    void Reap();
+
+    /** @return a free block index, waits for a completion if none */
+    unsigned int AcquireBlock();
+
+    /** Waits until all blocks are free */
+    void WaitAll();
+
+    /** Blocking pwrite fallback without a ring */
+    void WriteSync(const char *buffer, std::size_t size);
+};
+
+} // end namespace transport
+} // end namespace adios
+
+#endif /* IOURING_H_ */
@@ -12,29 +12,47 @@
 #define MPI_FILE_H_
 
 /// \cond EXCLUDE_FROM_DOXYGEN
-#include <mpi.h>
+#include <cstdint>
+#include <map>
+#include <string>
 /// \endcond
 
+#include "core/Transport.h"
+
 namespace adios
 {
 namespace transport
 {
 
 /**
- * Class that defines a transport method using C++ file streams
+ * Class that defines a transport method using MPI-IO on a single file shared
+ * by all ranks in the communicator. Open, Write and Close are collective.
  */
-class MPI_File : public Transport
+class MPIFile : public Transport
 {
 
 public:
-    MPI_File(MPI_Comm mpiComm, const bool debugMode);
-
-    ~MPI_File();
+    /**
+     * @param mpiComm all ranks open the same file
+     * @param debugMode
+     * @param hints MPI_Info key/value pairs passed to MPI_File_open, e.g.
+     * cb_buffer_size, cb_nodes, romio_cb_write, striping_factor
+     */
+    MPIFile(MPI_Comm mpiComm, const bool debugMode,
+            const std::map<std::string, std::string> &hints =
+                std::map<std::string, std::string>());
 
-    void Open(const std::string streamName, const std::string accessMode);
+    ~MPIFile();
 
-    void SetBuffer(char *buffer, std::size_t size);
+    void Open(const std::string name, const std::string accessMode);
 
+    /**
+     * Collective, appends the buffers from all ranks in rank order, the
+     * current rank offset comes from MPI_Exscan over sizes, written with
+     * MPI_File_write_at_all
+     * @param buffer from current rank, can be empty
+     * @param size of buffer
+     */
     void Write(const char *buffer, std::size_t size);
 
     void Flush();
@@ -43,6 +61,8 @@ public:
 
 private:
     MPI_File m_MPIFile; ///< MPI File
+    std::map<std::string, std::string> m_Hints; ///< MPI_Info for open
+    std::uint64_t m_Position = 0; ///< shared file end, same in all ranks
 };
 
 } // end namespace transport
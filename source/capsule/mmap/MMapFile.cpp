@@ -0,0 +1,134 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * MMapFile.cpp
+ *
+ *  Created on: May 1, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm>  //std::min
+#include <fcntl.h>    //open
+#include <ios>        //std::ios_base::failure
+#include <stdexcept>  //std::invalid_argument
+#include <sys/mman.h> //mmap, munmap, madvise
+#include <sys/stat.h> //fstat
+#include <unistd.h>   //close, sysconf
+#include <utility>    //std::move
+/// \endcond
+
+#include "capsule/mmap/MMapFile.h"
+
+namespace adios
+{
+namespace capsule
+{
+
+MMapFile::MMapFile(std::string accessMode, int rankMPI,
+                   const std::string &fileName, bool debugMode)
+: Capsule{"MMap", std::move(accessMode), rankMPI, debugMode},
+  m_FileName(fileName)
+{
+    if (m_DebugMode == true)
+    {
+        if (m_AccessMode != "r" && m_AccessMode != "read")
+        {
+            throw std::invalid_argument(
+                "ERROR: MMapFile capsule is read only, access mode " +
+                m_AccessMode + " not supported, for file " + m_FileName +
+                "\n");
+        }
+    }
+
+    const int fileDescriptor = open(m_FileName.c_str(), O_RDONLY);
+    if (fileDescriptor == -1)
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::ios_base::failure("ERROR: couldn't open file " +
+                                         m_FileName +
+                                         ", in call to MMapFile constructor\n");
+        }
+        return;
+    }
+
+    struct stat fileStat;
+    const bool isStat = fstat(fileDescriptor, &fileStat) == 0;
+    if (isStat == true && fileStat.st_size > 0)
+    {
+        const std::size_t size = static_cast<std::size_t>(fileStat.st_size);
+        void *data =
+            mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+        if (data != MAP_FAILED)
+        {
+            m_Data = static_cast<char *>(data);
+            m_DataSize = size;
+        }
+    }
+    close(fileDescriptor); // the mapping keeps the file
+
+    if (m_DebugMode == true)
+    {
+        if (isStat == false || (m_Data == nullptr && fileStat.st_size > 0))
+        {
+            throw std::ios_base::failure("ERROR: couldn't map file " +
+                                         m_FileName +
+                                         ", in call to MMapFile constructor\n");
+        }
+    }
+}
+
+MMapFile::~MMapFile()
+{
+    if (m_Data != nullptr)
+    {
+        munmap(m_Data, m_DataSize);
+    }
+}
+
+char *MMapFile::GetData() { return m_Data; }
+
+char *MMapFile::GetMetadata() { return nullptr; }
+
+std::size_t MMapFile::GetDataSize() const { return m_DataSize; }
+
+std::size_t MMapFile::GetMetadataSize() const { return 0; }
+
+void MMapFile::Prefetch(const std::size_t offset,
+                        const std::size_t size) noexcept
+{
+    if (m_Data == nullptr || offset >= m_DataSize)
+    {
+        return;
+    }
+
+    // madvise needs a page aligned start, the mapping itself is page aligned
+    static const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const std::size_t begin = offset - offset % pageSize;
+    const std::size_t end = offset + std::min(size, m_DataSize - offset);
+    madvise(m_Data + begin, end - begin, MADV_WILLNEED);
+}
+
+void MMapFile::Load(const std::size_t offset, const std::size_t size) noexcept
+{
+    Prefetch(offset, size);
+    if (m_Data == nullptr || offset >= m_DataSize || size == 0)
+    {
+        return;
+    }
+
+    static const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const std::size_t end = offset + std::min(size, m_DataSize - offset);
+    const volatile char *data = m_Data;
+    for (std::size_t position = offset; position < end;
+         position += pageSize - position % pageSize)
+    {
+        static_cast<void>(data[position]);
+    }
+}
+
+} // end namespace capsule
+} // end namespace adios
@@ -272,11 +272,203 @@ VariableCompound *Engine::InquireVariableCompound(const std::string /*name*/,
     return nullptr;
 }
 
+void Engine::Read(Variable<char> & /*variable*/, const char * /*values*/) {}
+void Engine::Read(Variable<unsigned char> & /*variable*/,
+                  const unsigned char * /*values*/)
+{
+}
+void Engine::Read(Variable<short> & /*variable*/, const short * /*values*/) {}
+void Engine::Read(Variable<unsigned short> & /*variable*/,
+                  const unsigned short * /*values*/)
+{
+}
+void Engine::Read(Variable<int> & /*variable*/, const int * /*values*/) {}
+void Engine::Read(Variable<unsigned int> & /*variable*/,
+                  const unsigned int * /*values*/)
+{
+}
+void Engine::Read(Variable<long int> & /*variable*/,
+                  const long int * /*values*/)
+{
+}
+void Engine::Read(Variable<unsigned long int> & /*variable*/,
+                  const unsigned long int * /*values*/)
+{
+}
+void Engine::Read(Variable<long long int> & /*variable*/,
+                  const long long int * /*values*/)
+{
+}
+void Engine::Read(Variable<unsigned long long int> & /*variable*/,
+                  const unsigned long long int * /*values*/)
+{
+}
+void Engine::Read(Variable<float> & /*variable*/, const float * /*values*/) {}
 void Engine::Read(Variable<double> & /*variable*/, const double * /*values*/) {}
+void Engine::Read(Variable<long double> & /*variable*/,
+                  const long double * /*values*/)
+{
+}
+void Engine::Read(Variable<std::complex<float>> & /*variable*/,
+                  const std::complex<float> * /*values*/)
+{
+}
+void Engine::Read(Variable<std::complex<double>> & /*variable*/,
+                  const std::complex<double> * /*values*/)
+{
+}
+void Engine::Read(Variable<std::complex<long double>> & /*variable*/,
+                  const std::complex<long double> * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<char> & /*variable*/,
+                          const char * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<unsigned char> & /*variable*/,
+                          const unsigned char * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<short> & /*variable*/,
+                          const short * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<unsigned short> & /*variable*/,
+                          const unsigned short * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<int> & /*variable*/,
+                          const int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<unsigned int> & /*variable*/,
+                          const unsigned int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<long int> & /*variable*/,
+                          const long int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<unsigned long int> & /*variable*/,
+                          const unsigned long int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<long long int> & /*variable*/,
+                          const long long int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<unsigned long long int> & /*variable*/,
+                          const unsigned long long int * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<float> & /*variable*/,
+                          const float * /*values*/)
+{
+}
 void Engine::ScheduleRead(Variable<double> & /*variable*/,
                           const double * /*values*/)
 {
 }
+void Engine::ScheduleRead(Variable<long double> & /*variable*/,
+                          const long double * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<std::complex<float>> & /*variable*/,
+                          const std::complex<float> * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<std::complex<double>> & /*variable*/,
+                          const std::complex<double> * /*values*/)
+{
+}
+void Engine::ScheduleRead(Variable<std::complex<long double>> & /*variable*/,
+                          const std::complex<long double> * /*values*/)
+{
+}
+void Engine::PerformReads(PerformReadMode /*mode*/) {}
+QueryResult Engine::Query(Variable<char> & /*variable*/,
+                          const char /*lo*/, const char /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<unsigned char> & /*variable*/,
+                          const unsigned char /*lo*/,
+                          const unsigned char /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<short> & /*variable*/,
+                          const short /*lo*/, const short /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<unsigned short> & /*variable*/,
+                          const unsigned short /*lo*/,
+                          const unsigned short /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<int> & /*variable*/,
+                          const int /*lo*/, const int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<unsigned int> & /*variable*/,
+                          const unsigned int /*lo*/, const unsigned int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<long int> & /*variable*/,
+                          const long int /*lo*/, const long int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<unsigned long int> & /*variable*/,
+                          const unsigned long int /*lo*/,
+                          const unsigned long int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<long long int> & /*variable*/,
+                          const long long int /*lo*/,
+                          const long long int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<unsigned long long int> & /*variable*/,
+                          const unsigned long long int /*lo*/,
+                          const unsigned long long int /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<float> & /*variable*/,
+                          const float /*lo*/, const float /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<double> & /*variable*/,
+                          const double /*lo*/, const double /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
+QueryResult Engine::Query(Variable<long double> & /*variable*/,
+                          const long double /*lo*/, const long double /*hi*/,
+                          const SelectionType /*type*/)
+{
+    return QueryResult();
+}
 void Engine::Release() {}
 
 // PROTECTED
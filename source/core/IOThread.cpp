@@ -0,0 +1,121 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * IOThread.cpp
+ *
+ *  Created on: Apr 27, 2017
+ *      Author: wfg
+ */
+
+#include <utility> //std::move
+
+#include "core/IOThread.h"
+
+namespace adios
+{
+
+IOThread::IOThread(const std::size_t capacity)
+: m_Tasks(capacity > 0 ? capacity : 1), m_Head(0), m_Tail(0),
+  m_Thread(&IOThread::Run, this)
+{
+}
+
+IOThread::~IOThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Work.notify_one();
+    m_Thread.join();
+}
+
+void IOThread::Push(std::function<void()> task)
+{
+    const std::size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+    if (tail - m_Head.load(std::memory_order_acquire) == m_Tasks.size())
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this, tail] {
+            return tail - m_Head.load(std::memory_order_acquire) <
+                   m_Tasks.size();
+        });
+    }
+
+    m_Tasks[tail % m_Tasks.size()] = std::move(task);
+    m_Tail.store(tail + 1, std::memory_order_release);
+
+    // empty critical section, the consumer is either before its predicate
+    // check or already waiting
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+    }
+    m_Work.notify_one();
+}
+
+void IOThread::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Done.wait(lock, [this] { return IsIdle(); });
+
+    if (m_Exception)
+    {
+        std::exception_ptr exception = nullptr;
+        std::swap(exception, m_Exception);
+        std::rethrow_exception(exception);
+    }
+}
+
+bool IOThread::IsIdle() const noexcept
+{
+    return m_Head.load(std::memory_order_acquire) ==
+           m_Tail.load(std::memory_order_acquire);
+}
+
+// PRIVATE
+void IOThread::Run()
+{
+    std::size_t head = m_Head.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        if (head == m_Tail.load(std::memory_order_acquire))
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Work.wait(lock, [this, head] {
+                return m_Stop ||
+                       head != m_Tail.load(std::memory_order_acquire);
+            });
+
+            if (head == m_Tail.load(std::memory_order_acquire)) // stop
+            {
+                return;
+            }
+        }
+
+        std::function<void()> &task = m_Tasks[head % m_Tasks.size()];
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Exception)
+            {
+                m_Exception = std::current_exception();
+            }
+        }
+        task = nullptr; // release captures before the slot is reused
+
+        m_Head.store(++head, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+        }
+        m_Done.notify_all();
+    }
+}
+
+} // end namespace adios
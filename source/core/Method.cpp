@@ -8,6 +8,7 @@
  *      Author: wfg
  */
 
+#include <stdexcept> //std::invalid_argument
 #include <utility>
 
 #include "core/Method.h"
@@ -0,0 +1,118 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * ThreadPool.cpp
+ *
+ *  Created on: May 3, 2017
+ *      Author: wfg
+ */
+
+#include <utility> //std::move, std::swap
+
+#include "core/ThreadPool.h"
+
+namespace adios
+{
+
+ThreadPool::ThreadPool(const unsigned int threads)
+{
+    const unsigned int workers = (threads > 1) ? threads - 1 : 0;
+    m_Workers.reserve(workers);
+    for (unsigned int w = 0; w < workers; ++w)
+    {
+        m_Workers.push_back(std::thread(&ThreadPool::Run, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+        m_Tasks.clear();
+    }
+    m_Work.notify_all();
+
+    for (auto &worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_Work.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (m_Tasks.empty() == false)
+    {
+        RunTask(lock);
+    }
+    m_Done.wait(lock, [this] { return m_Running == 0; });
+
+    if (m_Exception)
+    {
+        std::exception_ptr exception = nullptr;
+        std::swap(exception, m_Exception);
+        std::rethrow_exception(exception);
+    }
+}
+
+unsigned int ThreadPool::GetThreads() const noexcept
+{
+    return static_cast<unsigned int>(m_Workers.size()) + 1;
+}
+
+// PRIVATE
+void ThreadPool::Run()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true)
+    {
+        m_Work.wait(lock, [this] { return m_Stop || !m_Tasks.empty(); });
+        if (m_Stop == true)
+        {
+            return;
+        }
+        RunTask(lock);
+    }
+}
+
+void ThreadPool::RunTask(std::unique_lock<std::mutex> &lock)
+{
+    std::function<void()> task(std::move(m_Tasks.front()));
+    m_Tasks.pop_front();
+    ++m_Running;
+
+    lock.unlock();
+    try
+    {
+        task();
+    }
+    catch (...)
+    {
+        lock.lock();
+        if (!m_Exception)
+        {
+            m_Exception = std::current_exception();
+        }
+        lock.unlock();
+    }
+    task = nullptr; // release captures outside the lock
+    lock.lock();
+
+    if (--m_Running == 0 && m_Tasks.empty())
+    {
+        m_Done.notify_all();
+    }
+}
+
+} // end namespace adios
@@ -24,6 +24,14 @@ Transport::Transport(std::string type, MPI_Comm mpiComm, bool debugMode)
 
 void Transport::SetBuffer(char * /*buffer*/, size_t /*size*/) {}
 
+void Transport::WriteV(const iovec *iov, const int iovcnt)
+{
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        Write(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+}
+
 void Transport::Flush() {}
 
 void Transport::Close() {}
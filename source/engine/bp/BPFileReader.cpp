@@ -8,6 +8,17 @@
  *      Author: wfg
  */
 
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::sort, std::max
+#include <cstdio>    //std::rename, std::remove
+#include <fstream>   //std::ofstream
+#include <ios>       //std::ios_base::failure
+#include <set>
+
+#include <sys/stat.h> //stat
+#include <unistd.h>   //access, getpid
+/// \endcond
+
 #include "engine/bp/BPFileReader.h"
 
 #include "core/Support.h"
@@ -144,7 +155,383 @@ BPFileReader::InquireVariableCompound(const std::string /*name*/,
     return nullptr;
 }
 
-void BPFileReader::Close(const int /*transportIndex*/) {}
+void BPFileReader::Read(Variable<char> &variable, const char *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<unsigned char> &variable,
+                        const unsigned char *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<short> &variable, const short *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<unsigned short> &variable,
+                        const unsigned short *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<int> &variable, const int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<unsigned int> &variable,
+                        const unsigned int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<long int> &variable, const long int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<unsigned long int> &variable,
+                        const unsigned long int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<long long int> &variable,
+                        const long long int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<unsigned long long int> &variable,
+                        const unsigned long long int *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<float> &variable, const float *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<double> &variable, const double *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<long double> &variable,
+                        const long double *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<std::complex<float>> &variable,
+                        const std::complex<float> *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<std::complex<double>> &variable,
+                        const std::complex<double> *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::Read(Variable<std::complex<long double>> &variable,
+                        const std::complex<long double> *values)
+{
+    ReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<char> &variable, const char *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<unsigned char> &variable,
+                                const unsigned char *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<short> &variable, const short *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<unsigned short> &variable,
+                                const unsigned short *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<int> &variable, const int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<unsigned int> &variable,
+                                const unsigned int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<long int> &variable,
+                                const long int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<unsigned long int> &variable,
+                                const unsigned long int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<long long int> &variable,
+                                const long long int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<unsigned long long int> &variable,
+                                const unsigned long long int *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<float> &variable, const float *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<double> &variable,
+                                const double *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<long double> &variable,
+                                const long double *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<std::complex<float>> &variable,
+                                const std::complex<float> *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<std::complex<double>> &variable,
+                                const std::complex<double> *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::ScheduleRead(Variable<std::complex<long double>> &variable,
+                                const std::complex<long double> *values)
+{
+    ScheduleReadCommon(variable, values);
+}
+
+void BPFileReader::PerformReads(PerformReadMode /*mode*/)
+{
+    // every read without user memory gets its own engine buffer, so
+    // selections of the same variable don't overlap, the first one reuses
+    // the buffer of previous reads of the variable
+    for (auto &read : m_ScheduledReads)
+    {
+        if (read.Values != nullptr)
+        {
+            continue;
+        }
+
+        auto itBuffer = m_ReadBuffers.find(read.Name);
+        if (itBuffer != m_ReadBuffers.end())
+        {
+            read.Buffer.swap(itBuffer->second);
+            m_ReadBuffers.erase(itBuffer);
+        }
+        read.Buffer.resize(read.Size);
+        read.Values = read.Buffer.data();
+        read.IsEngineBuffer = true;
+    }
+
+    std::sort(m_ScheduledBlocks.begin(), m_ScheduledBlocks.end(),
+              [](const ScheduledBlock &a, const ScheduledBlock &b) {
+                  if (a.Block->FileIndex != b.Block->FileIndex)
+                  {
+                      return a.Block->FileIndex < b.Block->FileIndex;
+                  }
+                  return a.Begin < b.Begin;
+              });
+
+    // near extents of the same file are requested as one
+    std::vector<Extent> extents;
+    extents.reserve(m_ScheduledBlocks.size());
+    for (const auto &scheduledBlock : m_ScheduledBlocks)
+    {
+        extents.push_back({scheduledBlock.Block->FileIndex,
+                           scheduledBlock.Begin, scheduledBlock.End});
+    }
+    CoalesceExtents(extents);
+    for (const auto &extent : extents)
+    {
+        GetDataFile(extent.FileIndex)
+            .Prefetch(extent.Begin, extent.End - extent.Begin);
+    }
+
+    // scatter in file order
+    std::vector<BlockCopy> copies;
+    copies.reserve(m_ScheduledBlocks.size());
+    for (const auto &scheduledBlock : m_ScheduledBlocks)
+    {
+        const format::BP1Block &block = *scheduledBlock.Block;
+        const char *payload = GetPayload(block, scheduledBlock.PayloadSize);
+        if (payload == nullptr)
+        {
+            continue;
+        }
+
+        const ScheduledRead &read = m_ScheduledReads[scheduledBlock.Read];
+        copies.push_back({payload, &block, read.Values, &read.Start,
+                          &read.Count, read.ElementSize});
+    }
+    CopyBlocks(copies);
+
+    // in schedule order, the variable keeps the buffer of its last read
+    for (auto &read : m_ScheduledReads)
+    {
+        read.SetAppValues(read.Values);
+        if (read.IsEngineBuffer == true)
+        {
+            m_ReadBuffers[read.Name].swap(read.Buffer);
+        }
+    }
+
+    m_ScheduledReads.clear();
+    m_ScheduledBlocks.clear();
+    ReadAhead();
+}
+
+QueryResult BPFileReader::Query(Variable<char> &variable, const char lo,
+                                const char hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<unsigned char> &variable,
+                                const unsigned char lo, const unsigned char hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<short> &variable, const short lo,
+                                const short hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<unsigned short> &variable,
+                                const unsigned short lo,
+                                const unsigned short hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<int> &variable, const int lo,
+                                const int hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<unsigned int> &variable,
+                                const unsigned int lo, const unsigned int hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<long int> &variable, const long int lo,
+                                const long int hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<unsigned long int> &variable,
+                                const unsigned long int lo,
+                                const unsigned long int hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<long long int> &variable,
+                                const long long int lo, const long long int hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<unsigned long long int> &variable,
+                                const unsigned long long int lo,
+                                const unsigned long long int hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<float> &variable, const float lo,
+                                const float hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<double> &variable, const double lo,
+                                const double hi, const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+QueryResult BPFileReader::Query(Variable<long double> &variable,
+                                const long double lo, const long double hi,
+                                const SelectionType type)
+{
+    return QueryCommon(variable, lo, hi, type);
+}
+
+void BPFileReader::Advance(float /*timeout_sec*/)
+{
+    if (m_CurrentStep < m_MetadataSet.TimeSteps.size())
+    {
+        ++m_CurrentStep;
+    }
+    ReadAhead();
+}
+
+void BPFileReader::Close(const int /*transportIndex*/)
+{
+    if (m_ReadAhead != nullptr)
+    {
+        m_ReadAhead->Wait(); // uses mapped data files
+    }
+    m_ReadPattern.clear();
+    m_ReadAheadSizes.clear();
+    m_ScheduledReads.clear();
+    m_ScheduledBlocks.clear();
+    m_ReadBuffers.clear();
+    m_DataFiles.clear();
+    m_MetadataSet.VarsOffsets.clear();
+    m_MetadataSet.VarsIndices.clear();
+    m_MetadataSet.AttributesOffsets.clear();
+    m_MetadataSet.AttributesIndices.clear();
+    m_MetadataFile.reset();
+}
 
 // PRIVATE
 void BPFileReader::Init()
@@ -160,13 +547,95 @@ void BPFileReader::Init()
         }
     }
 
+    InitParameters();
     InitCapsules();
     InitTransports();
 }
 
+void BPFileReader::InitParameters()
+{
+    if (m_nThreads < static_cast<unsigned int>(m_Method.m_nThreads))
+    {
+        m_nThreads = m_Method.m_nThreads; // from Method AllowThreads
+    }
+    if (m_nThreads > 1)
+    {
+        m_ThreadPool.reset(new ThreadPool(m_nThreads));
+    }
+
+    auto itReadAheadSteps = m_Method.m_Parameters.find("read_ahead_steps");
+    if (itReadAheadSteps != m_Method.m_Parameters.end())
+    {
+        m_ReadAheadSteps = std::stoul(itReadAheadSteps->second);
+        if (m_ReadAheadSteps > 0)
+        {
+            // room for loads of steps already reached and still running, so
+            // Advance doesn't block on a full ring
+            m_ReadAhead.reset(new IOThread(2 * m_ReadAheadSteps));
+        }
+    }
+
+    auto itReadAheadSize = m_Method.m_Parameters.find("read_ahead_MB");
+    if (itReadAheadSize != m_Method.m_Parameters.end())
+    {
+        m_ReadAheadMaxSize = std::stoul(itReadAheadSize->second) * 1048576;
+    }
+
+    auto itIndexCache = m_Method.m_Parameters.find("index_cache");
+    if (itIndexCache != m_Method.m_Parameters.end())
+    {
+        m_IndexCache =
+            (itIndexCache->second == "yes" || itIndexCache->second == "true");
+    }
+
+    auto itReadGap = m_Method.m_Parameters.find("read_gap_KB");
+    if (itReadGap != m_Method.m_Parameters.end())
+    {
+        m_ReadGap = std::stoul(itReadGap->second) * 1024;
+    }
+}
+
 void BPFileReader::InitCapsules()
 {
-    // here init memory capsules
+    m_BP1Reader.m_DebugMode = m_DebugMode;
+
+    // global metadata file indexes all (sub)files, files written without it
+    // have a single rank file with its own footer
+    std::string fileName(m_BP1Reader.GetMetadataFileName(m_Name));
+    if (access(fileName.c_str(), F_OK) != 0)
+    {
+        const std::string directory(m_BP1Reader.GetDirectoryName(m_Name));
+        fileName = directory + "/" + directory + ".0";
+    }
+
+    const std::string cacheName(m_BP1Reader.GetDirectoryName(m_Name) +
+                                ".cache");
+    if (m_IndexCache == true && OpenIndexCache(cacheName, fileName) == true)
+    {
+        return;
+    }
+
+    m_MetadataFile.reset(
+        new capsule::MMapFile("r", m_RankMPI, fileName, m_DebugMode));
+
+    if (m_MetadataFile->GetDataSize() == 0)
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::ios_base::failure("ERROR: metadata file " + fileName +
+                                         " is empty, in " + m_Name +
+                                         m_EndMessage);
+        }
+        return;
+    }
+
+    m_BP1Reader.ParseMetadata(m_MetadataFile->GetData(),
+                              m_MetadataFile->GetDataSize(), m_MetadataSet);
+
+    if (m_IndexCache == true && m_RankMPI == 0)
+    {
+        SaveIndexCache(cacheName, fileName);
+    }
 }
 
 void BPFileReader::InitTransports() // maybe move this?
@@ -238,4 +707,482 @@ void BPFileReader::InitTransports() // maybe move this?
     }
 }
 
+bool BPFileReader::OpenIndexCache(const std::string &cacheName,
+                                  const std::string &metadataFileName)
+{
+    if (access(cacheName.c_str(), R_OK) != 0)
+    {
+        return false;
+    }
+
+    // a bad cache is not an error, it is rebuilt from the metadata
+    std::unique_ptr<capsule::MMapFile> cacheFile(
+        new capsule::MMapFile("r", m_RankMPI, cacheName, false));
+
+    // on failure m_MetadataSet is set again by ParseMetadata
+    std::vector<format::BP1CacheSource> sources;
+    if (m_BP1Reader.ParseIndexCache(cacheFile->GetData(),
+                                    cacheFile->GetDataSize(), m_MetadataSet,
+                                    sources) == false)
+    {
+        return false;
+    }
+
+    for (const auto &source : sources)
+    {
+        const std::string fileName(source.IsMetadata
+                                       ? metadataFileName
+                                       : GetDataFileName(source.FileIndex));
+        format::BP1CacheSource current;
+        if (GetCacheSource(fileName, current) == false ||
+            current.Size != source.Size ||
+            current.ModifiedSeconds != source.ModifiedSeconds ||
+            current.ModifiedNanoseconds != source.ModifiedNanoseconds)
+        {
+            return false;
+        }
+    }
+
+    m_MetadataFile = std::move(cacheFile);
+    return true;
+}
+
+void BPFileReader::SaveIndexCache(const std::string &cacheName,
+                                  const std::string &metadataFileName)
+{
+    m_BP1Reader.ParseAllVarsIndices(m_MetadataSet);
+
+    std::set<std::uint32_t> fileIndices;
+    for (const auto &varIndexPair : m_MetadataSet.VarsIndices)
+    {
+        for (const auto &block : varIndexPair.second.Blocks)
+        {
+            fileIndices.insert(block.FileIndex);
+        }
+    }
+
+    std::vector<format::BP1CacheSource> sources(1);
+    sources.front().IsMetadata = true;
+    if (GetCacheSource(metadataFileName, sources.front()) == false)
+    {
+        return;
+    }
+    for (const auto fileIndex : fileIndices)
+    {
+        format::BP1CacheSource source;
+        source.FileIndex = fileIndex;
+        if (GetCacheSource(GetDataFileName(fileIndex), source) == false)
+        {
+            return;
+        }
+        sources.push_back(source);
+    }
+
+    const std::vector<char> cache(
+        m_BP1Reader.GetIndexCache(m_MetadataSet, sources));
+
+    const std::string temporaryName(cacheName + "." +
+                                    std::to_string(getpid()));
+    std::ofstream file(temporaryName, std::ios::binary | std::ios::trunc);
+    file.write(cache.data(), cache.size());
+    file.close();
+
+    if (file.good() == false ||
+        std::rename(temporaryName.c_str(), cacheName.c_str()) != 0)
+    {
+        std::remove(temporaryName.c_str());
+    }
+}
+
+bool BPFileReader::GetCacheSource(const std::string &fileName,
+                                  format::BP1CacheSource &source) const
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+
+    source.Size = fileStat.st_size;
+    source.ModifiedSeconds = fileStat.st_mtim.tv_sec;
+    source.ModifiedNanoseconds = fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+std::string BPFileReader::GetDataFileName(const std::uint32_t fileIndex) const
+{
+    const std::string directory(m_BP1Reader.GetDirectoryName(m_Name));
+    return directory + "/" + directory + "." + std::to_string(fileIndex);
+}
+
+capsule::MMapFile &BPFileReader::GetDataFile(const std::uint32_t fileIndex)
+{
+    auto itFile = m_DataFiles.find(fileIndex);
+    if (itFile == m_DataFiles.end())
+    {
+        itFile = m_DataFiles
+                     .emplace(fileIndex,
+                              std::unique_ptr<capsule::MMapFile>(
+                                  new capsule::MMapFile(
+                                      "r", m_RankMPI,
+                                      GetDataFileName(fileIndex),
+                                      m_DebugMode)))
+                     .first;
+    }
+    return *itFile->second;
+}
+
+const char *BPFileReader::GetPayload(const format::BP1Block &block,
+                                     const std::size_t payloadSize)
+{
+    capsule::MMapFile &file = GetDataFile(block.FileIndex);
+    const std::size_t fileSize = file.GetDataSize();
+    if (block.PayloadOffset > fileSize ||
+        payloadSize > fileSize - block.PayloadOffset)
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::ios_base::failure(
+                "ERROR: block payload at offset " +
+                std::to_string(block.PayloadOffset) + " is beyond file " +
+                std::to_string(block.FileIndex) + " of size " +
+                std::to_string(fileSize) + ", in " + m_Name + "\n");
+        }
+        return nullptr;
+    }
+    return file.GetData() + block.PayloadOffset;
+}
+
+bool BPFileReader::GetSelectedBytes(const format::BP1Block &block,
+                                    const Dims &start, const Dims &count,
+                                    const std::size_t elementSize,
+                                    std::uint64_t &begin,
+                                    std::uint64_t &end) const
+{
+    const std::size_t dimensions = start.size();
+    if (block.Count.size() != dimensions || count.size() != dimensions)
+    {
+        return false;
+    }
+
+    // first and last selected elements bound the bytes to fetch
+    const Dims blockStart = GetBlockStart(block, dimensions);
+    std::size_t first = 0, last = 0;
+    for (std::size_t d = 0; d < dimensions; ++d)
+    {
+        const std::size_t lower = std::max(blockStart[d], start[d]);
+        const std::size_t upper =
+            std::min(blockStart[d] + block.Count[d], start[d] + count[d]);
+        if (upper <= lower)
+        {
+            return false;
+        }
+        first = first * block.Count[d] + (lower - blockStart[d]);
+        last = last * block.Count[d] + (upper - 1 - blockStart[d]);
+    }
+
+    begin = block.PayloadOffset + first * elementSize;
+    end = block.PayloadOffset + (last + 1) * elementSize;
+    return true;
+}
+
+void BPFileReader::CoalesceExtents(std::vector<Extent> &extents) const
+{
+    if (extents.empty())
+    {
+        return;
+    }
+
+    std::sort(extents.begin(), extents.end(),
+              [](const Extent &a, const Extent &b) {
+                  if (a.FileIndex != b.FileIndex)
+                  {
+                      return a.FileIndex < b.FileIndex;
+                  }
+                  return a.Begin < b.Begin;
+              });
+
+    std::size_t merged = 0;
+    for (std::size_t i = 1; i < extents.size(); ++i)
+    {
+        Extent &last = extents[merged];
+        const Extent &next = extents[i];
+        if (next.FileIndex == last.FileIndex &&
+            next.Begin <= last.End + m_ReadGap)
+        {
+            last.End = std::max(last.End, next.End);
+        }
+        else
+        {
+            extents[++merged] = next;
+        }
+    }
+    extents.resize(merged + 1);
+}
+
+void BPFileReader::ReadAhead()
+{
+    const auto &timeSteps = m_MetadataSet.TimeSteps;
+    if (m_ReadAhead == nullptr || m_ReadPattern.empty() ||
+        m_CurrentStep >= timeSteps.size())
+    {
+        return;
+    }
+
+    // steps reached are no longer ahead
+    m_ReadAheadSizes.erase(m_ReadAheadSizes.begin(),
+                           m_ReadAheadSizes.upper_bound(m_CurrentStep));
+    std::size_t queuedSize = 0;
+    for (const auto &stepSize : m_ReadAheadSizes)
+    {
+        queuedSize += stepSize.second;
+    }
+
+    const std::size_t lastStep =
+        std::min(m_CurrentStep + m_ReadAheadSteps, timeSteps.size() - 1);
+
+    for (std::size_t step = m_CurrentStep + 1; step <= lastStep; ++step)
+    {
+        if (m_ReadAheadSizes.count(step) == 1)
+        {
+            continue;
+        }
+
+        std::vector<Extent> extents;
+        std::size_t stepSize = 0;
+        for (const auto &patternPair : m_ReadPattern)
+        {
+            const format::BP1VarIndex *varIndex =
+                m_BP1Reader.GetVarIndex(patternPair.first, m_MetadataSet);
+            if (varIndex == nullptr)
+            {
+                continue;
+            }
+
+            std::vector<const format::BP1Block *> blocks =
+                m_BP1Reader.GetStepBlocks(*varIndex, timeSteps[step]);
+            const ReadPattern &pattern = patternPair.second;
+            for (const auto block : blocks)
+            {
+                if (block->IsTransformed == true)
+                {
+                    continue;
+                }
+
+                std::uint64_t begin = block->PayloadOffset;
+                std::uint64_t end =
+                    begin + GetTotalSize(block->Count) * pattern.ElementSize;
+                if (pattern.IsLocal == false &&
+                    GetSelectedBytes(*block, pattern.Start, pattern.Count,
+                                     pattern.ElementSize, begin,
+                                     end) == false)
+                {
+                    continue;
+                }
+
+                extents.push_back({block->FileIndex, begin, end});
+                stepSize += end - begin;
+                if (pattern.IsLocal == true)
+                {
+                    break; // local variables read their first block
+                }
+            }
+        }
+
+        if (queuedSize + stepSize > m_ReadAheadMaxSize)
+        {
+            break;
+        }
+        queuedSize += stepSize;
+        m_ReadAheadSizes[step] = stepSize;
+
+        // files are mapped here, the read-ahead thread only loads pages
+        CoalesceExtents(extents);
+        std::vector<std::pair<capsule::MMapFile *, Extent>> loads;
+        loads.reserve(extents.size());
+        for (const auto &extent : extents)
+        {
+            loads.emplace_back(&GetDataFile(extent.FileIndex), extent);
+        }
+
+        m_ReadAhead->Push([loads] {
+            for (const auto &load : loads)
+            {
+                load.first->Load(load.second.Begin,
+                                 load.second.End - load.second.Begin);
+            }
+        });
+    }
+}
+
+void BPFileReader::CopyBlocks(const std::vector<BlockCopy> &copies)
+{
+    auto lf_Copy = [this](const BlockCopy &copy, const char *payload,
+                          const Dims &blockStart, const Dims &blockCount) {
+        CopyIntersection(payload, blockStart, blockCount, copy.Destination,
+                         *copy.Start, *copy.Count, copy.ElementSize);
+    };
+
+    if (m_ThreadPool == nullptr)
+    {
+        for (const auto &copy : copies)
+        {
+            lf_Copy(copy, copy.Payload,
+                    GetBlockStart(*copy.Block, copy.Start->size()),
+                    copy.Block->Count);
+        }
+        return;
+    }
+
+    // slabs of the first dimension rows that intersect the selection, large
+    // blocks are shared among threads, small blocks are grouped in tasks of
+    // about taskSize bytes
+    struct Slab
+    {
+        const BlockCopy *Copy;
+        const char *Payload;
+        Dims Start;
+        Dims Count;
+    };
+    const std::size_t taskSize = 1048576;
+
+    auto lf_PushTask = [&](std::vector<Slab> &slabs) {
+        if (slabs.empty())
+        {
+            return;
+        }
+        m_ThreadPool->Push([lf_Copy, slabs] {
+            for (const auto &slab : slabs)
+            {
+                lf_Copy(*slab.Copy, slab.Payload, slab.Start, slab.Count);
+            }
+        });
+        slabs.clear();
+    };
+
+    std::vector<Slab> slabs;
+    std::size_t slabsSize = 0;
+    for (const auto &copy : copies)
+    {
+        const Dims &count = copy.Block->Count;
+        const Dims blockStart = GetBlockStart(*copy.Block, copy.Start->size());
+        if (count.empty() || count.size() != copy.Start->size())
+        {
+            lf_Copy(copy, copy.Payload, blockStart, count);
+            continue;
+        }
+
+        const std::size_t lower = std::max(blockStart[0], (*copy.Start)[0]);
+        const std::size_t upper = std::min(
+            blockStart[0] + count[0], (*copy.Start)[0] + (*copy.Count)[0]);
+        if (upper <= lower)
+        {
+            continue;
+        }
+
+        const std::size_t rowSize =
+            GetTotalSize(count) / count[0] * copy.ElementSize;
+        if (rowSize == 0)
+        {
+            continue;
+        }
+        const std::size_t slabRows =
+            std::max(static_cast<std::size_t>(1), taskSize / rowSize);
+
+        for (std::size_t row = lower; row < upper; row += slabRows)
+        {
+            Slab slab{&copy, copy.Payload + (row - blockStart[0]) * rowSize,
+                      blockStart, count};
+            slab.Start[0] = row;
+            slab.Count[0] = std::min(slabRows, upper - row);
+            slabsSize += slab.Count[0] * rowSize;
+            slabs.push_back(std::move(slab));
+
+            if (slabsSize >= taskSize)
+            {
+                lf_PushTask(slabs);
+                slabsSize = 0;
+            }
+        }
+    }
+    lf_PushTask(slabs);
+    m_ThreadPool->Wait();
+}
+
+bool BPFileReader::GetIntersection(const format::BP1Block &block,
+                                   const Dims &start, const Dims &count,
+                                   Dims &intersectionStart,
+                                   Dims &intersectionCount) const
+{
+    const std::size_t dimensions = start.size();
+    const Dims blockStart = GetBlockStart(block, dimensions);
+    intersectionStart.resize(dimensions);
+    intersectionCount.resize(dimensions);
+    for (std::size_t d = 0; d < dimensions; ++d)
+    {
+        const std::size_t lower = std::max(blockStart[d], start[d]);
+        const std::size_t upper =
+            std::min(blockStart[d] + block.Count[d], start[d] + count[d]);
+        if (upper <= lower)
+        {
+            return false;
+        }
+        intersectionStart[d] = lower;
+        intersectionCount[d] = upper - lower;
+    }
+    return true;
+}
+
+void BPFileReader::GetQueryResult(std::vector<QueryBlock> &queries,
+                                  QueryResult &result) const
+{
+    std::size_t pointsSize = 0;
+    for (const auto &query : queries)
+    {
+        pointsSize += query.Points.size();
+    }
+    result.Points.reserve(pointsSize);
+
+    for (auto &query : queries)
+    {
+        if (query.Hits == 0)
+        {
+            continue;
+        }
+        result.Count += query.Hits;
+
+        if (result.Type == SelectionType::Points)
+        {
+            result.Points.insert(result.Points.end(), query.Points.begin(),
+                                 query.Points.end());
+            std::vector<std::uint64_t>().swap(query.Points);
+            continue;
+        }
+
+        std::vector<std::uint64_t> start(query.BoxFirst.size());
+        std::vector<std::uint64_t> count(query.BoxFirst.size());
+        for (std::size_t d = 0; d < start.size(); ++d)
+        {
+            start[d] = query.BoxFirst[d];
+            count[d] = query.BoxLast[d] - query.BoxFirst[d] + 1;
+        }
+        result.Boxes.emplace_back(start, count);
+    }
+}
+
+Dims BPFileReader::GetBlockStart(const format::BP1Block &block,
+                                 const std::size_t dimensions) const
+{
+    return block.Start.empty() ? Dims(dimensions, 0) : block.Start;
+}
+
+std::uint32_t BPFileReader::GetCurrentTimeStep() const noexcept
+{
+    if (m_CurrentStep < m_MetadataSet.TimeSteps.size())
+    {
+        return m_MetadataSet.TimeSteps[m_CurrentStep];
+    }
+    return 0;
+}
+
 } // end namespace adios
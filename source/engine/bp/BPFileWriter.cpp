@@ -16,6 +16,11 @@
 #include "transport/file/FStream.h"
 #include "transport/file/FileDescriptor.h"
 #include "transport/file/FilePointer.h"
+#include "transport/file/MPI_File.h"
+
+#ifdef ADIOS_HAVE_IOURING // optional, Linux only
+#include "transport/file/IOUring.h"
+#endif
 
 namespace adios
 {
@@ -29,6 +34,7 @@ BPFileWriter::BPFileWriter(ADIOS &adios, std::string name,
          debugMode, nthreads,
          " BPFileWriter constructor (or call to ADIOS Open).\n"),
   m_Buffer(accessMode, m_RankMPI, m_DebugMode),
+  m_BackBuffer(accessMode, m_RankMPI, m_DebugMode),
   m_BP1Aggregator(m_MPIComm, debugMode),
   m_MaxBufferSize(m_Buffer.m_Data.max_size())
 {
@@ -41,6 +47,13 @@ BPFileWriter::~BPFileWriter() = default;
 
 void BPFileWriter::Init()
 {
+    if (m_nThreads < static_cast<unsigned int>(m_Method.m_nThreads))
+    {
+        m_nThreads = m_Method.m_nThreads; // from Method AllowThreads
+    }
+    m_BP1Writer.m_Threads = m_nThreads;
+    m_BP1Writer.m_DebugMode = m_DebugMode;
+
     InitParameters();
     InitTransports();
     InitProcessGroup();
@@ -249,39 +262,91 @@ void BPFileWriter::Write(const std::string /*variableName*/,
 void BPFileWriter::Advance(float /*timeout_sec*/)
 {
     m_BP1Writer.Advance(m_MetadataSet, m_Buffer);
+
+    if (m_IOThread)
+    {
+        WriteStepAsync(nullptr);
+    }
+    else if (m_FlushSteps == true) // closed pg only, buffer keeps capacity
+    {
+        m_BP1Writer.Flush(m_MetadataSet, m_Buffer, m_Transports);
+    }
+}
+
+void BPFileWriter::AdvanceAsync(
+    AdvanceMode /*mode*/,
+    std::function<void(std::shared_ptr<adios::Engine>)> callback)
+{
+    m_BP1Writer.Advance(m_MetadataSet, m_Buffer);
+
+    if (m_IOThread)
+    {
+        WriteStepAsync(std::move(callback));
+        return;
+    }
+
+    if (m_FlushSteps == true)
+    {
+        m_BP1Writer.Flush(m_MetadataSet, m_Buffer, m_Transports);
+    }
+
+    if (callback) // step is written or stays buffered until Close
+    {
+        callback(std::shared_ptr<Engine>(this, [](Engine *) {}));
+    }
 }
 
 void BPFileWriter::Close(const int transportIndex)
 {
     CheckTransportIndex(transportIndex);
-    if (transportIndex == -1)
+    WaitForIOThread();
+
+    if (m_BP1Aggregator.m_SubFiles > 0) // N-to-M, collective
+    {
+        if (m_DebugMode == true)
+        {
+            if (transportIndex != -1)
+            {
+                throw std::invalid_argument(
+                    "ERROR: Close of a single transport is not supported with "
+                    "Aggregation, in " +
+                    m_Name + m_EndMessage);
+            }
+        }
+        m_BP1Writer.Close(m_MetadataSet, m_Buffer, m_Transports,
+                          m_BP1Aggregator);
+    }
+    else if (transportIndex == -1)
     {
         for (auto &transport : m_Transports)
         { // by reference or value or it doesn't matter?
             m_BP1Writer.Close(m_MetadataSet, m_Buffer, *transport,
-                              m_IsFirstClose,
-                              false); // false: not using aggregation for now
+                              m_IsFirstClose);
         }
     }
     else
     {
         m_BP1Writer.Close(m_MetadataSet, m_Buffer,
-                          *m_Transports[transportIndex], m_IsFirstClose,
-                          false); // false: not using aggregation for now
+                          *m_Transports[transportIndex], m_IsFirstClose);
     }
 
-    if (m_MetadataSet.Log.m_IsActive == true)
+    bool allClose = true;
+    for (auto &transport : m_Transports)
     {
-        bool allClose = true;
-        for (auto &transport : m_Transports)
+        if (transport->m_IsOpen == true)
         {
-            if (transport->m_IsOpen == true)
-            {
-                allClose = false;
-                break;
-            }
+            allClose = false;
+            break;
         }
-        if (allClose == true) // aggregate and write profiling.log
+    }
+
+    if (allClose == true)
+    {
+        WriteGlobalMetadata(); // collective
+        m_BP1Aggregator.FreeSubFileComm();
+
+        if (m_MetadataSet.Log.m_IsActive == true) // aggregate and write
+                                                  // profiling.log
         {
             const std::string rankLog = m_BP1Writer.GetRankProfilingLog(
                 m_RankMPI, m_MetadataSet, m_Transports);
@@ -294,6 +359,88 @@ void BPFileWriter::Close(const int transportIndex)
 }
 
 // PRIVATE FUNCTIONS
+void BPFileWriter::WaitForIOThread()
+{
+    if (m_IOThread)
+    {
+        m_IOThread->Wait();
+    }
+}
+
+void BPFileWriter::WriteStepAsync(
+    std::function<void(std::shared_ptr<adios::Engine>)> callback)
+{
+    // back buffer is free once the previous step is written
+    m_IOThread->Wait();
+
+    // the closed step moves to the back buffer, the front buffer keeps its
+    // capacity for the next step and the absolute position for offsets
+    m_BackBuffer.m_Data.swap(m_Buffer.m_Data);
+    m_Buffer.m_Data.clear();
+    m_Buffer.m_DataPosition = 0;
+
+    m_IOThread->Push([this, callback]() {
+        for (auto &transport : m_Transports)
+        {
+            transport->Write(m_BackBuffer.m_Data.data(),
+                             m_BackBuffer.m_Data.size());
+        }
+
+        if (callback)
+        {
+            // non-owning, the destructor joins the I/O thread first
+            callback(std::shared_ptr<Engine>(this, [](Engine *) {}));
+        }
+    });
+}
+
+void BPFileWriter::WriteGlobalMetadata()
+{
+    // (sub)file metadata was flattened at the end of the buffer by the first
+    // Close, empty in ranks without a file
+    const std::size_t position = m_MetadataSet.MetadataPosition;
+    std::vector<std::size_t> rankSizes;
+    const std::vector<char> rankMetadata = m_BP1Aggregator.GatherBuffers(
+        m_Buffer.m_Data.data() + position, m_Buffer.m_Data.size() - position,
+        rankSizes);
+
+    if (m_RankMPI == 0)
+    {
+        std::vector<std::uint32_t> fileIndices(rankSizes.size());
+        for (std::size_t r = 0; r < fileIndices.size(); ++r)
+        {
+            fileIndices[r] =
+                m_BP1Aggregator.GetSubFileIndex(static_cast<int>(r));
+        }
+
+        capsule::STLVector globalMetadata(m_AccessMode, m_RankMPI, m_DebugMode);
+        m_BP1Writer.AggregateMetadata(rankMetadata, rankSizes, fileIndices,
+                                      globalMetadata);
+
+        // same library as the data files, rewritten whole at every Close
+        std::map<std::string, std::string> parameters;
+        for (const auto &transportParameters : m_Method.m_TransportParameters)
+        {
+            auto itTransport = transportParameters.find("transport");
+            if (itTransport->second == "file" || itTransport->second == "File")
+            {
+                parameters = transportParameters;
+                break;
+            }
+        }
+
+        auto file = MakeFileTransport(parameters, MPI_COMM_SELF);
+        if (file == nullptr)
+        {
+            return;
+        }
+        file->Open(m_BP1Writer.GetMetadataFileName(m_Name), "w");
+        file->Write(globalMetadata.m_Data.data(),
+                    globalMetadata.m_Data.size());
+        file->Close();
+    }
+}
+
 void BPFileWriter::InitParameters()
 {
     auto itGrowthFactor = m_Method.m_Parameters.find("buffer_growth");
@@ -331,6 +478,144 @@ void BPFileWriter::InitParameters()
 
         m_MaxBufferSize = std::stoul(itMaxBufferSize->second) *
                           1048576; // convert from MB to bytes
+
+        if (m_Buffer.m_Data.capacity() > m_MaxBufferSize) // initial reserve
+        {
+            capsule::HeapBuffer().swap(m_Buffer.m_Data);
+            m_Buffer.m_Data.reserve(m_MaxBufferSize);
+        }
+    }
+
+    auto itAggregation = m_Method.m_Parameters.find("Aggregation");
+
+    // N-to-1, a shared file is written collectively as a single subfile
+    for (const auto &parameters : m_Method.m_TransportParameters)
+    {
+        auto itLibrary = parameters.find("library");
+        if (itLibrary != parameters.end() &&
+            (itLibrary->second == "MPI_File" || itLibrary->second == "MPI-IO"))
+        {
+            if (m_DebugMode == true)
+            {
+                if (m_Method.m_TransportParameters.size() > 1 ||
+                    itAggregation != m_Method.m_Parameters.end())
+                {
+                    throw std::invalid_argument(
+                        "ERROR: MPI_File transport writes a single shared "
+                        "file, it can't be combined with other transports or "
+                        "Aggregation, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+            m_BP1Aggregator.InitSharedFile();
+            break;
+        }
+    }
+
+    if (itAggregation != m_Method.m_Parameters.end() &&
+        m_BP1Aggregator.m_IsSharedFile == false)
+    {
+        if (itAggregation->second == "node") // one subfile per node
+        {
+            m_BP1Aggregator.InitNodeSubFiles();
+        }
+        else
+        {
+            const int subFiles = std::stoi(itAggregation->second);
+            if (m_DebugMode == true)
+            {
+                if (subFiles < 1)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: Method Aggregation argument must be node or "
+                        "a number of subfiles >= 1, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+            m_BP1Aggregator.InitSubFiles(static_cast<unsigned int>(subFiles));
+        }
+    }
+
+    // aggregation is collective at Close, no independent flushes
+    if (m_BP1Aggregator.m_SubFiles > 0 &&
+        m_MaxBufferSize != m_Buffer.m_Data.max_size())
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::invalid_argument(
+                "ERROR: Method max_size_MB is not supported with "
+                "Aggregation or the MPI_File transport, in " +
+                m_Name + m_EndMessage);
+        }
+        m_MaxBufferSize = m_Buffer.m_Data.max_size();
+    }
+
+    auto itFlushSteps = m_Method.m_Parameters.find("flush_steps");
+    if (itFlushSteps != m_Method.m_Parameters.end())
+    {
+        if (itFlushSteps->second == "yes" || itFlushSteps->second == "true")
+        {
+            if (m_BP1Aggregator.m_SubFiles > 0)
+            {
+                if (m_DebugMode == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: Method flush_steps is not supported with "
+                        "Aggregation or the MPI_File transport, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+            else
+            {
+                m_FlushSteps = true;
+            }
+        }
+    }
+
+    auto itDeferred = m_Method.m_Parameters.find("deferred_writes");
+    if (itDeferred != m_Method.m_Parameters.end())
+    {
+        if (itDeferred->second == "yes" || itDeferred->second == "true")
+        {
+            if (m_BP1Aggregator.m_SubFiles > 0)
+            {
+                if (m_DebugMode == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: Method deferred_writes is not supported with "
+                        "Aggregation or the MPI_File transport, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+            else
+            {
+                m_DeferredWrites = true;
+                m_FlushSteps = true; // application memory is released
+            }
+        }
+    }
+
+    auto itAsyncIO = m_Method.m_Parameters.find("async_io");
+    if (itAsyncIO != m_Method.m_Parameters.end())
+    {
+        if (itAsyncIO->second == "yes" || itAsyncIO->second == "true")
+        {
+            if (m_BP1Aggregator.m_SubFiles > 0 || m_DeferredWrites == true)
+            {
+                if (m_DebugMode == true)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: Method async_io is not supported with "
+                        "Aggregation, the MPI_File transport or "
+                        "deferred_writes, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+            else
+            {
+                m_IOThread.reset(new IOThread());
+            }
+        }
     }
 
     auto itVerbosity = m_Method.m_Parameters.find("verbose");
@@ -350,6 +635,24 @@ void BPFileWriter::InitParameters()
         m_BP1Writer.m_Verbosity = verbosity;
     }
 
+    // bins of the characteristic_bitmap index, 0 (default) disables it
+    auto itBitmapBins = m_Method.m_Parameters.find("bitmap_bins");
+    if (itBitmapBins != m_Method.m_Parameters.end())
+    {
+        int bitmapBins = std::stoi(itBitmapBins->second);
+        if (m_DebugMode == true)
+        {
+            if (bitmapBins < 0 || bitmapBins > 65535)
+            {
+                throw std::invalid_argument(
+                    "ERROR: Method bitmap_bins argument must be an "
+                    "integer in the range [0,65535], 0 disables the bitmap "
+                    "index, in call to Open or Engine constructor\n");
+            }
+        }
+        m_BP1Writer.m_BitmapBins = bitmapBins;
+    }
+
     auto itProfile = m_Method.m_Parameters.find("profile_units");
     if (itProfile != m_Method.m_Parameters.end())
     {
@@ -457,60 +760,28 @@ void BPFileWriter::InitTransports()
 
         if (itTransport->second == "file" || itTransport->second == "File")
         {
-            auto itLibrary = parameters.find("library");
-            if (itLibrary == parameters.end() ||
-                itLibrary->second == "POSIX") // use default POSIX
+            auto file = MakeFileTransport(parameters, m_MPIComm);
+            if (file == nullptr)
             {
-                auto file = std::make_shared<transport::FileDescriptor>(
-                    m_MPIComm, m_DebugMode);
-                if (doProfiling == true)
-                {
-                    file->InitProfiler(m_AccessMode, resolution);
-                }
-
-                m_BP1Writer.OpenRankFiles(m_Name, m_AccessMode, *file);
-                m_Transports.push_back(std::move(file));
+                continue;
             }
-            else if (itLibrary->second == "FILE*" ||
-                     itLibrary->second == "stdio")
+            if (doProfiling == true)
             {
-                auto file = std::make_shared<transport::FilePointer>(
-                    m_MPIComm, m_DebugMode);
-                if (doProfiling == true)
-                {
-                    file->InitProfiler(m_AccessMode, resolution);
-                }
-
-                m_BP1Writer.OpenRankFiles(m_Name, m_AccessMode, *file);
-                m_Transports.push_back(std::move(file));
+                file->InitProfiler(m_AccessMode, resolution);
             }
-            else if (itLibrary->second == "fstream" ||
-                     itLibrary->second == "std::fstream")
-            {
-                auto file = std::make_shared<transport::FStream>(m_MPIComm,
-                                                                 m_DebugMode);
 
-                if (doProfiling == true)
-                {
-                    file->InitProfiler(m_AccessMode, resolution);
-                }
-
-                m_BP1Writer.OpenRankFiles(m_Name, m_AccessMode, *file);
-                m_Transports.push_back(std::move(file));
-            }
-            else if (itLibrary->second == "MPI_File" ||
-                     itLibrary->second == "MPI-IO")
+            if (file->m_Type == "MPI_File")
             {
+                // collective, all ranks open the shared subfile
+                m_BP1Writer.OpenRankFiles(m_Name, m_AccessMode, *file, 0);
             }
-            else
+            else if (m_BP1Aggregator.m_IsAggregator == true)
             {
-                if (m_DebugMode == true)
-                {
-                    throw std::invalid_argument(
-                        "ERROR: file transport library " + itLibrary->second +
-                        " not supported, in " + m_Name + m_EndMessage);
-                }
+                m_BP1Writer.OpenRankFiles(
+                    m_Name, m_AccessMode, *file,
+                    m_BP1Aggregator.GetSubFileIndex(m_RankMPI));
             }
+            m_Transports.push_back(std::move(file));
         }
         else
         {
@@ -525,6 +796,118 @@ void BPFileWriter::InitTransports()
     }
 }
 
+std::shared_ptr<Transport> BPFileWriter::MakeFileTransport(
+    const std::map<std::string, std::string> &parameters,
+    MPI_Comm mpiComm) const
+{
+    auto itLibrary = parameters.find("library");
+    if (itLibrary == parameters.end() ||
+        itLibrary->second == "POSIX") // use default POSIX
+    {
+        auto itDirectIO = parameters.find("direct_io");
+        const bool directIO =
+            itDirectIO != parameters.end() &&
+            (itDirectIO->second == "yes" || itDirectIO->second == "true");
+
+        std::size_t blockSize = 0; // transport default
+        auto itBlockSize = parameters.find("block_size_MB");
+        if (itBlockSize != parameters.end())
+        {
+            blockSize = std::stoul(itBlockSize->second) * 1048576;
+            if (m_DebugMode == true)
+            {
+                if (blockSize == 0)
+                {
+                    throw std::invalid_argument(
+                        "ERROR: file transport block_size_MB must be "
+                        "greater than zero, in " +
+                        m_Name + m_EndMessage);
+                }
+            }
+        }
+
+        return std::make_shared<transport::FileDescriptor>(
+            mpiComm, m_DebugMode, directIO, blockSize);
+    }
+
+    if (itLibrary->second == "FILE*" || itLibrary->second == "stdio")
+    {
+        return std::make_shared<transport::FilePointer>(mpiComm, m_DebugMode);
+    }
+
+    if (itLibrary->second == "fstream" || itLibrary->second == "std::fstream")
+    {
+        return std::make_shared<transport::FStream>(mpiComm, m_DebugMode);
+    }
+
+    if (itLibrary->second == "io_uring")
+    {
+#ifdef ADIOS_HAVE_IOURING
+        unsigned int queueDepth = 16;
+        auto itQueueDepth = parameters.find("queue_depth");
+        if (itQueueDepth != parameters.end())
+        {
+            queueDepth =
+                static_cast<unsigned int>(std::stoul(itQueueDepth->second));
+        }
+
+        std::size_t blockSize = 1048576;
+        auto itBlockSize = parameters.find("block_size_MB");
+        if (itBlockSize != parameters.end())
+        {
+            blockSize = std::stoul(itBlockSize->second) * 1048576;
+        }
+
+        if (m_DebugMode == true)
+        {
+            if (queueDepth == 0 || blockSize == 0)
+            {
+                throw std::invalid_argument(
+                    "ERROR: io_uring transport queue_depth and "
+                    "block_size_MB must be greater than zero, in " +
+                    m_Name + m_EndMessage);
+            }
+        }
+
+        return std::make_shared<transport::IOUring>(mpiComm, m_DebugMode,
+                                                    queueDepth, blockSize);
+#else
+        throw std::invalid_argument(
+            "ERROR: this version didn't compile with the io_uring "
+            "transport, use ADIOS_USE_IOURING=ON, in " +
+            m_Name + m_EndMessage);
+#endif
+    }
+
+    if (itLibrary->second == "MPI_File" || itLibrary->second == "MPI-IO")
+    {
+        // MPI_Info hints, e.g. cb_buffer_size, romio_cb_write
+        std::map<std::string, std::string> hints;
+        for (const auto &parameter : parameters)
+        {
+            const std::string &key = parameter.first;
+            if (key.compare(0, 3, "cb_") == 0 ||
+                key.compare(0, 6, "romio_") == 0 ||
+                key.compare(0, 9, "striping_") == 0 ||
+                key.compare(0, 4, "ind_") == 0)
+            {
+                hints.insert(parameter);
+            }
+        }
+
+        return std::make_shared<transport::MPIFile>(mpiComm, m_DebugMode,
+                                                    hints);
+    }
+
+    if (m_DebugMode == true)
+    {
+        throw std::invalid_argument("ERROR: file transport library " +
+                                    itLibrary->second + " not supported, in " +
+                                    m_Name + m_EndMessage);
+    }
+    return nullptr;
+}
+
 void BPFileWriter::InitProcessGroup()
 {
     if (m_MetadataSet.Log.m_IsActive == true)
@@ -32,19 +32,26 @@ std::string BP1::GetDirectoryName(const std::string name) const noexcept
 }
 
 void BP1::OpenRankFiles(const std::string name, const std::string accessMode,
-                        Transport &file) const
+                        Transport &file, const int fileIndex) const
 {
     const std::string directory = GetDirectoryName(name);
     CreateDirectory(
         directory); // creates a directory and sub-directories recursively
 
-    std::string fileName(directory + "/" + directory + "." +
-                         std::to_string(file.m_RankMPI));
+    std::string fileName(
+        directory + "/" + directory + "." +
+        std::to_string((fileIndex == -1) ? file.m_RankMPI : fileIndex));
     file.Open(fileName, accessMode); // opens a file transport under
                                      // name.bp.dir/name.bp.rank reserve that
                                      // location fro writing
 }
 
+std::string BP1::GetMetadataFileName(const std::string name) const noexcept
+{
+    const std::string directory = GetDirectoryName(name);
+    return directory + "/" + directory + ".idx";
+}
+
 std::vector<std::uint8_t> BP1::GetMethodIDs(
     const std::vector<std::shared_ptr<Transport>> &transports) const noexcept
 {
@@ -66,7 +73,7 @@ std::vector<std::uint8_t> BP1::GetMethodIDs(
         {
             id = METHOD_FILE;
         }
-        else if (method == "MPI")
+        else if (method == "MPI" || method == "MPI_File")
         {
             id = METHOD_MPI;
         }
@@ -9,7 +9,12 @@
  */
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <sys/shm.h>
+
+#include <algorithm> //std::min
+#include <cstring>   //std::memcpy
 #include <fstream>
+#include <limits> //std::numeric_limits
 #include <stdexcept>
 #include <vector>
 /// \endcond
@@ -104,5 +109,363 @@ void BP1Aggregator::WriteProfilingLog(const std::string fileName,
     }
 }
 
+std::vector<char>
+BP1Aggregator::GatherBuffers(const char *buffer, const std::size_t size,
+                             std::vector<std::size_t> &sizes,
+                             const bool subFile) const
+{
+    MPI_Comm comm = m_MPIComm;
+    int rank = m_RankMPI;
+    int commSize = m_SizeMPI;
+    if (subFile == true)
+    {
+        comm = m_SubFileComm;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &commSize);
+    }
+
+    std::uint64_t rankSize = size;
+    std::vector<std::uint64_t> rankSizes;
+    if (rank == 0)
+    {
+        rankSizes.resize(commSize);
+    }
+    MPI_Gather(&rankSize, 1, MPI_UNSIGNED_LONG_LONG, rankSizes.data(), 1,
+               MPI_UNSIGNED_LONG_LONG, 0, comm);
+
+    std::vector<char> buffers;
+    std::uint64_t totalSize = 0;
+    if (rank == 0)
+    {
+        sizes.assign(rankSizes.begin(), rankSizes.end());
+        for (const auto memberSize : rankSizes)
+        {
+            totalSize += memberSize;
+        }
+        buffers.resize(totalSize);
+    }
+    MPI_Bcast(&totalSize, 1, MPI_UNSIGNED_LONG_LONG, 0, comm);
+
+    // MPI_Gatherv counts and displacements are int
+    if (totalSize <=
+        static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+    {
+        std::vector<int> counts;
+        std::vector<int> displacements;
+        if (rank == 0)
+        {
+            counts.resize(commSize);
+            displacements.resize(commSize);
+            int displacement = 0;
+            for (int r = 0; r < commSize; ++r)
+            {
+                counts[r] = static_cast<int>(rankSizes[r]);
+                displacements[r] = displacement;
+                displacement += counts[r];
+            }
+        }
+
+        MPI_Gatherv(buffer, static_cast<int>(size), MPI_CHAR, buffers.data(),
+                    counts.data(), displacements.data(), MPI_CHAR, 0, comm);
+        return buffers;
+    }
+
+    // larger totals (e.g. footers from tens of thousands of ranks) are
+    // received point-to-point in pieces below the int count limit
+    const std::size_t maxPieceSize = 268435456;
+
+    if (rank != 0)
+    {
+        for (std::size_t position = 0; position < size;
+             position += maxPieceSize)
+        {
+            const int pieceSize =
+                static_cast<int>(std::min(maxPieceSize, size - position));
+            MPI_Send(&buffer[position], pieceSize, MPI_CHAR, 0, 0, comm);
+        }
+        return buffers;
+    }
+
+    std::memcpy(buffers.data(), buffer, size);
+    std::size_t position = size;
+    for (int r = 1; r < commSize; ++r)
+    {
+        const std::size_t end = position + rankSizes[r];
+        for (; position < end; position += maxPieceSize)
+        {
+            const int pieceSize =
+                static_cast<int>(std::min(maxPieceSize, end - position));
+            MPI_Status status;
+            MPI_Recv(&buffers[position], pieceSize, MPI_CHAR, r, 0, comm,
+                     &status);
+        }
+        position = end;
+    }
+    return buffers;
+}
+
+std::uint64_t BP1Aggregator::WriteSubFile(
+    const char *buffer, const std::size_t size,
+    const std::function<void(const char *, const std::size_t)> &write) const
+{
+    if (m_IsNodeAggregation == true)
+    {
+        std::uint64_t subFileSize = 0;
+        if (WriteNodeSubFile(buffer, size, write, subFileSize) == true)
+        {
+            return subFileSize;
+        }
+    }
+
+    if (m_IsSharedFile == true) // rank offsets are resolved by the transport
+    {
+        write(buffer, size);
+        std::uint64_t rankSize = size;
+        std::uint64_t subFileSize = 0;
+        MPI_Allreduce(&rankSize, &subFileSize, 1, MPI_UNSIGNED_LONG_LONG,
+                      MPI_SUM, m_SubFileComm);
+        return (m_IsAggregator == true) ? subFileSize : 0;
+    }
+
+    // point-to-point pieces below the int count limit, bounds aggregator
+    // memory to a single piece
+    const std::size_t maxPieceSize = 268435456;
+
+    int rank, groupSize;
+    MPI_Comm_rank(m_SubFileComm, &rank);
+    MPI_Comm_size(m_SubFileComm, &groupSize);
+
+    std::uint64_t rankSize = size;
+    std::vector<std::uint64_t> rankSizes(groupSize);
+    MPI_Gather(&rankSize, 1, MPI_UNSIGNED_LONG_LONG, rankSizes.data(), 1,
+               MPI_UNSIGNED_LONG_LONG, 0, m_SubFileComm);
+
+    if (rank != 0)
+    {
+        for (std::size_t position = 0; position < size;
+             position += maxPieceSize)
+        {
+            const int pieceSize =
+                static_cast<int>(std::min(maxPieceSize, size - position));
+            MPI_Send(&buffer[position], pieceSize, MPI_CHAR, 0, 0,
+                     m_SubFileComm);
+        }
+        return 0;
+    }
+
+    write(buffer, size); // aggregator data goes first
+    std::uint64_t subFileSize = size;
+
+    std::vector<char> piece;
+    for (int r = 1; r < groupSize; ++r)
+    {
+        const std::size_t memberSize = rankSizes[r];
+        piece.resize(std::min(maxPieceSize, memberSize));
+
+        for (std::size_t position = 0; position < memberSize;
+             position += maxPieceSize)
+        {
+            const int pieceSize =
+                static_cast<int>(std::min(maxPieceSize, memberSize - position));
+            MPI_Status status;
+            MPI_Recv(piece.data(), pieceSize, MPI_CHAR, r, 0, m_SubFileComm,
+                     &status);
+            write(piece.data(), pieceSize);
+        }
+        subFileSize += memberSize;
+    }
+    return subFileSize;
+}
+
+void BP1Aggregator::InitSubFiles(const unsigned int subFiles)
+{
+    if (m_DebugMode == true)
+    {
+        if (subFiles == 0)
+        {
+            throw std::invalid_argument(
+                "ERROR: number of subfiles must be at least 1, in ADIOS "
+                "aggregator\n");
+        }
+    }
+
+    const unsigned int sizeMPI = static_cast<unsigned int>(m_SizeMPI);
+    if (subFiles >= sizeMPI) // N-to-N
+    {
+        return;
+    }
+
+    m_SubFiles = subFiles;
+    m_SubFileIndex = GetSubFileIndex(m_RankMPI);
+    // first rank in group
+    m_IsAggregator =
+        (m_RankMPI == 0 || GetSubFileIndex(m_RankMPI - 1) != m_SubFileIndex);
+    MPI_Comm_split(m_MPIComm, static_cast<int>(m_SubFileIndex), m_RankMPI,
+                   &m_SubFileComm);
+}
+
+void BP1Aggregator::InitSharedFile()
+{
+    m_SubFiles = 1;
+    m_SubFileIndex = 0;
+    m_IsAggregator = (m_RankMPI == 0);
+    m_IsSharedFile = true;
+    MPI_Comm_dup(m_MPIComm, &m_SubFileComm);
+}
+
+void BP1Aggregator::FreeSubFileComm()
+{
+    if (m_SubFileComm != MPI_COMM_NULL)
+    {
+        MPI_Comm_free(&m_SubFileComm);
+        m_SubFileComm = MPI_COMM_NULL;
+    }
+}
+
+void BP1Aggregator::InitNodeSubFiles()
+{
+    MPI_Comm_split_type(m_MPIComm, MPI_COMM_TYPE_SHARED, m_RankMPI,
+                        MPI_INFO_NULL, &m_SubFileComm);
+    int nodeRank = 0;
+    MPI_Comm_rank(m_SubFileComm, &nodeRank);
+    m_IsAggregator = (nodeRank == 0); // lowest rank in node
+    m_IsNodeAggregation = true;
+
+    // subfile index is the number of aggregators in lower ranks
+    const int isAggregator = (m_IsAggregator == true) ? 1 : 0;
+    int subFileIndex = 0;
+    MPI_Exscan(&isAggregator, &subFileIndex, 1, MPI_INT, MPI_SUM, m_MPIComm);
+    if (m_RankMPI == 0) // undefined in first rank
+    {
+        subFileIndex = 0;
+    }
+    MPI_Bcast(&subFileIndex, 1, MPI_INT, 0, m_SubFileComm);
+    m_SubFileIndex = static_cast<unsigned int>(subFileIndex);
+
+    // rank 0 keeps all indices for the global metadata file
+    std::vector<int> subFileIndices;
+    if (m_RankMPI == 0)
+    {
+        subFileIndices.resize(m_SizeMPI);
+    }
+    MPI_Gather(&subFileIndex, 1, MPI_INT, subFileIndices.data(), 1, MPI_INT, 0,
+               m_MPIComm);
+
+    int subFiles = 0;
+    if (m_RankMPI == 0)
+    {
+        m_SubFileIndices.assign(subFileIndices.begin(), subFileIndices.end());
+        subFiles = subFileIndices.back() + 1;
+    }
+    MPI_Bcast(&subFiles, 1, MPI_INT, 0, m_MPIComm);
+    m_SubFiles = static_cast<unsigned int>(subFiles);
+}
+
+unsigned int BP1Aggregator::GetSubFileIndex(const int rank) const noexcept
+{
+    if (m_IsNodeAggregation == true)
+    {
+        return (rank == m_RankMPI) ? m_SubFileIndex : m_SubFileIndices[rank];
+    }
+
+    if (m_SubFiles == 0)
+    {
+        return static_cast<unsigned int>(rank);
+    }
+    return static_cast<unsigned int>(static_cast<std::uint64_t>(rank) *
+                                     m_SubFiles / m_SizeMPI);
+}
+
+std::uint64_t BP1Aggregator::GetSubFileOffset(const std::uint64_t size) const
+{
+    std::uint64_t offset = 0;
+    MPI_Exscan(&size, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+               m_SubFileComm);
+    if (m_IsAggregator == true) // undefined in first rank
+    {
+        offset = 0;
+    }
+    return offset;
+}
+
+// PRIVATE
+bool BP1Aggregator::WriteNodeSubFile(
+    const char *buffer, const std::size_t size,
+    const std::function<void(const char *, const std::size_t)> &write,
+    std::uint64_t &subFileSize) const
+{
+    int rank, groupSize;
+    MPI_Comm_rank(m_SubFileComm, &rank);
+    MPI_Comm_size(m_SubFileComm, &groupSize);
+
+    // members deposit their buffers after the aggregator buffer, which is
+    // written directly
+    const std::uint64_t rankSize = (rank == 0) ? 0 : size;
+    std::uint64_t offset = 0;
+    MPI_Exscan(&rankSize, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+               m_SubFileComm);
+    if (rank == 0) // undefined in first rank
+    {
+        offset = 0;
+    }
+
+    std::vector<std::uint64_t> rankSizes(groupSize);
+    MPI_Gather(&rankSize, 1, MPI_UNSIGNED_LONG_LONG, rankSizes.data(), 1,
+               MPI_UNSIGNED_LONG_LONG, 0, m_SubFileComm);
+
+    std::uint64_t segmentSize = 0;
+    int shmID = -1;
+    if (rank == 0)
+    {
+        for (const auto rankSize : rankSizes)
+        {
+            segmentSize += rankSize;
+        }
+        shmID = shmget(IPC_PRIVATE, std::max(segmentSize, std::uint64_t(1)),
+                       IPC_CREAT | 0600);
+    }
+    MPI_Bcast(&shmID, 1, MPI_INT, 0, m_SubFileComm);
+    if (shmID == -1) // e.g. above shmmax, caller falls back to MPI
+    {
+        return false;
+    }
+
+    // every rank must attach, otherwise all fall back to MPI together
+    char *segment = static_cast<char *>(shmat(shmID, nullptr, 0));
+    const bool isAttached = (segment != reinterpret_cast<char *>(-1));
+    const int failed = (isAttached == true) ? 0 : 1;
+    int failures = 0;
+    MPI_Allreduce(&failed, &failures, 1, MPI_INT, MPI_SUM, m_SubFileComm);
+    if (failures > 0)
+    {
+        if (isAttached == true)
+        {
+            shmdt(segment);
+        }
+        if (rank == 0)
+        {
+            shmctl(shmID, IPC_RMID, nullptr);
+        }
+        return false;
+    }
+
+    if (rank != 0)
+    {
+        std::memcpy(&segment[offset], buffer, size);
+    }
+    MPI_Barrier(m_SubFileComm); // all buffers deposited
+
+    subFileSize = 0;
+    if (rank == 0)
+    {
+        shmctl(shmID, IPC_RMID, nullptr); // released after last detach
+        write(buffer, size);
+        write(segment, segmentSize);
+        subFileSize = size + segmentSize;
+    }
+    shmdt(segment);
+    return true;
+}
+
 } // end namespace format
 } // end namespace adios
@@ -0,0 +1,954 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * BP1Reader.cpp
+ *
+ *  Created on: May 1, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::sort, std::unique, std::equal
+#include <stdexcept> //std::invalid_argument
+#include <string>    //std::char_traits
+/// \endcond
+
+#include "format/BP1Reader.h"
+#include "functions/adiosFunctions.h" //IsLittleEndian
+#include "functions/adiosTemplates.h" //CopyFromBuffer
+
+namespace adios
+{
+namespace format
+{
+
+namespace
+{
+const char indexCacheMagic[8] = {'A', 'D', 'I', 'O', 'S', 'B', 'P', 'C'};
+const std::uint32_t indexCacheVersion = 3;
+
+// block record flags in index cache
+const std::uint8_t blockIsValue = 1;
+const std::uint8_t blockIsTransformed = 2;
+const std::uint8_t blockIsGlobal = 4;
+const std::uint8_t blockHasMinMax = 8;
+const std::uint8_t blockHasBitmap = 16;
+
+/**
+ * Checks that an index cache record fits in the cache and that its blocks
+ * fit in the record, reading only lengths, counts and flags
+ * @param buffer whole index cache
+ * @param size of buffer
+ * @param position of the record length
+ * @param name output, record name in buffer
+ * @param nameLength output
+ * @return false: record is truncated or malformed
+ */
+bool IsValidCacheRecord(const char *buffer, const std::size_t size,
+                        std::size_t position, const char *&name,
+                        std::uint16_t &nameLength) noexcept
+{
+    if (position > size || size - position < 4)
+    {
+        return false;
+    }
+    std::uint32_t recordLength;
+    CopyFromBuffer(&recordLength, 1, buffer, position);
+    if (recordLength > size - position)
+    {
+        return false;
+    }
+    const std::size_t recordEnd = position + recordLength;
+
+    // name, member ID, data type and blocks count
+    if (recordEnd - position < 2)
+    {
+        return false;
+    }
+    CopyFromBuffer(&nameLength, 1, buffer, position);
+    if (recordEnd - position < std::size_t(nameLength) + 4 + 1 + 8)
+    {
+        return false;
+    }
+    name = &buffer[position];
+    position += nameLength + 4 + 1;
+    std::uint64_t blocksCount;
+    CopyFromBuffer(&blocksCount, 1, buffer, position);
+
+    // smallest block record: dimensions, flags, time and file indices,
+    // offsets, min and max
+    const std::size_t blockSize = 1 + 1 + 4 + 4 + 8 + 8 + 16 + 16;
+    if (blocksCount > (recordEnd - position) / blockSize)
+    {
+        return false;
+    }
+
+    for (std::uint64_t b = 0; b < blocksCount; ++b)
+    {
+        if (recordEnd - position < blockSize)
+        {
+            return false;
+        }
+        const std::uint8_t dimensions = buffer[position];
+        const std::uint8_t flags = buffer[position + 1];
+        position += blockSize;
+
+        const std::size_t dimensionsSize =
+            8 * std::size_t(dimensions) * ((flags & blockIsGlobal) ? 3 : 1);
+        if (recordEnd - position < dimensionsSize)
+        {
+            return false;
+        }
+        position += dimensionsSize;
+
+        if ((flags & blockHasBitmap) != 0)
+        {
+            if (recordEnd - position < 4)
+            {
+                return false;
+            }
+            std::uint32_t bitmapSize;
+            CopyFromBuffer(&bitmapSize, 1, buffer, position);
+            if (recordEnd - position < bitmapSize)
+            {
+                return false;
+            }
+            position += bitmapSize;
+        }
+    }
+    return true;
+}
+} // end empty namespace
+
+void BP1Reader::ParseMetadata(const char *buffer, const std::size_t size,
+                              BP1ReadMetadataSet &metadataSet) const
+{
+    metadataSet.Buffer = buffer;
+    metadataSet.Size = size;
+    metadataSet.IsIndexCache = false;
+
+    CheckBounds(metadataSet, 0, metadataSet.MiniFooterSize, "minifooter");
+    std::size_t position = size - metadataSet.MiniFooterSize;
+    CopyFromBuffer(&metadataSet.OffsetPGIndex, 1, buffer, position);
+    CopyFromBuffer(&metadataSet.OffsetVarsIndex, 1, buffer, position);
+    CopyFromBuffer(&metadataSet.OffsetAttributeIndex, 1, buffer, position);
+
+    std::uint8_t endian;
+    CopyFromBuffer(&endian, 1, buffer, position);
+    position += 2;
+    CopyFromBuffer(&metadataSet.Version, 1, buffer, position);
+
+    if (m_DebugMode == true)
+    {
+        if (endian != 0 || IsLittleEndian() == false)
+        {
+            throw std::invalid_argument(
+                "ERROR: only little endian BP files are supported, in call "
+                "to BP1Reader ParseMetadata\n");
+        }
+
+        if (metadataSet.OffsetPGIndex > metadataSet.OffsetVarsIndex ||
+            metadataSet.OffsetVarsIndex > metadataSet.OffsetAttributeIndex ||
+            metadataSet.OffsetAttributeIndex >
+                size - metadataSet.MiniFooterSize)
+        {
+            throw std::invalid_argument(
+                "ERROR: invalid index offsets in BP minifooter, in call to "
+                "BP1Reader ParseMetadata\n");
+        }
+    }
+
+    ParsePGIndex(metadataSet);
+    ParseVarsIndex(metadataSet);
+    ParseAttributesIndex(metadataSet);
+}
+
+void BP1Reader::ParseAllVarsIndices(BP1ReadMetadataSet &metadataSet) const
+{
+    for (const auto offset : metadataSet.VarsOffsets)
+    {
+        std::uint16_t length;
+        const char *name = GetEntryName(metadataSet, offset, length);
+        GetVarIndex(std::string(name, length), metadataSet);
+    }
+}
+
+std::vector<char>
+BP1Reader::GetIndexCache(const BP1ReadMetadataSet &metadataSet,
+                         const std::vector<BP1CacheSource> &sources) const
+{
+    std::vector<char> buffer;
+    CopyToBuffer(buffer, indexCacheMagic, 8);
+    CopyToBuffer(buffer, &indexCacheVersion);
+
+    const std::uint32_t sourcesCount = sources.size();
+    CopyToBuffer(buffer, &sourcesCount);
+    for (const auto &source : sources)
+    {
+        const std::uint8_t isMetadata = source.IsMetadata ? 1 : 0;
+        CopyToBuffer(buffer, &isMetadata);
+        CopyToBuffer(buffer, &source.FileIndex);
+        CopyToBuffer(buffer, &source.Size);
+        CopyToBuffer(buffer, &source.ModifiedSeconds);
+        CopyToBuffer(buffer, &source.ModifiedNanoseconds);
+    }
+
+    CopyToBuffer(buffer, &metadataSet.Version);
+    CopyToBuffer(buffer, &metadataSet.PGCount);
+    const std::uint64_t timeStepsCount = metadataSet.TimeSteps.size();
+    CopyToBuffer(buffer, &timeStepsCount);
+    CopyToBuffer(buffer, metadataSet.TimeSteps.data(), timeStepsCount);
+
+    std::vector<const std::pair<const std::string, BP1VarIndex> *> sorted;
+    sorted.reserve(metadataSet.VarsIndices.size());
+    for (const auto &varIndexPair : metadataSet.VarsIndices)
+    {
+        sorted.push_back(&varIndexPair);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<const std::string, BP1VarIndex> *a,
+                 const std::pair<const std::string, BP1VarIndex> *b) {
+                  return a->first < b->first;
+              });
+
+    // record offsets are filled after the records are written
+    const std::uint32_t varsCount = sorted.size();
+    CopyToBuffer(buffer, &varsCount);
+    const std::size_t offsetsPosition = buffer.size();
+    buffer.resize(buffer.size() + 8 * std::size_t(varsCount));
+
+    for (std::uint32_t v = 0; v < varsCount; ++v)
+    {
+        const std::uint64_t recordPosition = buffer.size();
+        CopyToBuffer(buffer, offsetsPosition + 8 * std::size_t(v),
+                     &recordPosition);
+
+        const std::string &name = sorted[v]->first;
+        const BP1VarIndex &varIndex = sorted[v]->second;
+        const std::uint32_t recordLength = 0;
+        CopyToBuffer(buffer, &recordLength);
+        const std::uint16_t nameLength = name.size();
+        CopyToBuffer(buffer, &nameLength);
+        CopyToBuffer(buffer, name.data(), nameLength);
+        CopyToBuffer(buffer, &varIndex.MemberID);
+        CopyToBuffer(buffer, &varIndex.DataType);
+        const std::uint64_t blocksCount = varIndex.Blocks.size();
+        CopyToBuffer(buffer, &blocksCount);
+
+        for (const auto &block : varIndex.Blocks)
+        {
+            const std::uint8_t dimensions = block.Count.size();
+            std::uint8_t flags = 0;
+            flags |= block.IsValue ? blockIsValue : 0;
+            flags |= block.IsTransformed ? blockIsTransformed : 0;
+            flags |= block.Shape.empty() ? 0 : blockIsGlobal;
+            flags |= block.HasMinMax ? blockHasMinMax : 0;
+            flags |= (block.Bitmap != nullptr) ? blockHasBitmap : 0;
+
+            CopyToBuffer(buffer, &dimensions);
+            CopyToBuffer(buffer, &flags);
+            CopyToBuffer(buffer, &block.TimeIndex);
+            CopyToBuffer(buffer, &block.FileIndex);
+            CopyToBuffer(buffer, &block.Offset);
+            CopyToBuffer(buffer, &block.PayloadOffset);
+            CopyToBuffer(buffer, block.Min, 16);
+            CopyToBuffer(buffer, block.Max, 16);
+            for (const auto count : block.Count)
+            {
+                const std::uint64_t value = count;
+                CopyToBuffer(buffer, &value);
+            }
+            if (block.Shape.empty() == false)
+            {
+                for (std::uint8_t d = 0; d < dimensions; ++d)
+                {
+                    const std::uint64_t values[2] = {block.Shape[d],
+                                                     block.Start[d]};
+                    CopyToBuffer(buffer, values, 2);
+                }
+            }
+            if (block.Bitmap != nullptr)
+            {
+                CopyToBuffer(buffer, &block.BitmapSize);
+                CopyToBuffer(buffer, block.Bitmap, block.BitmapSize);
+            }
+        }
+
+        const std::uint32_t length = buffer.size() - recordPosition - 4;
+        CopyToBuffer(buffer, recordPosition, &length);
+    }
+
+    return buffer;
+}
+
+bool BP1Reader::ParseIndexCache(const char *buffer, const std::size_t size,
+                                BP1ReadMetadataSet &metadataSet,
+                                std::vector<BP1CacheSource> &sources) const
+{
+    // checks don't depend on debug mode, an invalid cache is rebuilt
+    std::size_t position = 0;
+    if (size < 16 || std::equal(indexCacheMagic, indexCacheMagic + 8,
+                                buffer) == false)
+    {
+        return false;
+    }
+    position += 8;
+
+    std::uint32_t version, sourcesCount;
+    CopyFromBuffer(&version, 1, buffer, position);
+    CopyFromBuffer(&sourcesCount, 1, buffer, position);
+    const std::size_t sourceSize = 1 + 4 + 8 + 8 + 8;
+    if (version != indexCacheVersion ||
+        sourcesCount > (size - position) / sourceSize)
+    {
+        return false;
+    }
+
+    sources.resize(sourcesCount);
+    for (auto &source : sources)
+    {
+        std::uint8_t isMetadata;
+        CopyFromBuffer(&isMetadata, 1, buffer, position);
+        source.IsMetadata = (isMetadata == 1);
+        CopyFromBuffer(&source.FileIndex, 1, buffer, position);
+        CopyFromBuffer(&source.Size, 1, buffer, position);
+        CopyFromBuffer(&source.ModifiedSeconds, 1, buffer, position);
+        CopyFromBuffer(&source.ModifiedNanoseconds, 1, buffer, position);
+    }
+
+    if (size - position < 1 + 8 + 8)
+    {
+        return false;
+    }
+    CopyFromBuffer(&metadataSet.Version, 1, buffer, position);
+    CopyFromBuffer(&metadataSet.PGCount, 1, buffer, position);
+    std::uint64_t timeStepsCount;
+    CopyFromBuffer(&timeStepsCount, 1, buffer, position);
+    if (timeStepsCount > (size - position) / 4)
+    {
+        return false;
+    }
+    metadataSet.TimeSteps.resize(timeStepsCount);
+    CopyFromBuffer(metadataSet.TimeSteps.data(), timeStepsCount, buffer,
+                   position);
+
+    std::uint32_t varsCount = 0;
+    if (size - position >= 4)
+    {
+        CopyFromBuffer(&varsCount, 1, buffer, position);
+    }
+    if (size - position < 8 * std::size_t(varsCount))
+    {
+        return false;
+    }
+    metadataSet.VarsOffsets.resize(varsCount);
+    CopyFromBuffer(metadataSet.VarsOffsets.data(), varsCount, buffer,
+                   position);
+
+    // records are validated once here and decoded without checks, names
+    // must be strictly increasing for the binary search in GetVarIndex
+    const char *previousName = nullptr;
+    std::uint16_t previousLength = 0;
+    for (const auto offset : metadataSet.VarsOffsets)
+    {
+        const char *name;
+        std::uint16_t nameLength;
+        if (offset > size ||
+            IsValidCacheRecord(buffer, size, offset, name, nameLength) ==
+                false)
+        {
+            return false;
+        }
+
+        if (previousName != nullptr)
+        {
+            const int compare = std::char_traits<char>::compare(
+                previousName, name, std::min(previousLength, nameLength));
+            if (compare > 0 || (compare == 0 && previousLength >= nameLength))
+            {
+                return false;
+            }
+        }
+        previousName = name;
+        previousLength = nameLength;
+    }
+
+    metadataSet.Buffer = buffer;
+    metadataSet.Size = size;
+    metadataSet.IsIndexCache = true;
+    metadataSet.VarsIndices.clear();
+    metadataSet.AttributesOffsets.clear();
+    metadataSet.AttributesIndices.clear();
+    return true;
+}
+
+const BP1VarIndex *
+BP1Reader::GetVarIndex(const std::string &name,
+                       BP1ReadMetadataSet &metadataSet) const
+{
+    auto itVarIndex = metadataSet.VarsIndices.find(name);
+    if (itVarIndex != metadataSet.VarsIndices.end())
+    {
+        return &itVarIndex->second;
+    }
+
+    // binary search in the name sorted entries, names are compared in place
+    auto lf_Less = [&](const std::uint64_t offset, const std::string &key) {
+        std::uint16_t length;
+        const char *entryName = GetEntryName(metadataSet, offset, length);
+        return key.compare(0, key.size(), entryName, length) > 0;
+    };
+
+    const auto &offsets = metadataSet.VarsOffsets;
+    auto itOffset =
+        std::lower_bound(offsets.begin(), offsets.end(), name, lf_Less);
+    if (itOffset == offsets.end())
+    {
+        return nullptr;
+    }
+
+    std::uint16_t length;
+    const char *entryName = GetEntryName(metadataSet, *itOffset, length);
+    if (name.compare(0, name.size(), entryName, length) != 0)
+    {
+        return nullptr;
+    }
+
+    BP1VarIndex varIndex;
+    ParseIndexEntry(metadataSet, *itOffset, varIndex);
+    return &metadataSet.VarsIndices.emplace(name, std::move(varIndex))
+                .first->second;
+}
+
+const BP1VarIndex *
+BP1Reader::GetAttributeIndex(const std::string &name,
+                             BP1ReadMetadataSet &metadataSet) const
+{
+    auto itAttributeIndex = metadataSet.AttributesIndices.find(name);
+    if (itAttributeIndex != metadataSet.AttributesIndices.end())
+    {
+        return &itAttributeIndex->second;
+    }
+
+    auto itOffset = metadataSet.AttributesOffsets.find(name);
+    if (itOffset == metadataSet.AttributesOffsets.end())
+    {
+        return nullptr;
+    }
+
+    BP1VarIndex attributeIndex;
+    ParseIndexEntry(metadataSet, itOffset->second, attributeIndex);
+    return &metadataSet.AttributesIndices
+                .emplace(name, std::move(attributeIndex))
+                .first->second;
+}
+
+std::vector<const BP1Block *>
+BP1Reader::GetStepBlocks(const BP1VarIndex &varIndex,
+                         const std::uint32_t timeStep) const noexcept
+{
+    std::vector<const BP1Block *> blocks;
+    for (const auto &block : varIndex.Blocks)
+    {
+        if (block.TimeIndex == timeStep)
+        {
+            blocks.push_back(&block);
+        }
+    }
+    return blocks;
+}
+
+// PRIVATE
+void BP1Reader::ParsePGIndex(BP1ReadMetadataSet &metadataSet) const
+{
+    const char *buffer = metadataSet.Buffer;
+    std::size_t position = metadataSet.OffsetPGIndex;
+
+    CheckBounds(metadataSet, position, 16, "PG index");
+    std::uint64_t pgLength;
+    CopyFromBuffer(&metadataSet.PGCount, 1, buffer, position);
+    CopyFromBuffer(&pgLength, 1, buffer, position);
+    CheckBounds(metadataSet, position, pgLength, "PG index");
+
+    const std::size_t end = position + pgLength;
+    auto &timeSteps = metadataSet.TimeSteps;
+    timeSteps.clear();
+
+    while (position < end)
+    {
+        std::uint16_t entryLength;
+        CopyFromBuffer(&entryLength, 1, buffer, position);
+        const std::size_t entryEnd = position + entryLength;
+
+        // name, fortran flag, process ID, time step name, then time step
+        std::uint16_t length;
+        CopyFromBuffer(&length, 1, buffer, position);
+        position += length + 1 + 4;
+        CopyFromBuffer(&length, 1, buffer, position);
+        position += length;
+
+        std::uint32_t timeStep;
+        CopyFromBuffer(&timeStep, 1, buffer, position);
+        timeSteps.push_back(timeStep);
+
+        position = entryEnd;
+    }
+
+    std::sort(timeSteps.begin(), timeSteps.end());
+    timeSteps.erase(std::unique(timeSteps.begin(), timeSteps.end()),
+                    timeSteps.end());
+}
+
+void BP1Reader::ParseVarsIndex(BP1ReadMetadataSet &metadataSet) const
+{
+    const char *buffer = metadataSet.Buffer;
+    std::size_t position = metadataSet.OffsetVarsIndex;
+
+    CheckBounds(metadataSet, position, 12, "variable index");
+    std::uint32_t count;
+    std::uint64_t length;
+    CopyFromBuffer(&count, 1, buffer, position);
+    CopyFromBuffer(&length, 1, buffer, position);
+    CheckBounds(metadataSet, position, length, "variable index");
+    const std::size_t begin = position;
+    const std::size_t end = position + length;
+
+    auto &offsets = metadataSet.VarsOffsets;
+    metadataSet.VarsIndices.clear();
+    offsets.clear();
+
+    // name table: [count 4][length 8][count x offset 8] after the attribute
+    // index, right before the minifooter
+    std::size_t namesPosition = metadataSet.OffsetAttributeIndex;
+    if (namesPosition + 12 <= metadataSet.Size)
+    {
+        std::uint64_t attributesLength;
+        namesPosition += 4;
+        CopyFromBuffer(&attributesLength, 1, buffer, namesPosition);
+        namesPosition += attributesLength;
+    }
+
+    std::uint32_t namesCount = 0;
+    std::uint64_t namesLength = 0;
+    const std::size_t namesEnd = metadataSet.Size - metadataSet.MiniFooterSize;
+    if (namesPosition + 12 <= namesEnd)
+    {
+        CopyFromBuffer(&namesCount, 1, buffer, namesPosition);
+        CopyFromBuffer(&namesLength, 1, buffer, namesPosition);
+    }
+
+    if (namesCount == count && namesLength == 8 * std::uint64_t(count) &&
+        namesPosition + namesLength == namesEnd)
+    {
+        offsets.resize(count);
+        CopyFromBuffer(offsets.data(), count, buffer, namesPosition);
+
+        bool isValid = true;
+        for (const auto offset : offsets)
+        {
+            if (offset < begin || offset + 4 > end)
+            {
+                isValid = false;
+                break;
+            }
+        }
+        if (isValid == true)
+        {
+            return;
+        }
+        offsets.clear();
+    }
+
+    // no name table (e.g. older files): locate the entries and sort them,
+    // characteristics are still not decoded
+    offsets.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        CheckBounds(metadataSet, position, 4, "variable index entry");
+        offsets.push_back(position);
+        std::uint32_t entryLength;
+        CopyFromBuffer(&entryLength, 1, buffer, position);
+        position += entryLength;
+    }
+
+    std::sort(offsets.begin(), offsets.end(),
+              [&](const std::uint64_t a, const std::uint64_t b) {
+                  std::uint16_t lengthA, lengthB;
+                  const char *nameA = GetEntryName(metadataSet, a, lengthA);
+                  const char *nameB = GetEntryName(metadataSet, b, lengthB);
+                  return std::string(nameA, lengthA).compare(
+                             0, std::string::npos, nameB, lengthB) < 0;
+              });
+}
+
+void BP1Reader::ParseAttributesIndex(BP1ReadMetadataSet &metadataSet) const
+{
+    const char *buffer = metadataSet.Buffer;
+    std::size_t position = metadataSet.OffsetAttributeIndex;
+
+    CheckBounds(metadataSet, position, 12, "attribute index");
+    std::uint32_t count;
+    std::uint64_t length;
+    CopyFromBuffer(&count, 1, buffer, position);
+    CopyFromBuffer(&length, 1, buffer, position);
+    CheckBounds(metadataSet, position, length, "attribute index");
+
+    metadataSet.AttributesIndices.clear();
+    metadataSet.AttributesOffsets.clear();
+    metadataSet.AttributesOffsets.reserve(count);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::uint16_t nameLength;
+        const char *name = GetEntryName(metadataSet, position, nameLength);
+        metadataSet.AttributesOffsets.emplace(std::string(name, nameLength),
+                                              position);
+
+        std::uint32_t entryLength;
+        CopyFromBuffer(&entryLength, 1, buffer, position);
+        position += entryLength;
+    }
+}
+
+const char *BP1Reader::GetEntryName(const BP1ReadMetadataSet &metadataSet,
+                                    const std::size_t position,
+                                    std::uint16_t &length) const
+{
+    const char *buffer = metadataSet.Buffer;
+    if (metadataSet.IsIndexCache == true) // record length, then name
+    {
+        std::size_t namePosition = position + 4;
+        CheckBounds(metadataSet, namePosition, 2, "index cache name");
+        CopyFromBuffer(&length, 1, buffer, namePosition);
+        CheckBounds(metadataSet, namePosition, length, "index cache name");
+        return buffer + namePosition;
+    }
+
+    // entry length, member ID, then group
+    std::size_t namePosition = position + 4 + 4;
+    CheckBounds(metadataSet, namePosition, 2, "index entry group");
+    CopyFromBuffer(&length, 1, buffer, namePosition);
+    namePosition += length;
+
+    CheckBounds(metadataSet, namePosition, 2, "index entry name");
+    CopyFromBuffer(&length, 1, buffer, namePosition);
+    CheckBounds(metadataSet, namePosition, length, "index entry name");
+    return buffer + namePosition;
+}
+
+void BP1Reader::ParseCacheEntry(const BP1ReadMetadataSet &metadataSet,
+                                std::size_t position, BP1VarIndex &index) const
+{
+    // the record was validated by ParseIndexCache
+    const char *buffer = metadataSet.Buffer;
+    position += 4; // record length
+
+    std::uint16_t nameLength;
+    CopyFromBuffer(&nameLength, 1, buffer, position);
+    position += nameLength;
+    CopyFromBuffer(&index.MemberID, 1, buffer, position);
+    CopyFromBuffer(&index.DataType, 1, buffer, position);
+
+    std::uint64_t blocksCount;
+    CopyFromBuffer(&blocksCount, 1, buffer, position);
+    index.Blocks.resize(blocksCount);
+
+    for (auto &block : index.Blocks)
+    {
+        std::uint8_t dimensions, flags;
+        CopyFromBuffer(&dimensions, 1, buffer, position);
+        CopyFromBuffer(&flags, 1, buffer, position);
+        CopyFromBuffer(&block.TimeIndex, 1, buffer, position);
+        CopyFromBuffer(&block.FileIndex, 1, buffer, position);
+        CopyFromBuffer(&block.Offset, 1, buffer, position);
+        CopyFromBuffer(&block.PayloadOffset, 1, buffer, position);
+        CopyFromBuffer(block.Min, 16, buffer, position);
+        CopyFromBuffer(block.Max, 16, buffer, position);
+        block.IsValue = (flags & blockIsValue) != 0;
+        block.IsTransformed = (flags & blockIsTransformed) != 0;
+        block.HasMinMax = (flags & blockHasMinMax) != 0;
+
+        const bool isGlobal = (flags & blockIsGlobal) != 0;
+        block.Count.resize(dimensions);
+        for (auto &count : block.Count)
+        {
+            std::uint64_t value;
+            CopyFromBuffer(&value, 1, buffer, position);
+            count = value;
+        }
+        if (isGlobal == true)
+        {
+            block.Shape.resize(dimensions);
+            block.Start.resize(dimensions);
+            for (std::uint8_t d = 0; d < dimensions; ++d)
+            {
+                std::uint64_t values[2];
+                CopyFromBuffer(values, 2, buffer, position);
+                block.Shape[d] = values[0];
+                block.Start[d] = values[1];
+            }
+        }
+        if ((flags & blockHasBitmap) != 0)
+        {
+            CopyFromBuffer(&block.BitmapSize, 1, buffer, position);
+            block.Bitmap = &buffer[position];
+            position += block.BitmapSize;
+        }
+    }
+}
+
+void BP1Reader::ParseIndexEntry(const BP1ReadMetadataSet &metadataSet,
+                                std::size_t position, BP1VarIndex &index) const
+{
+    if (metadataSet.IsIndexCache == true)
+    {
+        ParseCacheEntry(metadataSet, position, index);
+        return;
+    }
+
+    const char *buffer = metadataSet.Buffer;
+
+    CheckBounds(metadataSet, position, 4, "index entry");
+    std::uint32_t entryLength;
+    CopyFromBuffer(&entryLength, 1, buffer, position);
+    CheckBounds(metadataSet, position, entryLength, "index entry");
+    const std::size_t entryEnd = position + entryLength;
+
+    CopyFromBuffer(&index.MemberID, 1, buffer, position);
+
+    std::uint16_t length;
+    CopyFromBuffer(&length, 1, buffer, position); // group
+    position += length;
+    CopyFromBuffer(&length, 1, buffer, position);
+    const std::string name(buffer + position, length);
+    position += length;
+    CopyFromBuffer(&length, 1, buffer, position); // path
+    position += length;
+    CopyFromBuffer(&index.DataType, 1, buffer, position);
+
+    std::uint64_t setsCount;
+    CopyFromBuffer(&setsCount, 1, buffer, position);
+    if (m_DebugMode == true)
+    {
+        // each set has at least its count and length
+        if (setsCount > (entryEnd - position) / 5)
+        {
+            throw std::invalid_argument(
+                "ERROR: characteristics sets count of " + name +
+                " exceeds its index entry, in call to BP1Reader "
+                "ParseIndexEntry\n");
+        }
+    }
+    index.Blocks.resize(setsCount);
+
+    for (auto &block : index.Blocks)
+    {
+        ParseCharacteristics(buffer, position, index.DataType, block);
+        if (m_DebugMode == true)
+        {
+            if (position > entryEnd)
+            {
+                throw std::invalid_argument(
+                    "ERROR: characteristics of " + name +
+                    " exceed its index entry, in call to BP1Reader "
+                    "ParseIndexEntry\n");
+            }
+        }
+    }
+}
+
+void BP1Reader::ParseCharacteristics(const char *buffer, std::size_t &position,
+                                     const std::uint8_t dataType,
+                                     BP1Block &block) const
+{
+    std::uint8_t count;
+    std::uint32_t length;
+    CopyFromBuffer(&count, 1, buffer, position);
+    CopyFromBuffer(&length, 1, buffer, position);
+    const std::size_t end = position + length;
+
+    const std::size_t valueSize = GetValueSize(dataType);
+    bool hasMin = false;
+    bool hasMax = false;
+
+    for (std::uint8_t c = 0; c < count && position < end; ++c)
+    {
+        std::uint8_t id;
+        CopyFromBuffer(&id, 1, buffer, position);
+
+        // value records of unknown types can't be skipped, the block is left
+        // without time index and can't be read
+        if (valueSize == 0 && id <= characteristic_max)
+        {
+            position = end;
+            break;
+        }
+
+        switch (id)
+        {
+        case characteristic_value:
+            CopyFromBuffer(block.Min, valueSize, buffer, position);
+            std::copy(block.Min, block.Min + valueSize, block.Max);
+            block.IsValue = true;
+            break;
+
+        case characteristic_min:
+            CopyFromBuffer(block.Min, valueSize, buffer, position);
+            hasMin = true;
+            break;
+
+        case characteristic_max:
+            CopyFromBuffer(block.Max, valueSize, buffer, position);
+            hasMax = true;
+            break;
+
+        case characteristic_bitmap:
+            CopyFromBuffer(&block.BitmapSize, 1, buffer, position);
+            block.Bitmap = &buffer[position];
+            position += block.BitmapSize;
+            break;
+
+        case characteristic_offset:
+            CopyFromBuffer(&block.Offset, 1, buffer, position);
+            break;
+
+        case characteristic_payload_offset:
+            CopyFromBuffer(&block.PayloadOffset, 1, buffer, position);
+            break;
+
+        case characteristic_file_index:
+            CopyFromBuffer(&block.FileIndex, 1, buffer, position);
+            break;
+
+        case characteristic_time_index:
+            CopyFromBuffer(&block.TimeIndex, 1, buffer, position);
+            break;
+
+        case characteristic_dimensions:
+        {
+            std::uint8_t dimensions;
+            std::uint16_t dimensionsLength;
+            CopyFromBuffer(&dimensions, 1, buffer, position);
+            CopyFromBuffer(&dimensionsLength, 1, buffer, position);
+
+            // local, global, global offset for each dimension, global
+            // dimensions are zero for local variables
+            block.Count.resize(dimensions);
+            block.Shape.resize(dimensions);
+            block.Start.resize(dimensions);
+            bool isGlobal = false;
+            for (std::uint8_t d = 0; d < dimensions; ++d)
+            {
+                std::uint64_t values[3];
+                CopyFromBuffer(values, 3, buffer, position);
+                block.Count[d] = values[0];
+                block.Shape[d] = values[1];
+                block.Start[d] = values[2];
+                if (values[1] != 0)
+                {
+                    isGlobal = true;
+                }
+            }
+            if (isGlobal == false)
+            {
+                block.Shape.clear();
+                block.Start.clear();
+            }
+            break;
+        }
+
+        case characteristic_stat:
+        {
+            std::uint8_t statsCount;
+            CopyFromBuffer(&statsCount, 1, buffer, position);
+            for (std::uint8_t s = 0; s < statsCount; ++s)
+            {
+                std::uint8_t statisticID;
+                CopyFromBuffer(&statisticID, 1, buffer, position);
+                if (statisticID == statistic_hist)
+                {
+                    std::uint16_t bins;
+                    CopyFromBuffer(&bins, 1, buffer, position);
+                    position += 8 * bins;
+                }
+                else if (statisticID == statistic_finite)
+                {
+                    position += 1;
+                }
+                else if (statisticID == statistic_min ||
+                         statisticID == statistic_max)
+                {
+                    position += valueSize;
+                }
+                else // cnt, sum, sum_square
+                {
+                    position += 8;
+                }
+            }
+            break;
+        }
+
+        default:
+            // records have no length in metadata, the rest of the set can't
+            // be decoded
+            if (id == characteristic_transform_type)
+            {
+                block.IsTransformed = true;
+            }
+            position = end;
+            break;
+        }
+    }
+
+    block.HasMinMax = block.IsValue || (hasMin && hasMax);
+    position = end;
+}
+
+std::size_t BP1Reader::GetValueSize(const std::uint8_t dataType) const noexcept
+{
+    switch (dataType)
+    {
+    case type_byte:
+    case type_unsigned_byte:
+        return 1;
+    case type_short:
+    case type_unsigned_short:
+        return 2;
+    case type_integer:
+    case type_unsigned_integer:
+    case type_real:
+    case type_complex:
+        return 4;
+    case type_long:
+    case type_unsigned_long:
+    case type_double:
+    case type_double_complex:
+        return 8;
+    case type_long_double:
+    case type_long_double_complex:
+        return sizeof(long double);
+    default:
+        return 0;
+    }
+}
+
+void BP1Reader::CheckBounds(const BP1ReadMetadataSet &metadataSet,
+                            const std::size_t position, const std::size_t size,
+                            const std::string hint) const
+{
+    if (m_DebugMode == true)
+    {
+        if (position > metadataSet.Size || size > metadataSet.Size - position)
+        {
+            throw std::invalid_argument("ERROR: " + hint +
+                                        " is beyond the metadata buffer of "
+                                        "size " +
+                                        std::to_string(metadataSet.Size) +
+                                        ", in BP1Reader\n");
+        }
+    }
+}
+
+} // end namespace format
+} // end namespace adios
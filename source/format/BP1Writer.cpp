@@ -9,6 +9,7 @@
  */
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::sort
 #include <string>
 #include <vector>
 /// \endcond
@@ -35,77 +36,86 @@ std::size_t BP1Writer::GetProcessGroupIndexSize(
 void BP1Writer::WriteProcessGroupIndex(
     const bool isFortran, const std::string name, const std::uint32_t processID,
     const std::vector<std::shared_ptr<Transport>> &transports,
-    capsule::STLVector &heap, BP1MetadataSet &metadataSet) const noexcept
+    capsule::STLVector &heap, BP1MetadataSet &metadataSet) const
 {
-    std::vector<char> &metadataBuffer = metadataSet.PGIndex.Buffer;
-    std::vector<char> &dataBuffer = heap.m_Data;
-
-    metadataSet.DataPGLengthPosition = dataBuffer.size();
-    dataBuffer.insert(dataBuffer.end(), 8, 0); // skip pg length (8)
+    const std::string timeStepName(std::to_string(metadataSet.TimeStep));
+    const std::vector<std::uint8_t> methodIDs = GetMethodIDs(transports);
 
-    const std::size_t metadataPGLengthPosition = metadataBuffer.size();
-    metadataBuffer.insert(metadataBuffer.end(), 2, 0); // skip pg length (2)
+    // pg length + name + fortran + processID + time step name + time step +
+    // offset
+    Serializer metadata(metadataSet.PGIndex.Buffer,
+                        2 + (2 + name.size()) + 1 + 4 +
+                            (2 + timeStepName.size()) + 4 + 8,
+                        m_DebugMode);
+    // pg length + fortran + name + coordination + time step name + time
+    // step + methods + vars count and length
+    Serializer data(heap.m_Data, 8 + 1 + (2 + name.size()) + 4 +
+                                     (2 + timeStepName.size()) + 4 +
+                                     (3 + 3 * methodIDs.size()) + 12,
+                    m_DebugMode);
+
+    metadataSet.DataPGLengthPosition = data.Position();
+    data.Skip(8); // skip pg length (8)
+
+    const std::size_t metadataPGLengthPosition = metadata.Position();
+    metadata.Skip(2); // skip pg length (2)
 
     // write name to metadata
-    WriteNameRecord(name, metadataBuffer);
+    WriteNameRecord(name, metadata);
     // write if host language Fortran in metadata and data
     const char hostFortran =
         (isFortran) ? 'y' : 'n'; // if host language is fortran
-    CopyToBuffer(metadataBuffer, &hostFortran);
-    CopyToBuffer(dataBuffer, &hostFortran);
+    metadata.Write(&hostFortran);
+    data.Write(&hostFortran);
     // write name in data
-    WriteNameRecord(name, dataBuffer);
+    WriteNameRecord(name, data);
 
     // processID in metadata,
-    CopyToBuffer(metadataBuffer, &processID);
+    metadata.Write(&processID);
     // skip coordination var in data ....what is coordination var?
-    dataBuffer.insert(dataBuffer.end(), 4, 0);
+    data.Skip(4);
 
     // time step name to metadata and data
-    const std::string timeStepName(std::to_string(metadataSet.TimeStep));
-    WriteNameRecord(timeStepName, metadataBuffer);
-    WriteNameRecord(timeStepName, dataBuffer);
+    WriteNameRecord(timeStepName, metadata);
+    WriteNameRecord(timeStepName, data);
 
     // time step to metadata and data
-    CopyToBuffer(metadataBuffer, &metadataSet.TimeStep);
-    CopyToBuffer(dataBuffer, &metadataSet.TimeStep);
+    metadata.Write(&metadataSet.TimeStep);
+    data.Write(&metadataSet.TimeStep);
 
     // offset to pg in data in metadata which is the current absolute position
-    CopyToBuffer(metadataBuffer,
-                 reinterpret_cast<uint64_t *>(&heap.m_DataAbsolutePosition));
+    metadataSet.PGIndex.OffsetPositions.push_back(metadata.Position());
+    metadata.Write(reinterpret_cast<uint64_t *>(&heap.m_DataAbsolutePosition));
 
     // Back to writing metadata pg index length (length of group)
     const std::uint16_t metadataPGIndexLength =
-        metadataBuffer.size() - metadataPGLengthPosition -
+        metadata.Position() - metadataPGLengthPosition -
         2; // without length of group record
-    CopyToBuffer(metadataBuffer, metadataPGLengthPosition,
-                 &metadataPGIndexLength);
+    metadata.WriteAt(metadataPGLengthPosition, &metadataPGIndexLength);
     // DONE With metadataBuffer
 
     // here write method in data
-    const std::vector<std::uint8_t> methodIDs = GetMethodIDs(transports);
     const std::uint8_t methodsCount = methodIDs.size();
-    CopyToBuffer(dataBuffer, &methodsCount); // count
+    data.Write(&methodsCount); // count
     const std::uint16_t methodsLength =
         methodIDs.size() *
         3; // methodID (1) + method params length(2), no parameters for now
-    CopyToBuffer(dataBuffer, &methodsLength); // length
+    data.Write(&methodsLength); // length
 
     for (const auto methodID : methodIDs)
     {
-        CopyToBuffer(dataBuffer, &methodID); // method ID,
-        dataBuffer.insert(dataBuffer.end(), 2,
-                          0); // skip method params length = 0 (2 bytes) for now
+        data.Write(&methodID); // method ID,
+        data.Skip(2); // skip method params length = 0 (2 bytes) for now
     }
 
     // update absolute position
     heap.m_DataAbsolutePosition +=
-        dataBuffer.size() - metadataSet.DataPGLengthPosition;
+        data.Position() - metadataSet.DataPGLengthPosition;
     // pg vars count and position
     metadataSet.DataPGVarsCount = 0;
-    metadataSet.DataPGVarsCountPosition = dataBuffer.size();
+    metadataSet.DataPGVarsCountPosition = data.Position();
     // add vars count and length
-    dataBuffer.insert(dataBuffer.end(), 12, 0);
+    data.Skip(12);
     heap.m_DataAbsolutePosition += 12; // add vars count and length
 
     ++metadataSet.DataPGCount;
@@ -114,12 +124,56 @@ void BP1Writer::WriteProcessGroupIndex(
 
 void BP1Writer::Advance(BP1MetadataSet &metadataSet, capsule::STLVector &buffer)
 {
-    FlattenData(metadataSet, buffer);
+    if (metadataSet.DataPGIsOpen == true)
+    {
+        FlattenData(metadataSet, buffer);
+    }
+    else // process group already closed by a Flush
+    {
+        ++metadataSet.TimeStep;
+    }
+}
+
+void BP1Writer::Flush(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
+                      const std::vector<std::shared_ptr<Transport>> &transports,
+                      const char *payload, const std::size_t payloadSize) const
+{
+    auto &buffer = heap.m_Data;
+
+    if (metadataSet.DataPGIsOpen == true)
+    {
+        CloseProcessGroup(metadataSet, heap, payloadSize);
+        if (payload == nullptr)
+        {
+            Serializer serializer(buffer, 12, m_DebugMode);
+            serializer.Skip(12); // empty attributes
+            heap.m_DataAbsolutePosition += 12;
+        }
+    }
+
+    for (auto &transport : transports)
+    {
+        WriteHeap(heap, *transport);
+    }
+
+    if (payload != nullptr) // payload and empty attributes after the buffer
+    {
+        const char attributes[12] = {};
+        for (auto &transport : transports)
+        {
+            transport->Write(payload, payloadSize);
+            transport->Write(attributes, 12);
+        }
+        heap.m_DataAbsolutePosition += payloadSize + 12;
+    }
+
+    buffer.clear(); // keeps capacity
+    heap.m_Extents.clear();
+    heap.m_DataPosition = 0;
 }
 
 void BP1Writer::Close(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
-                      Transport &transport, bool &isFirstClose,
-                      const bool doAggregation) const noexcept
+                      Transport &transport, bool &isFirstClose) const
 {
     if (metadataSet.Log.m_IsActive == true)
     {
@@ -139,25 +193,66 @@ void BP1Writer::Close(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
         {
             metadataSet.Log.m_Timers[0].SetInitialTime();
         }
-
-        if (doAggregation ==
-            true) // N-to-M  where 1 <= M <= N-1, might need a new
-                  // Log metadataSet.Log.m_Timers just for
-                  // aggregation
-        {
-            // here call aggregator
-        }
         isFirstClose = false;
     }
 
-    if (doAggregation == true) // N-to-M  where 1 <= M <= N-1
+    WriteHeap(heap, transport); // single write
+    transport.Close();
+}
+
+void BP1Writer::Close(BP1MetadataSet &metadataSet, capsule::STLVector &heap,
+                      const std::vector<std::shared_ptr<Transport>> &transports,
+                      BP1Aggregator &aggregator) const
+{
+    if (metadataSet.Log.m_IsActive == true)
+    {
+        metadataSet.Log.m_Timers[0].SetInitialTime();
+    }
+
+    if (metadataSet.DataPGIsOpen == true)
+    {
+        FlattenData(metadataSet, heap);
+    }
+
+    // data is not flushed with aggregation, offsets start at zero in buffer
+    const std::size_t dataSize = heap.m_Data.size();
+    const std::uint64_t subFileOffset = aggregator.GetSubFileOffset(dataSize);
+    ShiftOffsets(metadataSet, subFileOffset);
+    heap.m_DataAbsolutePosition += subFileOffset;
+    FlattenMetadata(metadataSet, heap);
+
+    // rank metadata is merged into the subfile metadata in the aggregator
+    std::vector<std::size_t> rankSizes;
+    const std::vector<char> rankMetadata = aggregator.GatherBuffers(
+        heap.m_Data.data() + dataSize, heap.m_Data.size() - dataSize,
+        rankSizes, true);
+
+    const std::uint64_t subFileSize = aggregator.WriteSubFile(
+        heap.m_Data.data(), dataSize,
+        [&transports](const char *buffer, const std::size_t size) {
+            for (auto &transport : transports)
+            {
+                transport->Write(buffer, size);
+            }
+        });
+
+    heap.m_Data.clear();
+    heap.m_DataAbsolutePosition = subFileSize;
+    metadataSet.MetadataPosition = 0;
+
+    if (aggregator.m_IsAggregator == true)
     {
-        // here call aggregator to select transports for Write and Close
+        AggregateMetadata(rankMetadata, rankSizes, {}, heap);
     }
-    else // N-to-N
+
+    // a shared file is written and closed collectively, other ranks are empty
+    if (aggregator.m_IsAggregator == true || aggregator.m_IsSharedFile == true)
     {
-        transport.Write(heap.m_Data.data(), heap.m_Data.size()); // single write
-        transport.Close();
+        for (auto &transport : transports)
+        {
+            transport->Write(heap.m_Data.data(), heap.m_Data.size());
+            transport->Close();
+        }
     }
 }
 
@@ -183,6 +278,9 @@ std::string BP1Writer::GetRankProfilingLog(
 
         rankLog += "'transport_" + std::to_string(t) + "': { ";
         rankLog += "'lib': " + transports[t]->m_Type + ", ";
+        rankLog += "'bytes': " +
+                   std::to_string(transports[t]->m_Profiler.m_TotalBytes[0]) +
+                   ", ";
 
         for (unsigned int i = 0; i < 3; ++i)
         {
@@ -196,17 +294,138 @@ std::string BP1Writer::GetRankProfilingLog(
     return rankLog;
 }
 
+void BP1Writer::AggregateMetadata(const std::vector<char> &rankMetadata,
+                                  const std::vector<std::size_t> &rankSizes,
+                                  const std::vector<std::uint32_t> &fileIndices,
+                                  capsule::STLVector &heap) const
+{
+    // merges a rank index into indices, adds the rank file index (if not
+    // nullptr) to each characteristics set
+    auto lf_MergeIndices = [&](
+        const std::vector<char> &footer, std::size_t position,
+        const std::uint32_t *fileIndex,
+        std::unordered_map<std::string, BP1Index> &indices) {
+
+        const std::uint32_t fileIndexLength =
+            (fileIndex == nullptr) ? 0 : 1 + 4;
+
+        std::uint32_t count;
+        CopyFromBuffer(&count, 1, footer, position);
+        position += 8; // skip length
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const std::size_t entryPosition = position;
+            std::uint32_t entryLength;
+            CopyFromBuffer(&entryLength, 1, footer, position);
+            const std::size_t entryEnd = position + entryLength;
+
+            position += 4 + 2; // skip memberID and group
+            std::uint16_t nameLength;
+            CopyFromBuffer(&nameLength, 1, footer, position);
+            const std::string name(&footer[position], nameLength);
+            position += nameLength + 2 + 1; // name, path, type
+            const std::size_t setsCountPosition = position - entryPosition;
+            std::uint64_t setsCount;
+            CopyFromBuffer(&setsCount, 1, footer, position);
+
+            bool isNew = true;
+            BP1Index &index = GetBP1Index(name, indices, isNew);
+            auto &buffer = index.Buffer;
+            if (isNew == true) // header from the first rank with this name
+            {
+                buffer.insert(buffer.end(), &footer[entryPosition],
+                              &footer[entryPosition] + setsCountPosition + 8);
+                CopyToBuffer(buffer, 4, &index.MemberID);
+            }
+            index.Count += setsCount;
+            CopyToBuffer(buffer, setsCountPosition, &index.Count);
+
+            Serializer serializer(buffer, entryEnd - position +
+                                              setsCount * fileIndexLength,
+                                  m_DebugMode);
+            for (std::uint64_t s = 0; s < setsCount; ++s)
+            {
+                std::uint8_t characteristicsCount;
+                std::uint32_t characteristicsLength;
+                CopyFromBuffer(&characteristicsCount, 1, footer, position);
+                CopyFromBuffer(&characteristicsLength, 1, footer, position);
+
+                if (fileIndex != nullptr)
+                {
+                    ++characteristicsCount;
+                }
+                const std::uint32_t length =
+                    characteristicsLength + fileIndexLength;
+                serializer.Write(&characteristicsCount);
+                serializer.Write(&length);
+                serializer.Write(&footer[position], characteristicsLength);
+                position += characteristicsLength;
+
+                if (fileIndex != nullptr)
+                {
+                    const std::uint8_t id = characteristic_file_index;
+                    serializer.Write(&id);
+                    serializer.Write(fileIndex);
+                }
+            }
+            position = entryEnd;
+        }
+    };
+
+    BP1MetadataSet metadataSet;
+    auto &pgIndex = metadataSet.PGIndex.Buffer;
+    std::size_t rankPosition = 0;
+
+    for (std::size_t r = 0; r < rankSizes.size(); ++r)
+    {
+        const std::size_t rankSize = rankSizes[r];
+        if (rankSize == 0) // rank without a file
+        {
+            continue;
+        }
+        const std::vector<char> footer(&rankMetadata[rankPosition],
+                                       &rankMetadata[rankPosition] + rankSize);
+        rankPosition += rankSize;
+
+        // rank offsets are absolute in its file, footer starts at the pg index
+        std::size_t position = rankSize - metadataSet.MiniFooterSize;
+        std::uint64_t offsetPGIndex, offsetVarsIndex, offsetAttributeIndex;
+        CopyFromBuffer(&offsetPGIndex, 1, footer, position);
+        CopyFromBuffer(&offsetVarsIndex, 1, footer, position);
+        CopyFromBuffer(&offsetAttributeIndex, 1, footer, position);
+
+        // pg index entries have the rank, offsets are in its file
+        position = 0;
+        std::uint64_t pgCount, pgLength;
+        CopyFromBuffer(&pgCount, 1, footer, position);
+        CopyFromBuffer(&pgLength, 1, footer, position);
+        pgIndex.insert(pgIndex.end(), &footer[position],
+                       &footer[position] + pgLength);
+        metadataSet.DataPGCount += pgCount;
+
+        const std::uint32_t *fileIndex =
+            fileIndices.empty() ? nullptr : &fileIndices[r];
+        lf_MergeIndices(footer, offsetVarsIndex - offsetPGIndex, fileIndex,
+                        metadataSet.VarsIndices);
+        lf_MergeIndices(footer, offsetAttributeIndex - offsetPGIndex,
+                        fileIndex, metadataSet.AttributesIndices);
+    }
+
+    FlattenMetadata(metadataSet, heap);
+}
+
 // PRIVATE FUNCTIONS
 void BP1Writer::WriteDimensionsRecord(
-    std::vector<char> &buffer, const std::vector<std::size_t> &localDimensions,
+    Serializer &serializer, const std::vector<std::size_t> &localDimensions,
     const std::vector<std::size_t> &globalDimensions,
     const std::vector<std::size_t> &globalOffsets, const unsigned int skip,
-    const bool addType) const noexcept
+    const bool addType) const
 {
-    auto lf_WriteFlaggedDim = [](std::vector<char> &buffer, const char no,
+    auto lf_WriteFlaggedDim = [](Serializer &serializer, const char no,
                                  const std::size_t dimension) {
-        CopyToBuffer(buffer, &no);
-        CopyToBuffer(buffer, reinterpret_cast<const uint64_t *>(&dimension));
+        serializer.Write(&no);
+        serializer.Write(reinterpret_cast<const uint64_t *>(&dimension));
     };
 
     // BODY Starts here
@@ -219,17 +438,17 @@ void BP1Writer::WriteDimensionsRecord(
                      // memberID for now)
             for (const auto &localDimension : localDimensions)
             {
-                lf_WriteFlaggedDim(buffer, no, localDimension);
-                buffer.insert(buffer.end(), skip, 0);
+                lf_WriteFlaggedDim(serializer, no, localDimension);
+                serializer.Skip(skip);
             }
         }
         else
         {
             for (const auto &localDimension : localDimensions)
             {
-                CopyToBuffer(buffer, reinterpret_cast<const uint64_t *>(
-                                         &localDimension));
-                buffer.insert(buffer.end(), skip, 0);
+                serializer.Write(
+                    reinterpret_cast<const uint64_t *>(&localDimension));
+                serializer.Skip(skip);
             }
         }
     }
@@ -241,32 +460,32 @@ void BP1Writer::WriteDimensionsRecord(
                 'n'; // dimension format unsigned int value for now
             for (unsigned int d = 0; d < localDimensions.size(); ++d)
             {
-                lf_WriteFlaggedDim(buffer, no, localDimensions[d]);
-                lf_WriteFlaggedDim(buffer, no, globalDimensions[d]);
-                lf_WriteFlaggedDim(buffer, no, globalOffsets[d]);
+                lf_WriteFlaggedDim(serializer, no, localDimensions[d]);
+                lf_WriteFlaggedDim(serializer, no, globalDimensions[d]);
+                lf_WriteFlaggedDim(serializer, no, globalOffsets[d]);
             }
         }
         else
         {
             for (unsigned int d = 0; d < localDimensions.size(); ++d)
             {
-                CopyToBuffer(buffer, reinterpret_cast<const uint64_t *>(
-                                         &localDimensions[d]));
-                CopyToBuffer(buffer, reinterpret_cast<const uint64_t *>(
-                                         &globalDimensions[d]));
-                CopyToBuffer(buffer, reinterpret_cast<const uint64_t *>(
-                                         &globalOffsets[d]));
+                serializer.Write(
+                    reinterpret_cast<const uint64_t *>(&localDimensions[d]));
+                serializer.Write(
+                    reinterpret_cast<const uint64_t *>(&globalDimensions[d]));
+                serializer.Write(
+                    reinterpret_cast<const uint64_t *>(&globalOffsets[d]));
             }
         }
     }
 }
 
-void BP1Writer::WriteNameRecord(const std::string name,
-                                std::vector<char> &buffer) const noexcept
+void BP1Writer::WriteNameRecord(const std::string &name,
+                                Serializer &serializer) const
 {
     const std::uint16_t length = name.length();
-    CopyToBuffer(buffer, &length);
-    CopyToBuffer(buffer, name.c_str(), length);
+    serializer.Write(&length);
+    serializer.Write(name.c_str(), length);
 }
 
 BP1Index &
@@ -286,35 +505,111 @@ BP1Writer::GetBP1Index(const std::string name,
     return itName->second;
 }
 
-void BP1Writer::FlattenData(BP1MetadataSet &metadataSet,
-                            capsule::STLVector &heap) const noexcept
+void BP1Writer::CloseProcessGroup(BP1MetadataSet &metadataSet,
+                                  capsule::STLVector &heap,
+                                  const std::size_t payloadSize) const
 {
-    auto &buffer = heap.m_Data;
-    // vars count and Length (only for PG)
-    CopyToBuffer(buffer, metadataSet.DataPGVarsCountPosition,
-                 &metadataSet.DataPGVarsCount);
-    const std::uint64_t varsLength = buffer.size() -
-                                     metadataSet.DataPGVarsCountPosition - 8 -
-                                     4; // without record itself and vars count
-    CopyToBuffer(buffer, metadataSet.DataPGVarsCountPosition + 4, &varsLength);
+    // deferred payloads in this pg are not in the buffer
+    std::size_t deferredSize = 0;
+    for (auto extent = heap.m_Extents.rbegin();
+         extent != heap.m_Extents.rend() &&
+         extent->Position > metadataSet.DataPGVarsCountPosition;
+         ++extent)
+    {
+        deferredSize += extent->Size;
+    }
 
-    // attributes (empty for now) count (4) and length (8) are zero by moving
-    // positions in time step zero
-    buffer.insert(buffer.end(), 12, 0);
-    heap.m_DataAbsolutePosition += 12;
+    Serializer serializer(heap.m_Data, 0, m_DebugMode); // backpatch only
+    // vars count and Length (only for PG)
+    serializer.WriteAt(metadataSet.DataPGVarsCountPosition,
+                       &metadataSet.DataPGVarsCount);
+    const std::uint64_t varsLength =
+        serializer.Position() + deferredSize + payloadSize -
+        metadataSet.DataPGVarsCountPosition - 8 -
+        4; // without record itself and vars count
+    serializer.WriteAt(metadataSet.DataPGVarsCountPosition + 4, &varsLength);
 
     // Finish writing pg group length
     const std::uint64_t dataPGLength =
-        buffer.size() - metadataSet.DataPGLengthPosition -
+        serializer.Position() + deferredSize + payloadSize + 12 -
+        metadataSet.DataPGLengthPosition -
         8; // without record itself, 12 due to empty attributes
-    CopyToBuffer(buffer, metadataSet.DataPGLengthPosition, &dataPGLength);
+    serializer.WriteAt(metadataSet.DataPGLengthPosition, &dataPGLength);
 
-    ++metadataSet.TimeStep;
     metadataSet.DataPGIsOpen = false;
 }
 
+void BP1Writer::WriteHeap(const capsule::STLVector &heap,
+                          Transport &transport) const
+{
+    if (heap.m_Extents.empty())
+    {
+        transport.Write(heap.m_Data.data(), heap.m_Data.size());
+        return;
+    }
+
+    std::vector<iovec> iov;
+    iov.reserve(2 * heap.m_Extents.size() + 1);
+    std::size_t position = 0;
+    for (const auto &extent : heap.m_Extents)
+    {
+        if (extent.Position > position)
+        {
+            iov.push_back({const_cast<char *>(heap.m_Data.data()) + position,
+                           extent.Position - position});
+            position = extent.Position;
+        }
+        iov.push_back({const_cast<char *>(extent.Data), extent.Size});
+    }
+    if (heap.m_Data.size() > position)
+    {
+        iov.push_back({const_cast<char *>(heap.m_Data.data()) + position,
+                       heap.m_Data.size() - position});
+    }
+
+    transport.WriteV(iov.data(), static_cast<int>(iov.size()));
+}
+
+void BP1Writer::ShiftOffsets(BP1MetadataSet &metadataSet,
+                             const std::uint64_t shift) const
+{
+    auto lf_ShiftOffsets = [shift](BP1Index &index) {
+        for (const auto position : index.OffsetPositions)
+        {
+            std::uint64_t offset;
+            std::memcpy(&offset, &index.Buffer[position], sizeof(offset));
+            offset += shift;
+            CopyToBuffer(index.Buffer, position, &offset);
+        }
+    };
+
+    lf_ShiftOffsets(metadataSet.PGIndex);
+    for (auto &indexPair : metadataSet.VarsIndices)
+    {
+        lf_ShiftOffsets(indexPair.second);
+    }
+    for (auto &indexPair : metadataSet.AttributesIndices)
+    {
+        lf_ShiftOffsets(indexPair.second);
+    }
+}
+
+void BP1Writer::FlattenData(BP1MetadataSet &metadataSet,
+                            capsule::STLVector &heap) const
+{
+    CloseProcessGroup(metadataSet, heap);
+
+    // attributes (empty for now) count (4) and length (8) are zero by moving
+    // positions in time step zero
+    Serializer serializer(heap.m_Data, 12, m_DebugMode);
+    serializer.Skip(12);
+    heap.m_DataAbsolutePosition += 12;
+
+    ++metadataSet.TimeStep;
+}
+
 void BP1Writer::FlattenMetadata(BP1MetadataSet &metadataSet,
-                                capsule::STLVector &heap) const noexcept
+                                capsule::STLVector &heap) const
 {
     auto lf_IndexCountLength =
         [](std::unordered_map<std::string, BP1Index> &indices,
@@ -331,17 +626,41 @@ void BP1Writer::FlattenMetadata(BP1MetadataSet &metadataSet,
             }
         };
 
-    auto lf_FlattenIndices =
-        [](const std::uint32_t count, const std::uint64_t length,
-           const std::unordered_map<std::string, BP1Index> &indices,
-           std::vector<char> &buffer) {
-            CopyToBuffer(buffer, &count);
-            CopyToBuffer(buffer, &length);
+    // indices are flattened sorted by name, independent of hash order
+    auto lf_SortedIndices =
+        [](const std::unordered_map<std::string, BP1Index> &indices) {
+            std::vector<const std::pair<const std::string, BP1Index> *> sorted;
+            sorted.reserve(indices.size());
+            for (const auto &indexPair : indices)
+            {
+                sorted.push_back(&indexPair);
+            }
+            std::sort(sorted.begin(), sorted.end(),
+                      [](const std::pair<const std::string, BP1Index> *a,
+                         const std::pair<const std::string, BP1Index> *b) {
+                          return a->first < b->first;
+                      });
+            return sorted;
+        };
 
-            for (const auto &indexPair : indices) // set each index length
+    // offsets: if not nullptr, absolute position of each index entry, buffer
+    // position + bufferOffset
+    auto lf_FlattenIndices =
+        [&](const std::uint32_t count, const std::uint64_t length,
+            const std::unordered_map<std::string, BP1Index> &indices,
+            Serializer &serializer, const std::uint64_t bufferOffset,
+            std::vector<std::uint64_t> *offsets) {
+            serializer.Write(&count);
+            serializer.Write(&length);
+
+            for (const auto indexPair : lf_SortedIndices(indices))
             {
-                const auto &indexBuffer = indexPair.second.Buffer;
-                CopyToBuffer(buffer, indexBuffer.data(), indexBuffer.size());
+                if (offsets != nullptr)
+                {
+                    offsets->push_back(bufferOffset + serializer.Position());
+                }
+                const auto &indexBuffer = indexPair->second.Buffer;
+                serializer.Write(indexBuffer.data(), indexBuffer.size());
             }
         };
 
@@ -360,23 +679,38 @@ void BP1Writer::FlattenMetadata(BP1MetadataSet &metadataSet,
     lf_IndexCountLength(metadataSet.AttributesIndices, attributesCount,
                         attributesLength);
 
+    // sorted variable name table: count (4), length (8), offsets (8 each)
+    const std::uint64_t namesLength = 8 * varsCount;
+
     const std::size_t footerSize = (pgLength + 16) + (varsLength + 12) +
                                    (attributesLength + 12) +
+                                   (namesLength + 12) +
                                    metadataSet.MiniFooterSize;
-    auto &buffer = heap.m_Data;
-    buffer.reserve(buffer.size() + footerSize); // reserve data to fit metadata,
-    // must replace with growth buffer
-    // strategy
+    // absolute position of the first byte in the heap buffer
+    const std::uint64_t bufferOffset =
+        heap.m_DataAbsolutePosition - heap.m_Data.size();
+    metadataSet.MetadataPosition = heap.m_Data.size();
+    Serializer serializer(heap.m_Data, footerSize, m_DebugMode);
 
     // write pg index
-    CopyToBuffer(buffer, &pgCount);
-    CopyToBuffer(buffer, &pgLength);
-    CopyToBuffer(buffer, metadataSet.PGIndex.Buffer.data(), pgLength);
+    serializer.Write(&pgCount);
+    serializer.Write(&pgLength);
+    serializer.Write(metadataSet.PGIndex.Buffer.data(), pgLength);
     // Vars indices
-    lf_FlattenIndices(varsCount, varsLength, metadataSet.VarsIndices, buffer);
+    std::vector<std::uint64_t> varsOffsets;
+    varsOffsets.reserve(varsCount);
+    lf_FlattenIndices(varsCount, varsLength, metadataSet.VarsIndices,
+                      serializer, bufferOffset, &varsOffsets);
     // Attribute indices
     lf_FlattenIndices(attributesCount, attributesLength,
-                      metadataSet.AttributesIndices, buffer);
+                      metadataSet.AttributesIndices, serializer, bufferOffset,
+                      nullptr);
+    // Variable name table, follows the attribute index. Entries are the
+    // absolute offsets of the name sorted var index entries, so a reader can
+    // binary search a variable name without parsing the var index
+    serializer.Write(&varsCount);
+    serializer.Write(&namesLength);
+    serializer.Write(varsOffsets.data(), varsOffsets.size());
 
     // getting absolute offsets, minifooter is 28 bytes for now
     const std::uint64_t offsetPGIndex = heap.m_DataAbsolutePosition;
@@ -384,17 +718,17 @@ void BP1Writer::FlattenMetadata(BP1MetadataSet &metadataSet,
     const std::uint64_t offsetAttributeIndex =
         offsetVarsIndex + (varsLength + 12);
 
-    CopyToBuffer(buffer, &offsetPGIndex);
-    CopyToBuffer(buffer, &offsetVarsIndex);
-    CopyToBuffer(buffer, &offsetAttributeIndex);
+    serializer.Write(&offsetPGIndex);
+    serializer.Write(&offsetVarsIndex);
+    serializer.Write(&offsetAttributeIndex);
 
     // version
     if (IsLittleEndian())
     {
         const std::uint8_t endian = 0;
-        CopyToBuffer(buffer, &endian);
-        buffer.insert(buffer.end(), 2, 0);
-        CopyToBuffer(buffer, &m_Version);
+        serializer.Write(&endian);
+        serializer.Skip(2);
+        serializer.Write(&m_Version);
     }
     else
     {
@@ -0,0 +1,37 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * Serializer.cpp
+ *
+ *  Created on: Apr 24, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <stdexcept>
+/// \endcond
+
+#include "format/Serializer.h"
+
+namespace adios
+{
+namespace format
+{
+
+Serializer::~Serializer() { m_Resize(m_Buffer, Position()); }
+
+void Serializer::CheckBounds(const char *destination, const std::size_t bytes,
+                             const char *end, const std::string hint) const
+{
+    if (destination < m_Data || destination + bytes > end)
+    {
+        throw std::out_of_range("ERROR: Serializer::" + hint + " of " +
+                                std::to_string(bytes) +
+                                " bytes is outside the reserved buffer, "
+                                "reserved size was underestimated\n");
+    }
+}
+
+} // end namespace format
+} // end namespace adios
@@ -443,6 +443,280 @@ std::size_t GetTotalSize(const std::vector<std::size_t> &dimensions)
     return product;
 }
 
+bool IsContiguousInBlock(const std::vector<std::size_t> &blockStart,
+                         const std::vector<std::size_t> &blockCount,
+                         const std::vector<std::size_t> &start,
+                         const std::vector<std::size_t> &count,
+                         std::size_t &offset) noexcept
+{
+    const std::size_t dimensions = blockCount.size();
+    if (blockStart.size() != dimensions || start.size() != dimensions ||
+        count.size() != dimensions)
+    {
+        return false;
+    }
+
+    offset = 0;
+    bool isSpanning = false; // a previous dimension has more than one row
+    for (std::size_t d = 0; d < dimensions; ++d)
+    {
+        if (start[d] < blockStart[d] ||
+            start[d] + count[d] > blockStart[d] + blockCount[d])
+        {
+            return false;
+        }
+
+        if (isSpanning == true && count[d] != blockCount[d])
+        {
+            return false;
+        }
+        if (count[d] != 1)
+        {
+            isSpanning = true;
+        }
+
+        offset = offset * blockCount[d] + (start[d] - blockStart[d]);
+    }
+    return true;
+}
+
+bool CopyIntersection(const char *source,
+                      const std::vector<std::size_t> &sourceStart,
+                      const std::vector<std::size_t> &sourceCount,
+                      char *destination,
+                      const std::vector<std::size_t> &destinationStart,
+                      const std::vector<std::size_t> &destinationCount,
+                      const std::size_t elementSize) noexcept
+{
+    const std::size_t dimensions = sourceCount.size();
+    if (dimensions == 0)
+    {
+        std::memcpy(destination, source, elementSize);
+        return true;
+    }
+
+    std::vector<std::size_t> lower(dimensions), upper(dimensions);
+    for (std::size_t d = 0; d < dimensions; ++d)
+    {
+        lower[d] = std::max(sourceStart[d], destinationStart[d]);
+        upper[d] = std::min(sourceStart[d] + sourceCount[d],
+                            destinationStart[d] + destinationCount[d]);
+        if (upper[d] <= lower[d])
+        {
+            return false;
+        }
+    }
+
+    // inner dimensions covering both boxes extend a single contiguous run
+    std::size_t inner = dimensions - 1;
+    std::size_t runElements = upper[inner] - lower[inner];
+    while (inner > 0 && lower[inner] == sourceStart[inner] &&
+           lower[inner] == destinationStart[inner] &&
+           upper[inner] - lower[inner] == sourceCount[inner] &&
+           upper[inner] - lower[inner] == destinationCount[inner])
+    {
+        --inner;
+        runElements *= upper[inner] - lower[inner];
+    }
+    const std::size_t runSize = runElements * elementSize;
+
+    // short runs are copied with fixed size memcpy, inlined by the compiler
+    auto lf_CopyRun = [runSize](char *to, const char *from) {
+        switch (runSize)
+        {
+        case 4:
+            std::memcpy(to, from, 4);
+            break;
+        case 8:
+            std::memcpy(to, from, 8);
+            break;
+        case 16:
+            std::memcpy(to, from, 16);
+            break;
+        default:
+            std::memcpy(to, from, runSize);
+        }
+    };
+
+    std::vector<std::size_t> sourceStrides(dimensions, 1);
+    std::vector<std::size_t> destinationStrides(dimensions, 1);
+    for (std::size_t d = dimensions - 1; d > 0; --d)
+    {
+        sourceStrides[d - 1] = sourceStrides[d] * sourceCount[d];
+        destinationStrides[d - 1] =
+            destinationStrides[d] * destinationCount[d];
+    }
+
+    std::size_t sourceOffset = 0, destinationOffset = 0;
+    for (std::size_t d = 0; d <= inner; ++d)
+    {
+        sourceOffset += (lower[d] - sourceStart[d]) * sourceStrides[d];
+        destinationOffset +=
+            (lower[d] - destinationStart[d]) * destinationStrides[d];
+    }
+    const char *from = source + sourceOffset * elementSize;
+    char *to = destination + destinationOffset * elementSize;
+
+    if (inner == 0)
+    {
+        std::memcpy(to, from, runSize);
+        return true;
+    }
+
+    // rows of dimension inner - 1 are walked with pointer strides, an
+    // odometer runs over the dimensions above them
+    const std::size_t row = inner - 1;
+    const std::size_t rows = upper[row] - lower[row];
+    const std::size_t sourceRowStride = sourceStrides[row] * elementSize;
+    const std::size_t destinationRowStride =
+        destinationStrides[row] * elementSize;
+
+    std::vector<std::size_t> index(lower.begin(), lower.begin() + row);
+    while (true)
+    {
+        const char *rowFrom = from;
+        char *rowTo = to;
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            lf_CopyRun(rowTo, rowFrom);
+            rowFrom += sourceRowStride;
+            rowTo += destinationRowStride;
+        }
+
+        // next outer index, pointers move by the stride of the dimension
+        // that advances minus the extent of the dimensions that wrap
+        std::size_t d = row;
+        while (true)
+        {
+            if (d == 0)
+            {
+                return true;
+            }
+            --d;
+            if (++index[d] < upper[d])
+            {
+                from += sourceStrides[d] * elementSize;
+                to += destinationStrides[d] * elementSize;
+                break;
+            }
+            index[d] = lower[d];
+            from -= (upper[d] - lower[d] - 1) * sourceStrides[d] * elementSize;
+            to -= (upper[d] - lower[d] - 1) * destinationStrides[d] *
+                  elementSize;
+        }
+    }
+}
+
+namespace
+{
+const std::uint32_t wahFill = 0x80000000;    ///< bit 31 of fill words
+const std::uint32_t wahFillBit = 0x40000000; ///< bit 30 of fill words
+const std::uint32_t wahMaxRun = 0x3FFFFFFF;  ///< groups in a fill word
+const std::uint32_t wahOnes = 0x7FFFFFFF;    ///< literal with 31 bits set
+
+/** appends groups of 31 equal bits, merged with a previous equal fill */
+void AppendWAHFill(std::vector<std::uint32_t> &words, const bool bit,
+                   std::uint64_t groups) noexcept
+{
+    const std::uint32_t fill = wahFill | (bit ? wahFillBit : 0);
+    while (groups > 0)
+    {
+        if (words.empty() == false &&
+            (words.back() & (wahFill | wahFillBit)) == fill &&
+            (words.back() & wahMaxRun) < wahMaxRun)
+        {
+            const std::uint64_t run = words.back() & wahMaxRun;
+            const std::uint64_t added = std::min(groups, wahMaxRun - run);
+            words.back() += static_cast<std::uint32_t>(added);
+            groups -= added;
+            continue;
+        }
+
+        const std::uint64_t run = std::min(groups, std::uint64_t(wahMaxRun));
+        words.push_back(fill | static_cast<std::uint32_t>(run));
+        groups -= run;
+    }
+}
+} // end empty namespace
+
+void AppendWAHGroup(std::vector<std::uint32_t> &words, std::uint64_t &nextGroup,
+                    const std::uint64_t group,
+                    const std::uint32_t literal) noexcept
+{
+    if (group > nextGroup)
+    {
+        AppendWAHFill(words, false, group - nextGroup);
+    }
+
+    if (literal == wahOnes)
+    {
+        AppendWAHFill(words, true, 1);
+    }
+    else if (literal == 0)
+    {
+        AppendWAHFill(words, false, 1);
+    }
+    else
+    {
+        words.push_back(literal);
+    }
+    nextGroup = group + 1;
+}
+
+bool GetWAHPositions(const char *words, const std::size_t wordsCount,
+                     const std::size_t size,
+                     std::vector<std::size_t> &positions)
+{
+    const std::size_t groups = (size + 30) / 31;
+    std::size_t group = 0;
+    for (std::size_t w = 0; w < wordsCount; ++w)
+    {
+        if (group >= groups)
+        {
+            return false;
+        }
+
+        std::uint32_t word;
+        std::memcpy(&word, &words[w * 4], 4);
+
+        if ((word & wahFill) == 0)
+        {
+            while (word != 0)
+            {
+                const std::size_t position =
+                    group * 31 + CountTrailingZeros(word);
+                if (position >= size)
+                {
+                    return false;
+                }
+                positions.push_back(position);
+                word &= word - 1;
+            }
+            ++group;
+            continue;
+        }
+
+        const std::size_t run = word & wahMaxRun;
+        if (run > groups - group)
+        {
+            return false;
+        }
+        if ((word & wahFillBit) != 0)
+        {
+            if ((group + run) * 31 > size)
+            {
+                return false;
+            }
+            for (std::size_t p = group * 31; p < (group + run) * 31; ++p)
+            {
+                positions.push_back(p);
+            }
+        }
+        group += run;
+    }
+    return true;
+}
+
 void CreateDirectory(const std::string fullPath) noexcept
 {
     auto lf_Mkdir = [](const std::string directory, struct stat &st) {
@@ -646,15 +920,19 @@ void ConvertUint64VectorToSizetVector(const std::vector<std::uint64_t> &in,
 
 bool CheckBufferAllocation(const std::size_t newSize, const float growthFactor,
                            const std::size_t maxBufferSize,
-                           std::vector<char> &buffer)
+                           capsule::HeapBuffer &buffer)
 {
     // Check if data in buffer needs to be reallocated
     const std::size_t requiredDataSize =
         buffer.size() + newSize + 100; // adding some bytes for tolerance
     // might need to write payload in batches
-    bool doTransportsFlush = (requiredDataSize > maxBufferSize) ? true : false;
+    if (requiredDataSize > maxBufferSize)
+    {
+        return true; // don't grow beyond maxBufferSize
+    }
 
-    if (GrowBuffer(requiredDataSize, growthFactor, buffer) == -1)
+    bool doTransportsFlush = false;
+    if (GrowBuffer(newSize + 100, growthFactor, maxBufferSize, buffer) == -1)
     {
         doTransportsFlush = true;
     }
@@ -663,7 +941,7 @@ bool CheckBufferAllocation(const std::size_t newSize, const float growthFactor,
 }
 
 int GrowBuffer(const std::size_t incomingDataSize, const float growthFactor,
-               std::vector<char> &buffer)
+               const std::size_t maxBufferSize, capsule::HeapBuffer &buffer)
 {
     const std::size_t currentCapacity = buffer.capacity();
     const std::size_t availableSpace = currentCapacity - buffer.size();
@@ -672,13 +950,24 @@ int GrowBuffer(const std::size_t incomingDataSize, const float growthFactor,
     if (incomingDataSize > availableSpace)
     {
         const std::size_t neededCapacity = incomingDataSize + buffer.size();
-        const double numerator = std::log(static_cast<double>(neededCapacity) /
-                                          static_cast<double>(currentCapacity));
-        const double denominator = std::log(gf);
+        std::size_t newSize = neededCapacity;
 
-        double n = std::ceil(numerator / denominator);
-        const std::size_t newSize = static_cast<std::size_t>(
-            std::ceil(std::pow(gf, n) * currentCapacity));
+        if (currentCapacity > 0)
+        {
+            const double numerator =
+                std::log(static_cast<double>(neededCapacity) /
+                         static_cast<double>(currentCapacity));
+            const double denominator = std::log(gf);
+
+            double n = std::ceil(numerator / denominator);
+            newSize = static_cast<std::size_t>(
+                std::ceil(std::pow(gf, n) * currentCapacity));
+        }
+
+        if (newSize > maxBufferSize) // growth factor can't exceed max size
+        {
+            newSize = std::max(neededCapacity, maxBufferSize);
+        }
 
         try
         {
@@ -0,0 +1,1116 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * adiosSIMD.cpp
+ *
+ *  Created on: Apr 18, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::min, std::max
+#include <cmath>      //std::sqrt
+#include <cstdlib>    //std::getenv
+#include <cstring>    //std::memcpy
+#include <functional> //std::ref
+#include <string>
+#include <thread>
+#include <vector>
+/// \endcond
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ADIOS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#include "functions/adiosFunctions.h" //CountTrailingZeros
+#include "functions/adiosSIMD.h"
+
+namespace adios
+{
+
+namespace
+{
+
+/** instruction sets with a dedicated kernel, detected once at runtime */
+enum class ISA
+{
+    Default, ///< SSE2 on x86-64, compiler generated otherwise
+    AVX2,
+    AVX512
+};
+
+/**
+ * Best instruction set of the CPU, the ADIOS_SIMD environment variable (sse2,
+ * avx2 or avx512) can only lower it, e.g. to test every kernel on one machine
+ */
+ISA DetectISA() noexcept
+{
+    ISA isa = ISA::Default;
+#ifdef ADIOS_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        isa = ISA::AVX512;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        isa = ISA::AVX2;
+    }
+#endif
+
+    const char *level = std::getenv("ADIOS_SIMD");
+    if (level != nullptr)
+    {
+        const std::string requested(level);
+        if (requested == "sse2")
+        {
+            isa = ISA::Default;
+        }
+        else if (requested == "avx2" && isa == ISA::AVX512)
+        {
+            isa = ISA::AVX2;
+        }
+    }
+    return isa;
+}
+
+ISA GetISA() noexcept
+{
+    static const ISA isa = DetectISA();
+    return isa;
+}
+
+/**
+ * kernels copy values to destination bytes while reducing, unless nullptr, and
+ * accumulate moments, unless nullptr
+ */
+template <class T, class U>
+using MinMaxKernel = void (*)(const T *, const std::size_t, char *, U &, U &,
+                              Moments *);
+
+/**
+ * Reduces the lanes accumulators of MinMaxLanes and NormMinMaxLanes
+ */
+template <class T, std::size_t lanes, bool moments>
+inline void ReduceLanes(const T *mins, const T *maxs, const double *sums,
+                        const double *squares, const std::uint64_t *counts,
+                        const std::size_t size, T &min, T &max,
+                        Moments *momentsOut) noexcept
+{
+    min = mins[0];
+    max = maxs[0];
+    for (std::size_t l = 1; l < lanes; ++l)
+    {
+        min = (mins[l] < min) ? mins[l] : min;
+        max = (maxs[l] > max) ? maxs[l] : max;
+    }
+
+    if (moments)
+    {
+        *momentsOut = Moments();
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            momentsOut->Count += counts[l];
+            momentsOut->Sum += sums[l];
+            momentsOut->SumSquare += squares[l];
+        }
+        momentsOut->Finite = (momentsOut->Count == size);
+    }
+}
+
+/**
+ * Branchless min/max over independent lanes (one 512-bit register wide), the
+ * compiler vectorizes it for the instruction set of the calling function.
+ * If copy is true each block is copied to destination while in registers.
+ * If moments is true count, sum and sum of squares of finite values are
+ * accumulated in the same pass.
+ */
+template <class T, bool copy, bool moments>
+inline void MinMaxLanes(const T *values, const std::size_t size,
+                        char *destination, T &min, T &max,
+                        Moments *momentsOut) noexcept
+{
+    constexpr std::size_t lanes = (64 / sizeof(T) > 0) ? 64 / sizeof(T) : 1;
+    T mins[lanes];
+    T maxs[lanes];
+    double sums[lanes] = {};
+    double squares[lanes] = {};
+    std::uint64_t counts[lanes] = {};
+    for (std::size_t l = 0; l < lanes; ++l)
+    {
+        mins[l] = values[0];
+        maxs[l] = values[0];
+    }
+
+    const std::size_t blocks = size - size % lanes;
+    for (std::size_t i = 0; i < blocks; i += lanes)
+    {
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            const T value = values[i + l];
+            mins[l] = (value < mins[l]) ? value : mins[l];
+            maxs[l] = (value > maxs[l]) ? value : maxs[l];
+
+            if (moments)
+            {
+                const double x = static_cast<double>(value);
+                const bool finite = (x - x == 0.); // false for inf and NaN
+                counts[l] += finite;
+                sums[l] += finite ? x : 0.;
+                squares[l] += finite ? x * x : 0.;
+            }
+        }
+
+        if (copy)
+        {
+            std::memcpy(&destination[i * sizeof(T)], &values[i],
+                        lanes * sizeof(T));
+        }
+    }
+
+    for (std::size_t i = blocks; i < size; ++i)
+    {
+        mins[0] = (values[i] < mins[0]) ? values[i] : mins[0];
+        maxs[0] = (values[i] > maxs[0]) ? values[i] : maxs[0];
+
+        if (moments)
+        {
+            const double x = static_cast<double>(values[i]);
+            const bool finite = (x - x == 0.);
+            counts[0] += finite;
+            sums[0] += finite ? x : 0.;
+            squares[0] += finite ? x * x : 0.;
+        }
+    }
+
+    if (copy)
+    {
+        std::memcpy(&destination[blocks * sizeof(T)], &values[blocks],
+                    (size - blocks) * sizeof(T));
+    }
+
+    ReduceLanes<T, lanes, moments>(mins, maxs, sums, squares, counts, size,
+                                   min, max, momentsOut);
+}
+
+/**
+ * Complex version, min and max of the squared modulus (std::norm) over
+ * independent lanes, std::complex<T> is laid out as T[2]. Moments are
+ * accumulated for the modulus.
+ */
+template <class T, bool copy, bool moments>
+inline void NormMinMaxLanes(const std::complex<T> *values,
+                            const std::size_t size, char *destination, T &min,
+                            T &max, Moments *momentsOut) noexcept
+{
+    constexpr std::size_t lanes = (64 / sizeof(T) > 0) ? 64 / sizeof(T) : 1;
+    const T *parts = reinterpret_cast<const T *>(values);
+
+    const T norm0 = parts[0] * parts[0] + parts[1] * parts[1];
+    T mins[lanes];
+    T maxs[lanes];
+    double sums[lanes] = {};
+    double squares[lanes] = {};
+    std::uint64_t counts[lanes] = {};
+    for (std::size_t l = 0; l < lanes; ++l)
+    {
+        mins[l] = norm0;
+        maxs[l] = norm0;
+    }
+
+    const std::size_t blocks = size - size % lanes;
+    for (std::size_t i = 0; i < blocks; i += lanes)
+    {
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            const T re = parts[2 * (i + l)];
+            const T im = parts[2 * (i + l) + 1];
+            const T norm = re * re + im * im;
+            mins[l] = (norm < mins[l]) ? norm : mins[l];
+            maxs[l] = (norm > maxs[l]) ? norm : maxs[l];
+
+            if (moments)
+            {
+                const double x = static_cast<double>(norm);
+                const bool finite = (x - x == 0.);
+                counts[l] += finite;
+                sums[l] += finite ? std::sqrt(x) : 0.;
+                squares[l] += finite ? x : 0.;
+            }
+        }
+
+        if (copy)
+        {
+            std::memcpy(&destination[i * sizeof(std::complex<T>)], &values[i],
+                        lanes * sizeof(std::complex<T>));
+        }
+    }
+
+    for (std::size_t i = blocks; i < size; ++i)
+    {
+        const T norm = parts[2 * i] * parts[2 * i] +
+                       parts[2 * i + 1] * parts[2 * i + 1];
+        mins[0] = (norm < mins[0]) ? norm : mins[0];
+        maxs[0] = (norm > maxs[0]) ? norm : maxs[0];
+
+        if (moments)
+        {
+            const double x = static_cast<double>(norm);
+            const bool finite = (x - x == 0.);
+            counts[0] += finite;
+            sums[0] += finite ? std::sqrt(x) : 0.;
+            squares[0] += finite ? x : 0.;
+        }
+    }
+
+    if (copy)
+    {
+        std::memcpy(&destination[blocks * sizeof(std::complex<T>)],
+                    &values[blocks], (size - blocks) * sizeof(std::complex<T>));
+    }
+
+    ReduceLanes<T, lanes, moments>(mins, maxs, sums, squares, counts, size,
+                                   min, max, momentsOut);
+}
+
+#ifdef ADIOS_SIMD_X86
+// min/max intrinsics return the second operand if any is NaN, accumulators
+// are passed second so NaNs are skipped as in the scalar comparison
+
+template <class T, bool copy, bool moments>
+__attribute__((target("avx2"))) void
+MinMaxLanesAVX2(const T *values, const std::size_t size, char *destination,
+                T &min, T &max, Moments *momentsOut)
+{
+    MinMaxLanes<T, copy, moments>(values, size, destination, min, max,
+                                  momentsOut);
+}
+
+template <class T, bool copy, bool moments>
+__attribute__((target("avx512f,avx512bw"))) void
+MinMaxLanesAVX512(const T *values, const std::size_t size, char *destination,
+                  T &min, T &max, Moments *momentsOut)
+{
+    MinMaxLanes<T, copy, moments>(values, size, destination, min, max,
+                                  momentsOut);
+}
+
+template <class T, bool copy, bool moments>
+__attribute__((target("avx2"))) void
+NormMinMaxLanesAVX2(const std::complex<T> *values, const std::size_t size,
+                    char *destination, T &min, T &max,
+                    Moments *momentsOut)
+{
+    NormMinMaxLanes<T, copy, moments>(values, size, destination, min, max,
+                                      momentsOut);
+}
+
+template <class T, bool copy, bool moments>
+__attribute__((target("avx512f,avx512bw"))) void
+NormMinMaxLanesAVX512(const std::complex<T> *values, const std::size_t size,
+                      char *destination, T &min, T &max,
+                    Moments *momentsOut)
+{
+    NormMinMaxLanes<T, copy, moments>(values, size, destination, min, max,
+                                      momentsOut);
+}
+
+template <class T>
+inline void ReduceTail(const T *values, const std::size_t begin,
+                       const std::size_t end, const T *mins, const T *maxs,
+                       const std::size_t lanes, T &min, T &max) noexcept
+{
+    min = mins[0];
+    max = maxs[0];
+    for (std::size_t l = 1; l < lanes; ++l)
+    {
+        min = (mins[l] < min) ? mins[l] : min;
+        max = (maxs[l] > max) ? maxs[l] : max;
+    }
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        min = (values[i] < min) ? values[i] : min;
+        max = (values[i] > max) ? values[i] : max;
+    }
+}
+
+void MinMaxSSE2(const double *values, const std::size_t size, char *,
+                double &min, double &max, Moments *)
+{
+    __m128d min0 = _mm_set1_pd(values[0]), max0 = min0;
+    __m128d min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 4;
+    for (std::size_t i = 0; i < blocks; i += 4)
+    {
+        const __m128d v0 = _mm_loadu_pd(&values[i]);
+        const __m128d v1 = _mm_loadu_pd(&values[i + 2]);
+        min0 = _mm_min_pd(v0, min0);
+        max0 = _mm_max_pd(v0, max0);
+        min1 = _mm_min_pd(v1, min1);
+        max1 = _mm_max_pd(v1, max1);
+    }
+
+    double mins[4];
+    double maxs[4];
+    _mm_storeu_pd(&mins[0], min0);
+    _mm_storeu_pd(&mins[2], min1);
+    _mm_storeu_pd(&maxs[0], max0);
+    _mm_storeu_pd(&maxs[2], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 4, min, max);
+}
+
+void MinMaxSSE2(const float *values, const std::size_t size, char *,
+                float &min, float &max, Moments *)
+{
+    __m128 min0 = _mm_set1_ps(values[0]), max0 = min0;
+    __m128 min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 8;
+    for (std::size_t i = 0; i < blocks; i += 8)
+    {
+        const __m128 v0 = _mm_loadu_ps(&values[i]);
+        const __m128 v1 = _mm_loadu_ps(&values[i + 4]);
+        min0 = _mm_min_ps(v0, min0);
+        max0 = _mm_max_ps(v0, max0);
+        min1 = _mm_min_ps(v1, min1);
+        max1 = _mm_max_ps(v1, max1);
+    }
+
+    float mins[8];
+    float maxs[8];
+    _mm_storeu_ps(&mins[0], min0);
+    _mm_storeu_ps(&mins[4], min1);
+    _mm_storeu_ps(&maxs[0], max0);
+    _mm_storeu_ps(&maxs[4], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 8, min, max);
+}
+
+__attribute__((target("avx2"))) void
+MinMaxAVX2(const double *values, const std::size_t size, char *,
+           double &min, double &max, Moments *)
+{
+    __m256d min0 = _mm256_set1_pd(values[0]), max0 = min0;
+    __m256d min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 8;
+    for (std::size_t i = 0; i < blocks; i += 8)
+    {
+        const __m256d v0 = _mm256_loadu_pd(&values[i]);
+        const __m256d v1 = _mm256_loadu_pd(&values[i + 4]);
+        min0 = _mm256_min_pd(v0, min0);
+        max0 = _mm256_max_pd(v0, max0);
+        min1 = _mm256_min_pd(v1, min1);
+        max1 = _mm256_max_pd(v1, max1);
+    }
+
+    double mins[8];
+    double maxs[8];
+    _mm256_storeu_pd(&mins[0], min0);
+    _mm256_storeu_pd(&mins[4], min1);
+    _mm256_storeu_pd(&maxs[0], max0);
+    _mm256_storeu_pd(&maxs[4], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 8, min, max);
+}
+
+__attribute__((target("avx2"))) void
+MinMaxAVX2(const float *values, const std::size_t size, char *,
+           float &min, float &max, Moments *)
+{
+    __m256 min0 = _mm256_set1_ps(values[0]), max0 = min0;
+    __m256 min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 16;
+    for (std::size_t i = 0; i < blocks; i += 16)
+    {
+        const __m256 v0 = _mm256_loadu_ps(&values[i]);
+        const __m256 v1 = _mm256_loadu_ps(&values[i + 8]);
+        min0 = _mm256_min_ps(v0, min0);
+        max0 = _mm256_max_ps(v0, max0);
+        min1 = _mm256_min_ps(v1, min1);
+        max1 = _mm256_max_ps(v1, max1);
+    }
+
+    float mins[16];
+    float maxs[16];
+    _mm256_storeu_ps(&mins[0], min0);
+    _mm256_storeu_ps(&mins[8], min1);
+    _mm256_storeu_ps(&maxs[0], max0);
+    _mm256_storeu_ps(&maxs[8], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 16, min, max);
+}
+
+// GCC 12 warns on the undefined passthrough operand of the unmasked
+// avx512fintrin.h min/max, the masked forms never read it
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) void
+MinMaxAVX512(const double *values, const std::size_t size, char *,
+             double &min, double &max, Moments *)
+{
+    __m512d min0 = _mm512_set1_pd(values[0]), max0 = min0;
+    __m512d min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 16;
+    for (std::size_t i = 0; i < blocks; i += 16)
+    {
+        const __m512d v0 = _mm512_loadu_pd(&values[i]);
+        const __m512d v1 = _mm512_loadu_pd(&values[i + 8]);
+        min0 = _mm512_min_pd(v0, min0);
+        max0 = _mm512_max_pd(v0, max0);
+        min1 = _mm512_min_pd(v1, min1);
+        max1 = _mm512_max_pd(v1, max1);
+    }
+
+    double mins[16];
+    double maxs[16];
+    _mm512_storeu_pd(&mins[0], min0);
+    _mm512_storeu_pd(&mins[8], min1);
+    _mm512_storeu_pd(&maxs[0], max0);
+    _mm512_storeu_pd(&maxs[8], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 16, min, max);
+}
+
+__attribute__((target("avx512f"))) void
+MinMaxAVX512(const float *values, const std::size_t size, char *,
+             float &min, float &max, Moments *)
+{
+    __m512 min0 = _mm512_set1_ps(values[0]), max0 = min0;
+    __m512 min1 = min0, max1 = min0;
+
+    const std::size_t blocks = size - size % 32;
+    for (std::size_t i = 0; i < blocks; i += 32)
+    {
+        const __m512 v0 = _mm512_loadu_ps(&values[i]);
+        const __m512 v1 = _mm512_loadu_ps(&values[i + 16]);
+        min0 = _mm512_min_ps(v0, min0);
+        max0 = _mm512_max_ps(v0, max0);
+        min1 = _mm512_min_ps(v1, min1);
+        max1 = _mm512_max_ps(v1, max1);
+    }
+
+    float mins[32];
+    float maxs[32];
+    _mm512_storeu_ps(&mins[0], min0);
+    _mm512_storeu_ps(&mins[16], min1);
+    _mm512_storeu_ps(&maxs[0], max0);
+    _mm512_storeu_ps(&maxs[16], max1);
+    ReduceTail(values, blocks, size, mins, maxs, 32, min, max);
+}
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * Selects the lane kernel for the current CPU
+ * @return function pointer to kernel
+ */
+template <class T, bool copy, bool moments>
+MinMaxKernel<T, T> GetLanesKernel() noexcept
+{
+#ifdef ADIOS_SIMD_X86
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return MinMaxLanesAVX512<T, copy, moments>;
+    case ISA::AVX2:
+        return MinMaxLanesAVX2<T, copy, moments>;
+    default:
+        break;
+    }
+#endif
+    return MinMaxLanes<T, copy, moments>;
+}
+
+/**
+ * Selects the squared modulus lane kernel for the current CPU
+ * @return function pointer to kernel
+ */
+template <class T, bool copy, bool moments>
+MinMaxKernel<std::complex<T>, T> GetNormLanesKernel() noexcept
+{
+#ifdef ADIOS_SIMD_X86
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return NormMinMaxLanesAVX512<T, copy, moments>;
+    case ISA::AVX2:
+        return NormMinMaxLanesAVX2<T, copy, moments>;
+    default:
+        break;
+    }
+#endif
+    return NormMinMaxLanes<T, copy, moments>;
+}
+
+/**
+ * Selects the min/max kernel (no copy, no moments) for the current CPU
+ * @return function pointer to kernel
+ */
+template <class T>
+MinMaxKernel<T, T> GetMinMaxKernel() noexcept
+{
+    return GetLanesKernel<T, false, false>();
+}
+
+#ifdef ADIOS_SIMD_X86
+template <>
+MinMaxKernel<float, float> GetMinMaxKernel<float>() noexcept
+{
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return MinMaxAVX512;
+    case ISA::AVX2:
+        return MinMaxAVX2;
+    default:
+        return MinMaxSSE2;
+    }
+}
+
+template <>
+MinMaxKernel<double, double> GetMinMaxKernel<double>() noexcept
+{
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return MinMaxAVX512;
+    case ISA::AVX2:
+        return MinMaxAVX2;
+    default:
+        return MinMaxSSE2;
+    }
+}
+#endif
+
+/**
+ * Position of the first value that is not NaN, size if all are NaN. Always 0
+ * for integer types.
+ */
+template <class T>
+inline std::size_t FirstNumber(const T *values,
+                               const std::size_t size) noexcept
+{
+    std::size_t first = 0;
+    while (first < size && values[first] != values[first])
+    {
+        ++first;
+    }
+    return first;
+}
+
+/**
+ * Calls kernel on the values after leading NaNs, kernels seed their
+ * accumulators with the first value and comparisons with NaN are always
+ * false. Leading NaNs are still copied, min and max are NaN only if all
+ * values are NaN.
+ */
+template <class T, class U>
+void MinMaxPiece(MinMaxKernel<T, U> kernel, const T *values,
+                 const std::size_t size, char *destination, U &min, U &max,
+                 Moments *moments) noexcept
+{
+    const std::size_t first = FirstNumber(values, size);
+    if (first == 0 || first == size)
+    {
+        kernel(values, size, destination, min, max, moments);
+        return;
+    }
+
+    if (destination != nullptr)
+    {
+        std::memcpy(destination, values, first * sizeof(T));
+        destination += first * sizeof(T);
+    }
+    kernel(&values[first], size - first, destination, min, max, moments);
+
+    if (moments != nullptr)
+    {
+        moments->Finite = false;
+    }
+}
+
+/**
+ * Splits values in nthreads contiguous pieces, the calling thread takes the
+ * last piece, then reduces each piece min, max and moments skipping pieces
+ * with only NaNs
+ * @param values
+ * @param size
+ * @param destination each piece is copied to its offset, nullptr: no copy
+ * @param min
+ * @param max
+ * @param moments nullptr: not computed
+ * @param nthreads
+ * @param kernel called on each piece
+ */
+template <class T, class U>
+void MinMaxThreads(const T *values, const std::size_t size, char *destination,
+                   U &min, U &max, Moments *moments,
+                   const unsigned int nthreads,
+                   MinMaxKernel<T, U> kernel) noexcept
+{
+    if (size == 0)
+    {
+        min = U();
+        max = U();
+        if (moments != nullptr)
+        {
+            *moments = Moments();
+        }
+        return;
+    }
+
+    // do not split in pieces smaller than 1M elements
+    const std::size_t minBlockSize = 1048576;
+    const std::size_t threads = std::max(
+        std::size_t(1),
+        std::min(static_cast<std::size_t>(nthreads), size / minBlockSize));
+
+    if (threads == 1)
+    {
+        MinMaxPiece(kernel, values, size, destination, min, max, moments);
+        return;
+    }
+
+    const std::size_t stride = size / threads;
+    std::vector<U> mins(threads);
+    std::vector<U> maxs(threads);
+    std::vector<Moments> pieceMoments(threads);
+    std::vector<std::thread> minMaxThreads;
+    minMaxThreads.reserve(threads - 1);
+
+    for (std::size_t t = 0; t < threads - 1; ++t)
+    {
+        char *pieceDestination =
+            (destination == nullptr) ? nullptr
+                                     : &destination[stride * t * sizeof(T)];
+        minMaxThreads.push_back(std::thread(
+            MinMaxPiece<T, U>, kernel, &values[stride * t], stride,
+            pieceDestination, std::ref(mins[t]), std::ref(maxs[t]),
+            (moments == nullptr) ? nullptr : &pieceMoments[t]));
+    }
+
+    const std::size_t last = stride * (threads - 1);
+    char *lastDestination =
+        (destination == nullptr) ? nullptr : &destination[last * sizeof(T)];
+    MinMaxPiece(kernel, &values[last], size - last, lastDestination,
+                mins.back(), maxs.back(),
+                (moments == nullptr) ? nullptr : &pieceMoments.back());
+
+    for (auto &thread : minMaxThreads)
+    {
+        thread.join();
+    }
+
+    min = mins[0];
+    max = maxs[0];
+    for (std::size_t t = 1; t < threads; ++t)
+    {
+        // min != min: previous pieces are all NaN
+        min = (mins[t] < min || min != min) ? mins[t] : min;
+        max = (maxs[t] > max || max != max) ? maxs[t] : max;
+    }
+
+    if (moments != nullptr)
+    {
+        *moments = Moments();
+        for (const auto &piece : pieceMoments)
+        {
+            moments->Count += piece.Count;
+            moments->Sum += piece.Sum;
+            moments->SumSquare += piece.SumSquare;
+            moments->Finite = moments->Finite && piece.Finite;
+        }
+    }
+}
+
+/**
+ * kernels write the positions of values in [lo, hi] and return their number
+ */
+template <class T>
+using InRangeKernel = std::size_t (*)(const T *, const std::size_t, const T,
+                                      const T, std::size_t *);
+
+/**
+ * Appends the positions of the set bits of a comparison mask
+ * @param mask bit l is set if value base + l is a hit
+ * @param base position of bit 0
+ * @param positions output
+ * @param hits positions already written, updated
+ */
+inline void AppendMask(std::uint64_t mask, const std::size_t base,
+                       std::size_t *positions, std::size_t &hits) noexcept
+{
+    while (mask != 0)
+    {
+        positions[hits++] = base + CountTrailingZeros(mask);
+        mask &= mask - 1;
+    }
+}
+
+/**
+ * Range comparison over independent lanes (one 512-bit register wide), the
+ * compiler vectorizes the comparison for the instruction set of the calling
+ * function, lanes without hits are skipped without writing positions
+ */
+template <class T>
+inline std::size_t InRangeLanes(const T *values, const std::size_t size,
+                                const T lo, const T hi,
+                                std::size_t *positions) noexcept
+{
+    constexpr std::size_t lanes = (64 / sizeof(T) > 0) ? 64 / sizeof(T) : 1;
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % lanes;
+    for (std::size_t i = 0; i < blocks; i += lanes)
+    {
+        unsigned char inRange[lanes];
+        unsigned char any = 0;
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            inRange[l] = (values[i + l] >= lo) & (values[i + l] <= hi);
+            any |= inRange[l];
+        }
+
+        if (any == 0)
+        {
+            continue;
+        }
+
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            positions[hits] = i + l;
+            hits += inRange[l];
+        }
+    }
+
+    for (std::size_t i = blocks; i < size; ++i)
+    {
+        positions[hits] = i;
+        hits += (values[i] >= lo) & (values[i] <= hi);
+    }
+    return hits;
+}
+
+#ifdef ADIOS_SIMD_X86
+// ordered comparisons are false for NaN, as in the scalar comparison
+
+template <class T>
+__attribute__((target("avx2"))) std::size_t
+InRangeLanesAVX2(const T *values, const std::size_t size, const T lo,
+                 const T hi, std::size_t *positions)
+{
+    return InRangeLanes<T>(values, size, lo, hi, positions);
+}
+
+template <class T>
+__attribute__((target("avx512f,avx512bw"))) std::size_t
+InRangeLanesAVX512(const T *values, const std::size_t size, const T lo,
+                   const T hi, std::size_t *positions)
+{
+    return InRangeLanes<T>(values, size, lo, hi, positions);
+}
+
+template <class T>
+inline std::size_t InRangeTail(const T *values, const std::size_t begin,
+                               const std::size_t end, const T lo, const T hi,
+                               std::size_t *positions,
+                               std::size_t hits) noexcept
+{
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        positions[hits] = i;
+        hits += (values[i] >= lo) & (values[i] <= hi);
+    }
+    return hits;
+}
+
+std::size_t InRangeSSE2(const double *values, const std::size_t size,
+                        const double lo, const double hi,
+                        std::size_t *positions)
+{
+    const __m128d low = _mm_set1_pd(lo);
+    const __m128d high = _mm_set1_pd(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 4;
+    for (std::size_t i = 0; i < blocks; i += 4)
+    {
+        const __m128d v0 = _mm_loadu_pd(&values[i]);
+        const __m128d v1 = _mm_loadu_pd(&values[i + 2]);
+        const int mask0 = _mm_movemask_pd(
+            _mm_and_pd(_mm_cmpge_pd(v0, low), _mm_cmple_pd(v0, high)));
+        const int mask1 = _mm_movemask_pd(
+            _mm_and_pd(_mm_cmpge_pd(v1, low), _mm_cmple_pd(v1, high)));
+        AppendMask(mask0 | (mask1 << 2), i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+
+std::size_t InRangeSSE2(const float *values, const std::size_t size,
+                        const float lo, const float hi,
+                        std::size_t *positions)
+{
+    const __m128 low = _mm_set1_ps(lo);
+    const __m128 high = _mm_set1_ps(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 8;
+    for (std::size_t i = 0; i < blocks; i += 8)
+    {
+        const __m128 v0 = _mm_loadu_ps(&values[i]);
+        const __m128 v1 = _mm_loadu_ps(&values[i + 4]);
+        const int mask0 = _mm_movemask_ps(
+            _mm_and_ps(_mm_cmpge_ps(v0, low), _mm_cmple_ps(v0, high)));
+        const int mask1 = _mm_movemask_ps(
+            _mm_and_ps(_mm_cmpge_ps(v1, low), _mm_cmple_ps(v1, high)));
+        AppendMask(mask0 | (mask1 << 4), i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+
+__attribute__((target("avx2"))) std::size_t
+InRangeAVX2(const double *values, const std::size_t size, const double lo,
+            const double hi, std::size_t *positions)
+{
+    const __m256d low = _mm256_set1_pd(lo);
+    const __m256d high = _mm256_set1_pd(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 8;
+    for (std::size_t i = 0; i < blocks; i += 8)
+    {
+        const __m256d v0 = _mm256_loadu_pd(&values[i]);
+        const __m256d v1 = _mm256_loadu_pd(&values[i + 4]);
+        const int mask0 = _mm256_movemask_pd(
+            _mm256_and_pd(_mm256_cmp_pd(v0, low, _CMP_GE_OQ),
+                          _mm256_cmp_pd(v0, high, _CMP_LE_OQ)));
+        const int mask1 = _mm256_movemask_pd(
+            _mm256_and_pd(_mm256_cmp_pd(v1, low, _CMP_GE_OQ),
+                          _mm256_cmp_pd(v1, high, _CMP_LE_OQ)));
+        AppendMask(mask0 | (mask1 << 4), i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+
+__attribute__((target("avx2"))) std::size_t
+InRangeAVX2(const float *values, const std::size_t size, const float lo,
+            const float hi, std::size_t *positions)
+{
+    const __m256 low = _mm256_set1_ps(lo);
+    const __m256 high = _mm256_set1_ps(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 16;
+    for (std::size_t i = 0; i < blocks; i += 16)
+    {
+        const __m256 v0 = _mm256_loadu_ps(&values[i]);
+        const __m256 v1 = _mm256_loadu_ps(&values[i + 8]);
+        const int mask0 = _mm256_movemask_ps(
+            _mm256_and_ps(_mm256_cmp_ps(v0, low, _CMP_GE_OQ),
+                          _mm256_cmp_ps(v0, high, _CMP_LE_OQ)));
+        const int mask1 = _mm256_movemask_ps(
+            _mm256_and_ps(_mm256_cmp_ps(v1, low, _CMP_GE_OQ),
+                          _mm256_cmp_ps(v1, high, _CMP_LE_OQ)));
+        AppendMask(mask0 | (mask1 << 8), i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+
+__attribute__((target("avx512f"))) std::size_t
+InRangeAVX512(const double *values, const std::size_t size, const double lo,
+              const double hi, std::size_t *positions)
+{
+    const __m512d low = _mm512_set1_pd(lo);
+    const __m512d high = _mm512_set1_pd(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 16;
+    for (std::size_t i = 0; i < blocks; i += 16)
+    {
+        const __m512d v0 = _mm512_loadu_pd(&values[i]);
+        const __m512d v1 = _mm512_loadu_pd(&values[i + 8]);
+        const __mmask8 mask0 = _mm512_mask_cmp_pd_mask(
+            _mm512_cmp_pd_mask(v0, low, _CMP_GE_OQ), v0, high, _CMP_LE_OQ);
+        const __mmask8 mask1 = _mm512_mask_cmp_pd_mask(
+            _mm512_cmp_pd_mask(v1, low, _CMP_GE_OQ), v1, high, _CMP_LE_OQ);
+        AppendMask(static_cast<std::uint64_t>(mask0) |
+                       (static_cast<std::uint64_t>(mask1) << 8),
+                   i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+
+__attribute__((target("avx512f"))) std::size_t
+InRangeAVX512(const float *values, const std::size_t size, const float lo,
+              const float hi, std::size_t *positions)
+{
+    const __m512 low = _mm512_set1_ps(lo);
+    const __m512 high = _mm512_set1_ps(hi);
+    std::size_t hits = 0;
+
+    const std::size_t blocks = size - size % 32;
+    for (std::size_t i = 0; i < blocks; i += 32)
+    {
+        const __m512 v0 = _mm512_loadu_ps(&values[i]);
+        const __m512 v1 = _mm512_loadu_ps(&values[i + 16]);
+        const __mmask16 mask0 = _mm512_mask_cmp_ps_mask(
+            _mm512_cmp_ps_mask(v0, low, _CMP_GE_OQ), v0, high, _CMP_LE_OQ);
+        const __mmask16 mask1 = _mm512_mask_cmp_ps_mask(
+            _mm512_cmp_ps_mask(v1, low, _CMP_GE_OQ), v1, high, _CMP_LE_OQ);
+        AppendMask(static_cast<std::uint64_t>(mask0) |
+                       (static_cast<std::uint64_t>(mask1) << 16),
+                   i, positions, hits);
+    }
+    return InRangeTail(values, blocks, size, lo, hi, positions, hits);
+}
+#endif
+
+/**
+ * Selects the range comparison kernel for the current CPU
+ * @return function pointer to kernel
+ */
+template <class T>
+InRangeKernel<T> GetInRangeKernel() noexcept
+{
+#ifdef ADIOS_SIMD_X86
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return InRangeLanesAVX512<T>;
+    case ISA::AVX2:
+        return InRangeLanesAVX2<T>;
+    default:
+        break;
+    }
+#endif
+    return InRangeLanes<T>;
+}
+
+#ifdef ADIOS_SIMD_X86
+template <>
+InRangeKernel<float> GetInRangeKernel<float>() noexcept
+{
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return InRangeAVX512;
+    case ISA::AVX2:
+        return InRangeAVX2;
+    default:
+        return InRangeSSE2;
+    }
+}
+
+template <>
+InRangeKernel<double> GetInRangeKernel<double>() noexcept
+{
+    switch (GetISA())
+    {
+    case ISA::AVX512:
+        return InRangeAVX512;
+    case ISA::AVX2:
+        return InRangeAVX2;
+    default:
+        return InRangeSSE2;
+    }
+}
+#endif
+
+} // end empty namespace
+
+#define define_minmax(T)                                                       \
+    void GetMinMax(const T *values, const std::size_t size, T &min, T &max,    \
+                   const unsigned int nthreads, Moments *moments) noexcept     \
+    {                                                                          \
+        static const MinMaxKernel<T, T> kernel = GetMinMaxKernel<T>();         \
+        static const MinMaxKernel<T, T> momentsKernel =                        \
+            GetLanesKernel<T, false, true>();                                  \
+        MinMaxThreads(values, size, nullptr, min, max, moments, nthreads,      \
+                      (moments == nullptr) ? kernel : momentsKernel);          \
+    }                                                                          \
+                                                                               \
+    void MemcpyMinMax(char *destination, const T *values,                      \
+                      const std::size_t size, T &min, T &max,                  \
+                      const unsigned int nthreads, Moments *moments) noexcept  \
+    {                                                                          \
+        static const MinMaxKernel<T, T> kernel =                               \
+            GetLanesKernel<T, true, false>();                                  \
+        static const MinMaxKernel<T, T> momentsKernel =                        \
+            GetLanesKernel<T, true, true>();                                   \
+        MinMaxThreads(values, size, destination, min, max, moments, nthreads,  \
+                      (moments == nullptr) ? kernel : momentsKernel);          \
+    }
+define_minmax(char)
+define_minmax(unsigned char)
+define_minmax(short)
+define_minmax(unsigned short)
+define_minmax(int)
+define_minmax(unsigned int)
+define_minmax(long int)
+define_minmax(unsigned long int)
+define_minmax(long long int)
+define_minmax(unsigned long long int)
+define_minmax(float)
+define_minmax(double)
+define_minmax(long double)
+#undef define_minmax
+
+#define define_minmax_complex(T)                                               \
+    void GetMinMax(const std::complex<T> *values, const std::size_t size,      \
+                   T &min, T &max, const unsigned int nthreads,                \
+                   Moments *moments) noexcept                                  \
+    {                                                                          \
+        static const MinMaxKernel<std::complex<T>, T> kernel =                 \
+            GetNormLanesKernel<T, false, false>();                             \
+        static const MinMaxKernel<std::complex<T>, T> momentsKernel =          \
+            GetNormLanesKernel<T, false, true>();                              \
+        MinMaxThreads(values, size, nullptr, min, max, moments, nthreads,      \
+                      (moments == nullptr) ? kernel : momentsKernel);          \
+        min = std::sqrt(min);                                                  \
+        max = std::sqrt(max);                                                  \
+    }                                                                          \
+                                                                               \
+    void MemcpyMinMax(char *destination, const std::complex<T> *values,        \
+                      const std::size_t size, T &min, T &max,                  \
+                      const unsigned int nthreads, Moments *moments) noexcept  \
+    {                                                                          \
+        static const MinMaxKernel<std::complex<T>, T> kernel =                 \
+            GetNormLanesKernel<T, true, false>();                              \
+        static const MinMaxKernel<std::complex<T>, T> momentsKernel =          \
+            GetNormLanesKernel<T, true, true>();                               \
+        MinMaxThreads(values, size, destination, min, max, moments, nthreads,  \
+                      (moments == nullptr) ? kernel : momentsKernel);          \
+        min = std::sqrt(min);                                                  \
+        max = std::sqrt(max);                                                  \
+    }
+define_minmax_complex(float)
+define_minmax_complex(double)
+define_minmax_complex(long double)
+#undef define_minmax_complex
+
+#define define_inrange(T)                                                      \
+    std::size_t GetInRange(const T *values, const std::size_t size,            \
+                           const T lo, const T hi,                             \
+                           std::size_t *positions) noexcept                    \
+    {                                                                          \
+        static const InRangeKernel<T> kernel = GetInRangeKernel<T>();          \
+        return kernel(values, size, lo, hi, positions);                        \
+    }
+define_inrange(char)
+define_inrange(unsigned char)
+define_inrange(short)
+define_inrange(unsigned short)
+define_inrange(int)
+define_inrange(unsigned int)
+define_inrange(long int)
+define_inrange(unsigned long int)
+define_inrange(long long int)
+define_inrange(unsigned long long int)
+define_inrange(float)
+define_inrange(double)
+define_inrange(long double)
+#undef define_inrange
+
+} // end namespace adios
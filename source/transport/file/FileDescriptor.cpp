@@ -9,8 +9,15 @@
  */
 
 /// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm>   //std::min
+#include <cerrno>      //errno
+#include <climits>     //IOV_MAX
+#include <cstdint>     //std::uintptr_t
+#include <cstdlib>     //posix_memalign, free
+#include <cstring>     //std::memcpy, std::memset
 #include <fcntl.h>     //open
 #include <ios>         //std::ios_base::failure
+#include <vector>
 #include <stddef.h>    // write output
 #include <sys/stat.h>  //open
 #include <sys/types.h> //open
@@ -24,9 +31,38 @@ namespace adios
 namespace transport
 {
 
-FileDescriptor::FileDescriptor(MPI_Comm mpiComm, const bool debugMode)
-: Transport("POSIX_IO", mpiComm, debugMode)
+FileDescriptor::FileDescriptor(MPI_Comm mpiComm, const bool debugMode,
+                               const bool directIO, const std::size_t blockSize)
+: Transport("POSIX_IO", mpiComm, debugMode),
+  m_BlockSize(blockSize > 0 ? blockSize : 1073741824), m_DirectIO(directIO),
+  m_AlignedBuffer(nullptr, std::free)
 {
+    if (m_DirectIO == true)
+    {
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        if (pageSize > 0)
+        {
+            m_Alignment = static_cast<std::size_t>(pageSize);
+            m_AlignedBufferSize -= m_AlignedBufferSize % m_Alignment;
+        }
+
+        // O_DIRECT blocks must stay aligned
+        m_BlockSize -= m_BlockSize % m_Alignment;
+        if (m_BlockSize == 0)
+        {
+            m_BlockSize = m_Alignment;
+        }
+
+        void *buffer = nullptr;
+        if (posix_memalign(&buffer, m_Alignment, m_AlignedBufferSize) == 0)
+        {
+            m_AlignedBuffer.reset(static_cast<char *>(buffer));
+        }
+        else
+        {
+            m_DirectIO = false; // buffered I/O
+        }
+    }
 }
 
 FileDescriptor::~FileDescriptor()
@@ -49,7 +85,20 @@ void FileDescriptor::Open(const std::string name, const std::string accessMode)
             m_Profiler.m_Timers[0].SetInitialTime();
         }
 
-        m_FileDescriptor = open(m_Name.c_str(), O_WRONLY | O_CREAT, 0777);
+        if (m_DirectIO == true)
+        {
+            m_FileDescriptor = open(
+                m_Name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0777);
+            m_IsDirect = (m_FileDescriptor != -1);
+        }
+
+        if (m_FileDescriptor == -1) // EINVAL if O_DIRECT is not supported
+        {
+            m_FileDescriptor =
+                open(m_Name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0777);
+        }
+        m_AlignedPosition = 0;
+        m_FileSize = 0;
 
         if (m_Profiler.m_IsActive == true)
         {
@@ -100,38 +149,127 @@ void FileDescriptor::Open(const std::string name, const std::string accessMode)
 
 void FileDescriptor::Write(const char *buffer, std::size_t size)
 {
-    if (m_Profiler.m_IsActive == true)
+    if (m_IsDirect == true)
     {
-        m_Profiler.m_Timers[1].SetInitialTime();
+        m_FileSize += size;
+        while (size > 0)
+        {
+            // aligned source at an aligned file offset, no staging copy
+            if (m_AlignedPosition == 0 &&
+                reinterpret_cast<std::uintptr_t>(buffer) % m_Alignment == 0 &&
+                size >= m_Alignment)
+            {
+                const std::size_t blocks = size - size % m_Alignment;
+                WriteAll(buffer, blocks);
+                buffer += blocks;
+                size -= blocks;
+                continue;
+            }
+
+            const std::size_t staged =
+                std::min(size, m_AlignedBufferSize - m_AlignedPosition);
+            std::memcpy(m_AlignedBuffer.get() + m_AlignedPosition, buffer,
+                        staged);
+            m_AlignedPosition += staged;
+            buffer += staged;
+            size -= staged;
+
+            if (m_AlignedPosition == m_AlignedBufferSize)
+            {
+                WriteAll(m_AlignedBuffer.get(), m_AlignedBufferSize);
+                m_AlignedPosition = 0;
+            }
+        }
+        return;
     }
 
-    auto writtenSize = write(m_FileDescriptor, buffer, size);
+    if (m_AlignedPosition > 0) // O_DIRECT was turned off while staging
+    {
+        FlushAligned();
+    }
+
+    WriteAll(buffer, size);
+}
+
+void FileDescriptor::WriteV(const iovec *iov, const int iovcnt)
+{
+    if (m_IsDirect == true || m_AlignedPosition > 0) // through staging
+    {
+        Transport::WriteV(iov, iovcnt);
+        return;
+    }
 
     if (m_Profiler.m_IsActive == true)
     {
-        m_Profiler.m_Timers[1].SetTime();
+        m_Profiler.m_Timers[1].SetInitialTime();
     }
 
-    if (m_DebugMode == true)
+    // writev may write less than requested (above 2GB on Linux), the pending
+    // buffers are kept in a copy that advances past written bytes
+    std::vector<iovec> pending(iov, iov + iovcnt);
+    std::size_t first = 0;
+    while (first < pending.size())
     {
-        if (writtenSize == -1)
+        if (pending[first].iov_len == 0) // a 0 return is then no progress
         {
-            throw std::ios_base::failure("ERROR: couldn't write to file " +
-                                         m_Name + ", in call to POSIX write\n");
+            ++first;
+            continue;
+        }
+
+        const int count =
+            static_cast<int>(std::min<std::size_t>(pending.size() - first,
+                                                   IOV_MAX));
+        auto writtenSize = writev(m_FileDescriptor, &pending[first], count);
+
+        if (writtenSize == -1 && errno == EINTR)
+        {
+            continue;
         }
 
-        if (static_cast<std::size_t>(writtenSize) != size)
+        if (writtenSize <= 0) // error, or no progress e.g. on a full disk
         {
-            throw std::ios_base::failure(
-                "ERROR: written size + " + std::to_string(writtenSize) +
-                " is not equal to intended size " + std::to_string(size) +
-                " in file " + m_Name + ", in call to POSIX write\n");
+            if (m_DebugMode == true)
+            {
+                throw std::ios_base::failure(
+                    "ERROR: couldn't write to file " + m_Name +
+                    ", in call to POSIX writev\n");
+            }
+            break;
+        }
+
+        std::size_t written = static_cast<std::size_t>(writtenSize);
+        if (m_Profiler.m_IsActive == true)
+        {
+            m_Profiler.m_TotalBytes[0] += written;
+        }
+        while (first < pending.size() && written >= pending[first].iov_len)
+        {
+            written -= pending[first].iov_len;
+            ++first;
+        }
+        if (written > 0) // partially written buffer
+        {
+            pending[first].iov_base =
+                static_cast<char *>(pending[first].iov_base) + written;
+            pending[first].iov_len -= written;
         }
     }
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[1].SetTime();
+    }
 }
 
+bool FileDescriptor::IsDirectIO() const noexcept { return m_IsDirect; }
+
 void FileDescriptor::Close()
 {
+    if (m_IsDirect == true || m_AlignedPosition > 0)
+    {
+        FlushAligned();
+    }
+
     if (m_Profiler.m_IsActive == true)
     {
         m_Profiler.m_Timers[2].SetInitialTime();
@@ -154,6 +292,96 @@ void FileDescriptor::Close()
     }
 
     m_IsOpen = false;
+    m_IsDirect = false;
+}
+
+// PRIVATE
+void FileDescriptor::WriteAll(const char *buffer, std::size_t size)
+{
+    while (size > 0)
+    {
+        const std::size_t blockSize = std::min(size, m_BlockSize);
+
+        if (m_Profiler.m_IsActive == true)
+        {
+            m_Profiler.m_Timers[1].SetInitialTime();
+        }
+
+        auto writtenSize = write(m_FileDescriptor, buffer, blockSize);
+
+        if (m_Profiler.m_IsActive == true)
+        {
+            m_Profiler.m_Timers[1].SetTime();
+        }
+
+        if (writtenSize == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // file system accepted O_DIRECT at open, but not the write
+            if (errno == EINVAL && m_IsDirect == true)
+            {
+                const int flags = fcntl(m_FileDescriptor, F_GETFL);
+                if (flags != -1 &&
+                    fcntl(m_FileDescriptor, F_SETFL, flags & ~O_DIRECT) != -1)
+                {
+                    m_IsDirect = false;
+                    continue;
+                }
+            }
+        }
+
+        if (writtenSize <= 0) // error, or no progress e.g. on a full disk
+        {
+            if (m_DebugMode == true)
+            {
+                throw std::ios_base::failure("ERROR: couldn't write to file " +
+                                             m_Name +
+                                             ", in call to POSIX write\n");
+            }
+            return;
+        }
+
+        // a short write continues from the first byte not written
+        buffer += writtenSize;
+        size -= static_cast<std::size_t>(writtenSize);
+
+        if (m_Profiler.m_IsActive == true)
+        {
+            m_Profiler.m_TotalBytes[0] +=
+                static_cast<unsigned long long int>(writtenSize);
+        }
+    }
+}
+
+void FileDescriptor::FlushAligned()
+{
+    if (m_AlignedPosition > 0)
+    {
+        std::size_t size = m_AlignedPosition;
+        if (m_IsDirect == true) // pad the tail to a full block
+        {
+            const std::size_t padding =
+                (m_Alignment - size % m_Alignment) % m_Alignment;
+            std::memset(m_AlignedBuffer.get() + size, 0, padding);
+            size += padding;
+        }
+        WriteAll(m_AlignedBuffer.get(), size);
+        m_AlignedPosition = 0;
+    }
+
+    if (ftruncate(m_FileDescriptor, static_cast<off_t>(m_FileSize)) == -1)
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::ios_base::failure("ERROR: couldn't truncate file " +
+                                         m_Name + " to its written size, "
+                                         "in call to POSIX ftruncate\n");
+        }
+    }
 }
 
 } // end namespace transport
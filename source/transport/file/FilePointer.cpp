@@ -96,6 +96,7 @@ void FilePointer::Flush() { fflush(m_File); }
 void FilePointer::Close()
 {
     fclose(m_File);
+    m_File = nullptr; // not closed again by the destructor
 
     m_IsOpen = false;
 }
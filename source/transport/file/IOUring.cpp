@@ -0,0 +1,473 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * IOUring.cpp
+ *
+ *  Created on: Apr 28, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::min
+#include <cerrno>    //errno
+#include <cstdlib>   //posix_memalign, free
+#include <cstring>   //std::memcpy, std::memset
+#include <fcntl.h>   //open
+#include <ios>       //std::ios_base::failure
+#include <new>       //std::bad_alloc
+#include <stdexcept> //std::invalid_argument
+#include <linux/io_uring.h>
+#include <sys/mman.h>    //mmap
+#include <sys/stat.h>    //open
+#include <sys/syscall.h> //SYS_io_uring_*
+#include <sys/types.h>   //open
+#include <sys/uio.h>     //iovec
+#include <unistd.h>      //pwrite, close
+/// \endcond
+
+#include "transport/file/IOUring.h"
+
+namespace adios
+{
+namespace transport
+{
+
+IOUring::IOUring(MPI_Comm mpiComm, const bool debugMode,
+                 const unsigned int queueDepth, const std::size_t blockSize)
+: Transport("io_uring", mpiComm, debugMode),
+  m_QueueDepth(queueDepth > 0 ? queueDepth : 1),
+  m_BlockSize(blockSize > 0 ? blockSize : 1048576),
+  m_Blocks(nullptr, std::free)
+{
+    void *blocks = nullptr;
+    if (posix_memalign(&blocks, 4096, m_QueueDepth * m_BlockSize) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    m_Blocks.reset(static_cast<char *>(blocks));
+
+    m_Block.resize(m_QueueDepth);
+    m_FreeBlocks.reserve(m_QueueDepth);
+    for (unsigned int b = 0; b < m_QueueDepth; ++b)
+    {
+        m_Block[b].Data = m_Blocks.get() + b * m_BlockSize;
+        m_FreeBlocks.push_back(m_QueueDepth - 1 - b); // first block on top
+    }
+
+    InitRing();
+}
+
+IOUring::~IOUring()
+{
+    if (m_FileDescriptor != -1)
+    {
+        try
+        {
+            WaitAll();
+        }
+        catch (...)
+        {
+        }
+        close(m_FileDescriptor);
+    }
+    FreeRing();
+}
+
+void IOUring::Open(const std::string name, const std::string accessMode)
+{
+    m_Name = name;
+    m_AccessMode = accessMode;
+    m_Offset = 0;
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[0].SetInitialTime();
+    }
+
+    if (accessMode == "w" || accessMode == "write")
+    {
+        m_FileDescriptor =
+            open(m_Name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0777);
+    }
+    else if (accessMode == "a" || accessMode == "append")
+    {
+        // writes carry explicit offsets, start at the end of file
+        m_FileDescriptor = open(m_Name.c_str(), O_WRONLY);
+        if (m_FileDescriptor != -1)
+        {
+            const off_t end = lseek(m_FileDescriptor, 0, SEEK_END);
+            m_Offset = end > 0 ? static_cast<std::uint64_t>(end) : 0;
+        }
+    }
+    else if (m_DebugMode == true)
+    {
+        throw std::invalid_argument("ERROR: io_uring transport only supports "
+                                    "w or a access modes, in call to Open " +
+                                    m_Name + "\n");
+    }
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[0].SetTime();
+    }
+
+    if (m_DebugMode == true)
+    {
+        if (m_FileDescriptor == -1)
+        {
+            throw std::ios_base::failure(
+                "ERROR: couldn't open file " + m_Name +
+                ", from call to Open in io_uring transport using "
+                "POSIX open. Does file exists?\n");
+        }
+    }
+
+    m_IsOpen = (m_FileDescriptor != -1);
+}
+
+void IOUring::Write(const char *buffer, std::size_t size)
+{
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[1].SetInitialTime();
+    }
+
+    if (m_Ring == -1)
+    {
+        WriteSync(buffer, size);
+    }
+    else
+    {
+        while (size > 0)
+        {
+            const unsigned int index = AcquireBlock();
+            Block &block = m_Block[index];
+            block.Size = std::min(size, m_BlockSize);
+            block.Written = 0;
+            block.Offset = m_Offset;
+            std::memcpy(block.Data, buffer, block.Size);
+            Submit(index);
+
+            m_Offset += block.Size;
+            buffer += block.Size;
+            size -= block.Size;
+        }
+        Enter(0); // start the tail, don't wait
+    }
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[1].SetTime();
+    }
+}
+
+void IOUring::Flush() { WaitAll(); }
+
+void IOUring::Close()
+{
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[2].SetInitialTime();
+    }
+
+    WaitAll();
+    const int status = close(m_FileDescriptor);
+    m_FileDescriptor = -1;
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[2].SetTime();
+    }
+
+    if (m_DebugMode == true)
+    {
+        if (status == -1)
+        {
+            throw std::ios_base::failure("ERROR: couldn't close file " +
+                                         m_Name + ", in call to POSIX close\n");
+        }
+    }
+
+    m_IsOpen = false;
+}
+
+bool IOUring::IsRing() const noexcept { return m_Ring != -1; }
+
+// PRIVATE
+void IOUring::InitRing()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_Ring = static_cast<int>(
+        syscall(__NR_io_uring_setup, m_QueueDepth, &params));
+    if (m_Ring == -1) // ENOSYS, or disabled, blocking writes
+    {
+        return;
+    }
+
+    m_SQRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_CQRingSize =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        m_SQRingSize = m_CQRingSize = std::max(m_SQRingSize, m_CQRingSize);
+    }
+
+    m_SQRing = mmap(nullptr, m_SQRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_Ring, IORING_OFF_SQ_RING);
+    if (m_SQRing == MAP_FAILED)
+    {
+        m_SQRing = nullptr;
+        FreeRing();
+        return;
+    }
+
+    if (singleMap)
+    {
+        m_CQRing = m_SQRing;
+    }
+    else
+    {
+        m_CQRing = mmap(nullptr, m_CQRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_Ring, IORING_OFF_CQ_RING);
+        if (m_CQRing == MAP_FAILED)
+        {
+            m_CQRing = nullptr;
+            FreeRing();
+            return;
+        }
+    }
+
+    m_SQEsSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_SQEs = mmap(nullptr, m_SQEsSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, m_Ring, IORING_OFF_SQES);
+    if (m_SQEs == MAP_FAILED)
+    {
+        m_SQEs = nullptr;
+        FreeRing();
+        return;
+    }
+
+    char *sq = static_cast<char *>(m_SQRing);
+    m_SQTail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    m_SQMask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    m_SQArray = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(m_CQRing);
+    m_CQHead = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    m_CQTail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    m_CQMask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    m_CQEs = cq + params.cq_off.cqes;
+
+    // registered blocks avoid per write page pinning, optional
+    std::vector<iovec> iov(m_QueueDepth);
+    for (unsigned int b = 0; b < m_QueueDepth; ++b)
+    {
+        iov[b].iov_base = m_Block[b].Data;
+        iov[b].iov_len = m_BlockSize;
+    }
+    m_FixedBuffers = syscall(__NR_io_uring_register, m_Ring,
+                             IORING_REGISTER_BUFFERS, iov.data(),
+                             m_QueueDepth) == 0;
+
+    // IORING_OP_WRITE needs Linux 5.6, blocking writes before
+    if (m_FixedBuffers == false && IsOpSupported(IORING_OP_WRITE) == false)
+    {
+        FreeRing();
+    }
+}
+
+bool IOUring::IsOpSupported(const unsigned int op) const
+{
+    const unsigned int maxOps = 256;
+    std::vector<char> buffer(sizeof(io_uring_probe) +
+                             maxOps * sizeof(io_uring_probe_op));
+    io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+
+    // IORING_REGISTER_PROBE fails with EINVAL before Linux 5.6
+    if (syscall(__NR_io_uring_register, m_Ring, IORING_REGISTER_PROBE, probe,
+                maxOps) != 0)
+    {
+        return false;
+    }
+    return op < probe->ops_len &&
+           (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+void IOUring::FreeRing() noexcept
+{
+    if (m_SQEs != nullptr)
+    {
+        munmap(m_SQEs, m_SQEsSize);
+        m_SQEs = nullptr;
+    }
+    if (m_CQRing != nullptr && m_CQRing != m_SQRing)
+    {
+        munmap(m_CQRing, m_CQRingSize);
+    }
+    m_CQRing = nullptr;
+    if (m_SQRing != nullptr)
+    {
+        munmap(m_SQRing, m_SQRingSize);
+        m_SQRing = nullptr;
+    }
+    if (m_Ring != -1)
+    {
+        close(m_Ring); // also unregisters buffers
+        m_Ring = -1;
+    }
+}
+
+void IOUring::Submit(const unsigned int index)
+{
+    const Block &block = m_Block[index];
+
+    // single producer, the kernel only reads the tail
+    const unsigned int tail = *m_SQTail;
+    const unsigned int slot = tail & *m_SQMask;
+    io_uring_sqe &sqe = static_cast<io_uring_sqe *>(m_SQEs)[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = m_FixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.fd = m_FileDescriptor;
+    sqe.off = block.Offset + block.Written;
+    sqe.addr = reinterpret_cast<std::uint64_t>(block.Data + block.Written);
+    sqe.len = static_cast<std::uint32_t>(block.Size - block.Written);
+    sqe.buf_index = static_cast<std::uint16_t>(m_FixedBuffers ? index : 0);
+    sqe.user_data = index;
+
+    m_SQArray[slot] = slot;
+    __atomic_store_n(m_SQTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_ToSubmit;
+}
+
+void IOUring::Enter(const unsigned int minComplete)
+{
+    while (true)
+    {
+        const unsigned int flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        const long result = syscall(__NR_io_uring_enter, m_Ring, m_ToSubmit,
+                                    minComplete, flags, nullptr, 0);
+        if (result >= 0)
+        {
+            m_ToSubmit -= static_cast<unsigned int>(result);
+            break;
+        }
+
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            throw std::ios_base::failure(
+                "ERROR: io_uring_enter failed writing file " + m_Name +
+                ", in io_uring transport\n");
+        }
+        if (minComplete == 0)
+        {
+            break; // retried by the next Enter
+        }
+    }
+    Reap();
+}
+
+void IOUring::Reap()
+{
+    unsigned int head = *m_CQHead;
+    const unsigned int tail = __atomic_load_n(m_CQTail, __ATOMIC_ACQUIRE);
+    bool resubmit = false;
+
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe &cqe =
+            static_cast<io_uring_cqe *>(m_CQEs)[head & *m_CQMask];
+        const unsigned int index = static_cast<unsigned int>(cqe.user_data);
+        Block &block = m_Block[index];
+
+        // 0 bytes for a non-empty write is no progress, e.g. a full disk
+        if (cqe.res == 0 ||
+            (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN))
+        {
+            __atomic_store_n(m_CQHead, head + 1, __ATOMIC_RELEASE);
+            m_FreeBlocks.push_back(index);
+            if (m_DebugMode == true)
+            {
+                throw std::ios_base::failure(
+                    "ERROR: couldn't write to file " + m_Name +
+                    ", in io_uring transport: " +
+                    (cqe.res == 0 ? "no bytes written"
+                                  : std::strerror(-cqe.res)) +
+                    "\n");
+            }
+            continue;
+        }
+
+        if (cqe.res > 0)
+        {
+            block.Written += static_cast<std::size_t>(cqe.res);
+        }
+
+        if (block.Written < block.Size) // short write or retry
+        {
+            Submit(index);
+            resubmit = true;
+        }
+        else
+        {
+            m_FreeBlocks.push_back(index);
+        }
+    }
+    __atomic_store_n(m_CQHead, head, __ATOMIC_RELEASE);
+
+    if (resubmit)
+    {
+        Enter(0);
+    }
+}
+
+unsigned int IOUring::AcquireBlock()
+{
+    while (m_FreeBlocks.empty())
+    {
+        Enter(1);
+    }
+    const unsigned int index = m_FreeBlocks.back();
+    m_FreeBlocks.pop_back();
+    return index;
+}
+
+void IOUring::WaitAll()
+{
+    while (m_Ring != -1 && m_FreeBlocks.size() < m_QueueDepth)
+    {
+        Enter(1);
+    }
+}
+
+void IOUring::WriteSync(const char *buffer, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t written = pwrite(m_FileDescriptor, buffer, size,
+                                       static_cast<off_t>(m_Offset));
+        if (written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0) // error, or no progress e.g. on a full disk
+        {
+            if (m_DebugMode == true)
+            {
+                throw std::ios_base::failure("ERROR: couldn't write to file " +
+                                             m_Name +
+                                             ", in call to POSIX pwrite\n");
+            }
+            return;
+        }
+        buffer += written;
+        size -= static_cast<std::size_t>(written);
+        m_Offset += static_cast<std::uint64_t>(written);
+    }
+}
+
+} // end namespace transport
+} // end namespace adios
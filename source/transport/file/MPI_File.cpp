@@ -0,0 +1,219 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * MPI_File.cpp
+ *
+ *  Created on: Apr 29, 2017
+ *      Author: wfg
+ */
+
+/// \cond EXCLUDE_FROM_DOXYGEN
+#include <algorithm> //std::min
+#include <ios>       //std::ios_base::failure
+#include <stdexcept> //std::invalid_argument
+/// \endcond
+
+#include "transport/file/MPI_File.h"
+
+namespace adios
+{
+namespace transport
+{
+
+MPIFile::MPIFile(MPI_Comm mpiComm, const bool debugMode,
+                 const std::map<std::string, std::string> &hints)
+: Transport("MPI_File", mpiComm, debugMode), m_Hints(hints)
+{
+}
+
+MPIFile::~MPIFile()
+{
+    if (m_IsOpen == true)
+    {
+        MPI_File_close(&m_MPIFile);
+    }
+}
+
+void MPIFile::Open(const std::string name, const std::string accessMode)
+{
+    m_Name = name;
+    m_AccessMode = accessMode;
+    m_Position = 0;
+
+    int amode = 0;
+    if (accessMode == "w" || accessMode == "write")
+    {
+        amode = MPI_MODE_WRONLY | MPI_MODE_CREATE;
+    }
+    else if (accessMode == "a" || accessMode == "append")
+    {
+        amode = MPI_MODE_WRONLY;
+    }
+    else if (accessMode == "r" || accessMode == "read")
+    {
+        amode = MPI_MODE_RDONLY;
+    }
+    else if (m_DebugMode == true)
+    {
+        throw std::invalid_argument("ERROR: access mode " + accessMode +
+                                    " not supported in MPI_File transport, "
+                                    "in call to Open " +
+                                    m_Name + "\n");
+    }
+
+    MPI_Info info = MPI_INFO_NULL;
+    if (m_Hints.empty() == false)
+    {
+        MPI_Info_create(&info);
+        for (const auto &hint : m_Hints)
+        {
+            MPI_Info_set(info, const_cast<char *>(hint.first.c_str()),
+                         const_cast<char *>(hint.second.c_str()));
+        }
+    }
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[0].SetInitialTime();
+    }
+
+    const int status = MPI_File_open(
+        m_MPIComm, const_cast<char *>(m_Name.c_str()), amode, info, &m_MPIFile);
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[0].SetTime();
+    }
+
+    if (info != MPI_INFO_NULL)
+    {
+        MPI_Info_free(&info);
+    }
+
+    if (status != MPI_SUCCESS)
+    {
+        if (m_DebugMode == true)
+        {
+            throw std::ios_base::failure(
+                "ERROR: couldn't open file " + m_Name +
+                ", from call to Open in MPI_File transport using "
+                "MPI_File_open\n");
+        }
+        return;
+    }
+
+    if (amode == MPI_MODE_WRONLY) // append after the current end
+    {
+        MPI_Offset size = 0;
+        MPI_File_get_size(m_MPIFile, &size);
+        m_Position = static_cast<std::uint64_t>(size);
+    }
+    else if ((amode & MPI_MODE_CREATE) != 0) // collective, drop old contents
+    {
+        if (MPI_File_set_size(m_MPIFile, 0) != MPI_SUCCESS)
+        {
+            MPI_File_close(&m_MPIFile);
+            if (m_DebugMode == true)
+            {
+                throw std::ios_base::failure(
+                    "ERROR: couldn't truncate file " + m_Name +
+                    ", from call to Open in MPI_File transport using "
+                    "MPI_File_set_size\n");
+            }
+            return;
+        }
+    }
+    m_IsOpen = true;
+}
+
+void MPIFile::Write(const char *buffer, std::size_t size)
+{
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[1].SetInitialTime();
+    }
+
+    unsigned long long int rankSize = size;
+    unsigned long long int offset = 0;
+    MPI_Exscan(&rankSize, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+               m_MPIComm);
+    if (m_RankMPI == 0) // undefined in first rank
+    {
+        offset = 0;
+    }
+
+    unsigned long long int totalSize = 0;
+    unsigned long long int maxSize = 0;
+    MPI_Allreduce(&rankSize, &totalSize, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                  m_MPIComm);
+    MPI_Allreduce(&rankSize, &maxSize, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX,
+                  m_MPIComm);
+
+    // int count limit, every rank takes part in every collective call
+    const std::size_t maxPieceSize = 1073741824;
+    for (std::size_t position = 0; position < maxSize;
+         position += maxPieceSize)
+    {
+        const int pieceSize = static_cast<int>(
+            (position < size) ? std::min(maxPieceSize, size - position) : 0);
+        const MPI_Offset fileOffset =
+            static_cast<MPI_Offset>(m_Position + offset + position);
+
+        MPI_Status status;
+        const int result = MPI_File_write_at_all(
+            m_MPIFile, fileOffset,
+            const_cast<char *>(pieceSize > 0 ? buffer + position : buffer),
+            pieceSize, MPI_BYTE, &status);
+
+        if (m_DebugMode == true)
+        {
+            if (result != MPI_SUCCESS)
+            {
+                throw std::ios_base::failure(
+                    "ERROR: couldn't write to file " + m_Name +
+                    ", in call to MPI_File_write_at_all\n");
+            }
+        }
+    }
+
+    m_Position += totalSize;
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[1].SetTime();
+        m_Profiler.m_TotalBytes[0] += size;
+    }
+}
+
+void MPIFile::Flush() { MPI_File_sync(m_MPIFile); }
+
+void MPIFile::Close()
+{
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[2].SetInitialTime();
+    }
+
+    const int status = MPI_File_close(&m_MPIFile);
+
+    if (m_Profiler.m_IsActive == true)
+    {
+        m_Profiler.m_Timers[2].SetTime();
+    }
+
+    if (m_DebugMode == true)
+    {
+        if (status != MPI_SUCCESS)
+        {
+            throw std::ios_base::failure("ERROR: couldn't close file " +
+                                         m_Name +
+                                         ", in call to MPI_File_close\n");
+        }
+    }
+
+    m_IsOpen = false;
+}
+
+} // end namespace transport
+} // end namespace adios
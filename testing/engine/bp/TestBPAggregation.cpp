@@ -0,0 +1,338 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * TestBPAggregation.cpp
+ *
+ * Every rank writes a block of different size of a global array, even ranks
+ * also a second array, over several steps. The file is first written with
+ * more steps, rewriting it must shrink the first data file. Checks that the
+ * expected number of data files exist, then every rank reads both arrays back.
+ * Returns nonzero on any rank if a data file is missing, not truncated or any
+ * value read back is wrong.
+ *
+ * shmat is replaced in this executable to check that node aggregation goes
+ * through shared memory, and to make it fail on the rank given by the
+ * TEST_FAIL_SHMAT_RANK environment variable so all ranks fall back to MPI.
+ *
+ * Usage: TestBPAggregation file.bp subfiles transport [method]
+ * subfiles: expected data files, node for one per node
+ * transport: File transport parameter, e.g. library=POSIX
+ * method: optional BPFileWriter parameter, e.g. Aggregation=2
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <mpi.h>
+
+#include "ADIOS_CPP.h"
+
+namespace
+{
+
+int rankMPI = -1;           ///< set after MPI_Init
+int failShmatRank = -1;     ///< rank whose shmat fails, -1: none
+std::size_t shmatCalls = 0; ///< by the current rank
+
+} // end anonymous namespace
+
+extern "C" void *shmat(int shmid, const void *shmaddr, int shmflg)
+{
+    ++shmatCalls;
+    if (rankMPI != -1 && rankMPI == failShmatRank)
+    {
+        errno = ENOMEM;
+        return reinterpret_cast<void *>(-1);
+    }
+    return reinterpret_cast<void *>(
+        syscall(SYS_shmat, shmid, shmaddr, shmflg));
+}
+
+namespace
+{
+
+const std::size_t steps = 3;
+const std::size_t evenCount = 50; // second array block size
+
+std::size_t BlockCount(const int rank)
+{
+    return 1000 + 100 * static_cast<std::size_t>(rank);
+}
+
+std::size_t BlockOffset(const int rank)
+{
+    std::size_t offset = 0;
+    for (int r = 0; r < rank; ++r)
+    {
+        offset += BlockCount(r);
+    }
+    return offset;
+}
+
+double Value(const std::size_t step, const std::size_t i)
+{
+    return static_cast<double>(step * 1000000 + i);
+}
+
+void Write(const std::string fileName, const std::string transport,
+           const std::string method, const std::size_t writeSteps)
+{
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    adios::ADIOS adios(MPI_COMM_WORLD, adios::Verbose::WARN, true);
+
+    const std::size_t count = BlockCount(rank);
+    const std::size_t offset = BlockOffset(rank);
+    adios::Variable<double> &ioValues = adios.DefineVariable<double>(
+        "values", adios::Dims{count}, adios::Dims{BlockOffset(size)},
+        adios::Dims{offset});
+
+    const std::size_t evens = static_cast<std::size_t>(size + 1) / 2;
+    const std::size_t evenOffset = static_cast<std::size_t>(rank / 2);
+    adios::Variable<int> &ioEvens = adios.DefineVariable<int>(
+        "evens", adios::Dims{evenCount}, adios::Dims{evens * evenCount},
+        adios::Dims{evenOffset * evenCount});
+
+    adios::Method &bpWriterSettings = adios.DeclareMethod("Writer");
+    if (method.empty() == false)
+    {
+        bpWriterSettings.SetParameters(method);
+    }
+    bpWriterSettings.AddTransport("File", transport);
+
+    auto bpWriter = adios.Open(fileName, "w", bpWriterSettings);
+    if (bpWriter == nullptr)
+    {
+        throw std::ios_base::failure(
+            "ERROR: couldn't create bpWriter at Open\n");
+    }
+
+    std::vector<double> values(count);
+    const std::vector<int> evenValues(evenCount, rank);
+    for (std::size_t step = 0; step < writeSteps; ++step)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            values[i] = Value(step, offset + i);
+        }
+        bpWriter->Write<double>(ioValues, values.data());
+        if (rank % 2 == 0)
+        {
+            bpWriter->Write<int>(ioEvens, evenValues.data());
+        }
+        bpWriter->Advance();
+    }
+    bpWriter->Close();
+}
+
+/** @return number of subfiles expected for the subfiles argument */
+int ExpectedSubFiles(const std::string subFiles)
+{
+    if (subFiles != "node")
+    {
+        return std::stoi(subFiles);
+    }
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm nodeComm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
+                        MPI_INFO_NULL, &nodeComm);
+    int nodeRank;
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_free(&nodeComm);
+
+    int leader = (nodeRank == 0) ? 1 : 0;
+    int nodes = 0;
+    MPI_Allreduce(&leader, &nodes, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    return nodes;
+}
+
+std::string DataFileName(const std::string fileName, const int index)
+{
+    return fileName + "/" + fileName + "." + std::to_string(index);
+}
+
+/** @return size in bytes, -1 if the file can't be opened */
+long long int FileSize(const std::string fileName)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    return file.good() ? static_cast<long long int>(file.tellg()) : -1;
+}
+
+/** @return number of missing or unexpected data files */
+std::size_t CheckSubFiles(const std::string fileName, const int subFiles)
+{
+    std::size_t errors = 0;
+    for (int index = 0; index <= subFiles; ++index)
+    {
+        const std::string dataFile = DataFileName(fileName, index);
+        const bool exists = std::ifstream(dataFile).good();
+        if (exists != (index < subFiles))
+        {
+            std::cout << "ERROR: data file " << dataFile
+                      << (exists ? " not expected\n" : " missing\n");
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+/** Every rank reads all blocks, @return number of errors */
+std::size_t Read(const std::string fileName)
+{
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    adios::ADIOS adios(MPI_COMM_SELF, adios::Verbose::WARN, true);
+    adios::Method &bpReaderSettings = adios.DeclareMethod("Reader");
+    bpReaderSettings.AddTransport("File");
+
+    auto bpReader = adios.Open(fileName, "r", bpReaderSettings);
+    if (bpReader == nullptr)
+    {
+        throw std::ios_base::failure(
+            "ERROR: couldn't create bpReader at Open\n");
+    }
+
+    const std::size_t total = BlockOffset(size);
+    const std::size_t evens = static_cast<std::size_t>(size + 1) / 2;
+    std::size_t errors = 0;
+    for (std::size_t step = 0; step < steps; ++step)
+    {
+        adios::Variable<double> *ioValues =
+            bpReader->InquireVariableDouble("values", false);
+        adios::Variable<int> *ioEvens =
+            bpReader->InquireVariableInt("evens", false);
+        if (ioValues == nullptr || ioEvens == nullptr)
+        {
+            throw std::invalid_argument("ERROR: variables not found in " +
+                                        fileName + "\n");
+        }
+
+        std::vector<double> values(total);
+        ioValues->SetSelection(adios::SelectionBoundingBox({0}, {total}));
+        bpReader->Read<double>(*ioValues, values.data());
+        for (std::size_t i = 0; i < total; ++i)
+        {
+            errors += (values[i] != Value(step, i));
+        }
+
+        std::vector<int> evenValues(evens * evenCount);
+        ioEvens->SetSelection(
+            adios::SelectionBoundingBox({0}, {evens * evenCount}));
+        bpReader->Read<int>(*ioEvens, evenValues.data());
+        for (std::size_t i = 0; i < evenValues.size(); ++i)
+        {
+            errors += (evenValues[i] != static_cast<int>(i / evenCount) * 2);
+        }
+
+        bpReader->Advance();
+    }
+    bpReader->Close();
+    return errors;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    rankMPI = rank;
+    const char *failRank = std::getenv("TEST_FAIL_SHMAT_RANK");
+    if (failRank != nullptr)
+    {
+        failShmatRank = std::atoi(failRank);
+    }
+
+    unsigned long long int errors = 0;
+    if (argc < 4)
+    {
+        if (rank == 0)
+        {
+            std::cout << "Usage: TestBPAggregation file.bp subfiles "
+                         "transport [method]\n";
+        }
+        ++errors;
+    }
+    else
+    {
+        const std::string fileName(argv[1]);
+        const bool isNode = (std::string(argv[2]) == "node");
+        try
+        {
+            const std::string method((argc > 4) ? argv[4] : "");
+            Write(fileName, argv[3], method, 2 * steps);
+            MPI_Barrier(MPI_COMM_WORLD);
+            const long long int largerSize =
+                FileSize(DataFileName(fileName, 0));
+
+            shmatCalls = 0;
+            Write(fileName, argv[3], method, steps);
+            if (isNode == true && shmatCalls == 0)
+            {
+                std::cout << "ERROR: rank " << rank
+                          << " didn't attach node memory\n";
+                ++errors;
+            }
+            const int subFiles = ExpectedSubFiles(argv[2]);
+            MPI_Barrier(MPI_COMM_WORLD); // all files closed
+            if (rank == 0)
+            {
+                errors += CheckSubFiles(fileName, subFiles);
+                if (FileSize(DataFileName(fileName, 0)) >= largerSize)
+                {
+                    std::cout << "ERROR: " << DataFileName(fileName, 0)
+                              << " not truncated when rewritten\n";
+                    ++errors;
+                }
+            }
+            errors += Read(fileName);
+        }
+        catch (std::invalid_argument &e)
+        {
+            std::cout << "Invalid argument exception, STOPPING PROGRAM\n";
+            std::cout << e.what() << "\n";
+            ++errors;
+        }
+        catch (std::ios_base::failure &e)
+        {
+            std::cout << "System exception, STOPPING PROGRAM\n";
+            std::cout << e.what() << "\n";
+            ++errors;
+        }
+        catch (std::exception &e)
+        {
+            std::cout << "Exception, STOPPING PROGRAM\n";
+            std::cout << e.what() << "\n";
+            ++errors;
+        }
+    }
+
+    unsigned long long int totalErrors = 0;
+    MPI_Allreduce(&errors, &totalErrors, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                  MPI_COMM_WORLD);
+    if (rank == 0 && totalErrors > 0)
+    {
+        std::cout << totalErrors << " errors in " << argv[0] << "\n";
+    }
+
+    MPI_Finalize();
+    return (totalErrors > 0) ? 1 : 0;
+}
@@ -0,0 +1,347 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * TestSIMD.cpp
+ *
+ * Compares GetMinMax, MemcpyMinMax and GetInRange against scalar loops for
+ * every supported type, all sizes up to two unrolled 512-bit blocks plus one,
+ * unaligned starts, NaN, infinity and integer limits. Runs the kernels of the
+ * instruction set selected with the ADIOS_SIMD environment variable, returns
+ * nonzero on any mismatch.
+ */
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "functions/adiosSIMD.h"
+
+namespace
+{
+
+const std::size_t offsets = 4; // unaligned starts, in elements
+const std::size_t patterns = 6;
+
+/** Deterministic values in [-100, 100], [0, 200] for unsigned types */
+template <class T>
+T Value(const std::size_t i)
+{
+    const int value = static_cast<int>((i * 37 + 11) % 201);
+    return std::is_signed<T>::value ? static_cast<T>(value - 100)
+                                    : static_cast<T>(value);
+}
+
+/**
+ * Overwrites values with special cases
+ * @param values
+ * @param size
+ * @param pattern 0: none, 1: limits and infinity, 2: NaN first, 3: NaN last,
+ * 4: NaN middle, 5: all NaN. Integer types get max or lowest for NaN.
+ */
+template <class T>
+void SetPattern(T *values, const std::size_t size, const std::size_t pattern)
+{
+    if (size == 0 || pattern == 0)
+    {
+        return;
+    }
+
+    const bool hasNaN = std::numeric_limits<T>::has_quiet_NaN;
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    switch (pattern)
+    {
+    case 1:
+        values[size / 2] = std::numeric_limits<T>::max();
+        values[size - 1] = std::numeric_limits<T>::lowest();
+        if (std::numeric_limits<T>::has_infinity)
+        {
+            values[0] = std::numeric_limits<T>::infinity();
+        }
+        break;
+    case 2:
+        values[0] = hasNaN ? nan : std::numeric_limits<T>::max();
+        break;
+    case 3:
+        values[size - 1] = hasNaN ? nan : std::numeric_limits<T>::lowest();
+        break;
+    case 4:
+        values[size / 2] = hasNaN ? nan : std::numeric_limits<T>::max();
+        break;
+    case 5:
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = hasNaN ? nan : std::numeric_limits<T>::max();
+        }
+        break;
+    }
+}
+
+template <class T>
+bool Same(const T a, const T b)
+{
+    return a == b || (a != a && b != b);
+}
+
+/**
+ * Moments of values summed in a different order, sums are compared relative
+ * to scale, equal infinite sums (e.g. squares of max) also match
+ */
+bool SameMoments(const adios::Moments &a, const adios::Moments &b,
+                 const double scale)
+{
+    const bool sameSum =
+        a.Sum == b.Sum || std::abs(a.Sum - b.Sum) <= 1e-12 * (scale + 1.);
+    const bool sameSquare =
+        a.SumSquare == b.SumSquare ||
+        std::abs(a.SumSquare - b.SumSquare) <= 1e-12 * (b.SumSquare + 1.);
+    return a.Count == b.Count && a.Finite == b.Finite && sameSum &&
+           sameSquare;
+}
+
+/**
+ * Scalar reference, NaNs are skipped, min and max are NaN only if all values
+ * are NaN, T() if size is 0
+ * @param keys compared values, the squared modulus for complex types
+ * @param moments of the moduli: keys for real types, sqrt(keys) for complex
+ * @param scale sum of the absolute moduli
+ */
+template <class T>
+void ScalarMinMax(const std::vector<T> &keys, const bool isNorm, T &min,
+                  T &max, adios::Moments &moments, double &scale)
+{
+    min = T();
+    max = T();
+    moments = adios::Moments();
+    scale = 0.;
+
+    bool found = false;
+    for (const T key : keys)
+    {
+        const double x = static_cast<double>(key);
+        if (x - x == 0.)
+        {
+            const double modulus = isNorm ? std::sqrt(x) : x;
+            ++moments.Count;
+            moments.Sum += modulus;
+            moments.SumSquare += modulus * modulus;
+            scale += std::abs(modulus);
+        }
+
+        if (key != key)
+        {
+            continue;
+        }
+        if (found == false)
+        {
+            min = key;
+            max = key;
+            found = true;
+        }
+        min = (key < min) ? key : min;
+        max = (key > max) ? key : max;
+    }
+
+    if (found == false && keys.empty() == false)
+    {
+        min = keys[0];
+        max = keys[0];
+    }
+    moments.Finite = (moments.Count == keys.size());
+}
+
+/**
+ * Checks GetMinMax and MemcpyMinMax, with and without moments, on values
+ * against the scalar reference on keys
+ * @return number of mismatches
+ */
+template <class T, class U>
+std::size_t CheckMinMax(const T *values, const std::size_t size,
+                        const std::vector<U> &keys, const bool isNorm)
+{
+    U min, max;
+    adios::Moments moments;
+    double scale;
+    ScalarMinMax(keys, isNorm, min, max, moments, scale);
+    if (isNorm)
+    {
+        min = std::sqrt(min);
+        max = std::sqrt(max);
+    }
+
+    std::size_t errors = 0;
+    U vMin, vMax;
+    adios::Moments vMoments;
+
+    adios::GetMinMax(values, size, vMin, vMax);
+    errors += !Same(vMin, min) || !Same(vMax, max);
+
+    adios::GetMinMax(values, size, vMin, vMax, 1, &vMoments);
+    errors += !Same(vMin, min) || !Same(vMax, max);
+    errors += !SameMoments(vMoments, moments, scale);
+
+    // unaligned destination, guard bytes must not be touched
+    const std::size_t bytes = size * sizeof(T);
+    const char guard = 0x5a;
+    for (const bool withMoments : {false, true})
+    {
+        std::vector<char> destination(bytes + 2, guard);
+        adios::MemcpyMinMax(&destination[1], values, size, vMin, vMax, 1,
+                            withMoments ? &vMoments : nullptr);
+        errors += !Same(vMin, min) || !Same(vMax, max);
+        errors += withMoments && !SameMoments(vMoments, moments, scale);
+        errors += std::memcmp(&destination[1], values, bytes) != 0;
+        errors += destination[0] != guard || destination[bytes + 1] != guard;
+    }
+    return errors;
+}
+
+/** @return number of mismatches of GetInRange against a scalar loop */
+template <class T>
+std::size_t CheckInRange(const T *values, const std::size_t size)
+{
+    const T lo = std::is_signed<T>::value ? static_cast<T>(-20) : T(20);
+    const T hi = std::is_signed<T>::value ? static_cast<T>(30) : T(130);
+
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (values[i] >= lo && values[i] <= hi)
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<std::size_t> positions(size + 1);
+    const std::size_t hits =
+        adios::GetInRange(values, size, lo, hi, positions.data());
+    positions.resize(hits);
+    return (positions != expected) ? 1 : 0;
+}
+
+template <class T>
+std::size_t TestType(const std::string &name)
+{
+    constexpr std::size_t lanes = (64 / sizeof(T) > 0) ? 64 / sizeof(T) : 1;
+    const std::size_t maxSize = 4 * lanes + 1;
+
+    std::size_t errors = 0;
+    std::vector<T> buffer(maxSize + offsets);
+    for (std::size_t size = 0; size <= maxSize; ++size)
+    {
+        for (std::size_t offset = 0; offset < offsets; ++offset)
+        {
+            for (std::size_t pattern = 0; pattern < patterns; ++pattern)
+            {
+                T *values = &buffer[offset];
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    values[i] = Value<T>(i + offset);
+                }
+                SetPattern(values, size, pattern);
+
+                const std::vector<T> keys(values, values + size);
+                const std::size_t caseErrors =
+                    CheckMinMax(values, size, keys, false) +
+                    CheckInRange(values, size);
+                if (caseErrors > 0)
+                {
+                    std::cout << "ERROR: " << name << " size " << size
+                              << " offset " << offset << " pattern "
+                              << pattern << "\n";
+                }
+                errors += caseErrors;
+            }
+        }
+    }
+    return errors;
+}
+
+/** Complex values, min and max are the range of the modulus */
+template <class T>
+std::size_t TestComplex(const std::string &name)
+{
+    constexpr std::size_t lanes = 64 / sizeof(T);
+    const std::size_t maxSize = 4 * lanes + 1;
+
+    std::size_t errors = 0;
+    std::vector<std::complex<T>> buffer(maxSize + offsets);
+    std::vector<T> reals(maxSize);
+    for (std::size_t size = 0; size <= maxSize; ++size)
+    {
+        for (std::size_t offset = 0; offset < offsets; ++offset)
+        {
+            for (std::size_t pattern = 0; pattern < patterns; ++pattern)
+            {
+                if (pattern == 1) // limits overflow the squared modulus
+                {
+                    continue;
+                }
+
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    reals[i] = Value<T>(i + offset);
+                }
+                SetPattern(reals.data(), size, pattern);
+
+                std::complex<T> *values = &buffer[offset];
+                std::vector<T> keys(size);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    values[i] = std::complex<T>(reals[i], Value<T>(i + 7));
+                    keys[i] = values[i].real() * values[i].real() +
+                              values[i].imag() * values[i].imag();
+                }
+
+                const std::size_t caseErrors =
+                    CheckMinMax(values, size, keys, true);
+                if (caseErrors > 0)
+                {
+                    std::cout << "ERROR: " << name << " size " << size
+                              << " offset " << offset << " pattern "
+                              << pattern << "\n";
+                }
+                errors += caseErrors;
+            }
+        }
+    }
+    return errors;
+}
+
+} // end anonymous namespace
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+    std::size_t errors = 0;
+
+    errors += TestType<char>("char");
+    errors += TestType<unsigned char>("unsigned char");
+    errors += TestType<short>("short");
+    errors += TestType<unsigned short>("unsigned short");
+    errors += TestType<int>("int");
+    errors += TestType<unsigned int>("unsigned int");
+    errors += TestType<long int>("long int");
+    errors += TestType<unsigned long int>("unsigned long int");
+    errors += TestType<long long int>("long long int");
+    errors += TestType<unsigned long long int>("unsigned long long int");
+    errors += TestType<float>("float");
+    errors += TestType<double>("double");
+    errors += TestType<long double>("long double");
+    errors += TestComplex<float>("complex<float>");
+    errors += TestComplex<double>("complex<double>");
+    errors += TestComplex<long double>("complex<long double>");
+
+    if (errors > 0)
+    {
+        std::cout << errors << " mismatches against the scalar kernels\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Distributed under the OSI-approved Apache License, Version 2.0.  See
+ * accompanying file Copyright.txt for details.
+ *
+ * TestDirectIO.cpp
+ *
+ * Writes unaligned and aligned buffers with the POSIX transport and
+ * direct_io, then reads the file back. POSIX open and write are replaced in
+ * this executable to check that every O_DIRECT write is aligned and to reject
+ * O_DIRECT at open, at the first write or at a later write, as file systems
+ * without O_DIRECT support do. Returns nonzero if the file content is wrong.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "transport/file/FileDescriptor.h"
+
+namespace
+{
+
+/** where the replaced POSIX calls reject O_DIRECT with EINVAL */
+enum class Reject
+{
+    None,
+    Open,
+    FirstWrite,
+    SecondWrite
+};
+
+Reject rejectAt = Reject::None;
+std::size_t directWrites = 0;    ///< O_DIRECT writes passed to the kernel
+std::size_t unalignedWrites = 0; ///< O_DIRECT writes a file system rejects
+
+const std::size_t alignment = 4096;
+
+} // end anonymous namespace
+
+extern "C" {
+
+int open(const char *pathname, int flags, ...)
+{
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0)
+    {
+        va_list arguments;
+        va_start(arguments, flags);
+        mode = va_arg(arguments, mode_t);
+        va_end(arguments);
+    }
+
+    if ((flags & O_DIRECT) != 0 && rejectAt == Reject::Open)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return static_cast<int>(
+        syscall(SYS_openat, AT_FDCWD, pathname, flags, mode));
+}
+
+ssize_t write(int fd, const void *buf, size_t count)
+{
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags != -1 && (flags & O_DIRECT) != 0)
+    {
+        if ((rejectAt == Reject::FirstWrite && directWrites == 0) ||
+            (rejectAt == Reject::SecondWrite && directWrites == 1))
+        {
+            errno = EINVAL;
+            return -1;
+        }
+
+        const off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (reinterpret_cast<std::uintptr_t>(buf) % alignment != 0 ||
+            count % alignment != 0 || offset % alignment != 0)
+        {
+            ++unalignedWrites;
+        }
+        ++directWrites;
+    }
+    return syscall(SYS_write, fd, buf, count);
+}
+
+} // end extern "C"
+
+namespace
+{
+
+/** Writes with direct_io and checks the file, @return number of errors */
+std::size_t WriteRead(const std::string fileName, const Reject reject)
+{
+    rejectAt = reject;
+    directWrites = 0;
+    unalignedWrites = 0;
+
+    // 5MB + tail, above the 4MB staging buffer
+    std::vector<char> data(5 * 1048576 + 8 * alignment + 123);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<char>((i * 131 + i / 4099) % 251);
+    }
+
+    // page-aligned source, written without staging at the start of the file
+    const std::size_t head = 2 * alignment + 100;
+    void *aligned = nullptr;
+    if (posix_memalign(&aligned, alignment, head) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    std::unique_ptr<char, void (*)(void *)> alignedBuffer(
+        static_cast<char *>(aligned), std::free);
+    std::copy(data.begin(), data.begin() + head, alignedBuffer.get());
+
+    adios::transport::FileDescriptor file(MPI_COMM_SELF, true, true, 65536);
+    file.Open(fileName, "w");
+    const bool openedDirect = file.IsDirectIO();
+
+    std::size_t position = 0;
+    file.Write(alignedBuffer.get(), head);
+    position += head;
+
+    // unaligned sizes from unaligned sources
+    for (const std::size_t size : {std::size_t(1), alignment - 1, alignment,
+                                   std::size_t(5 * 1048576)})
+    {
+        file.Write(&data[position], size);
+        position += size;
+    }
+
+    iovec iov[3];
+    for (iovec &piece : iov)
+    {
+        piece.iov_base = &data[position];
+        piece.iov_len = 1000;
+        position += 1000;
+    }
+    file.WriteV(iov, 3);
+
+    file.Write(&data[position], data.size() - position);
+    file.Close();
+
+    std::size_t errors = 0;
+    std::ifstream in(fileName, std::ios::binary);
+    const std::vector<char> contents((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+    if (contents != data)
+    {
+        std::cout << "ERROR: " << fileName << " content\n";
+        ++errors;
+    }
+
+    if (unalignedWrites > 0)
+    {
+        std::cout << "ERROR: " << fileName << " " << unalignedWrites
+                  << " unaligned O_DIRECT writes\n";
+        ++errors;
+    }
+
+    const bool expectDirect = (reject == Reject::None && openedDirect);
+    if ((expectDirect && directWrites == 0) ||
+        (reject == Reject::Open && (openedDirect || directWrites > 0)) ||
+        (reject == Reject::FirstWrite && directWrites > 0) ||
+        (reject == Reject::SecondWrite && openedDirect && directWrites != 1))
+    {
+        std::cout << "ERROR: " << fileName << " " << directWrites
+                  << " O_DIRECT writes\n";
+        ++errors;
+    }
+    return errors;
+}
+
+} // end anonymous namespace
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+    std::size_t errors = 0;
+
+    try
+    {
+        errors += WriteRead("directIO.bin", Reject::None);
+        errors += WriteRead("directIORejectOpen.bin", Reject::Open);
+        errors += WriteRead("directIORejectFirst.bin", Reject::FirstWrite);
+        errors += WriteRead("directIORejectSecond.bin", Reject::SecondWrite);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        std::cout << "System exception, STOPPING PROGRAM\n";
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << "Exception, STOPPING PROGRAM\n";
+        std::cout << e.what() << "\n";
+        return 1;
+    }
+
+    if (errors > 0)
+    {
+        std::cout << errors << " errors writing with direct_io\n";
+        return 1;
+    }
+
+    return 0;
+}